@@ -0,0 +1,16 @@
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.h"
+
+std::uint64_t g_allocations = 0;
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if(void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+//Every heap allocation of the process, counted by the global operator new of AllocationCounter.cpp.
+//Benches linking tme_allocation_counter read the difference around their timed regions.
+extern std::uint64_t g_allocations;
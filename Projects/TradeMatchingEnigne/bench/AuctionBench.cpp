@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "BenchCommon.h"
+
+//Call auction cost: collecting orders into a crossed book, the clearing price computation(curves built from level totals
+//with vectorized prefix sums) and the allocation pass, timed separately. Every uncross is checked against a brute-force
+//evaluation of the executable volume at every level price and the book must no longer cross afterwards.
+//Usage: tme_auction_bench [max orders] [price levels per side]
+//Runs 1/16, 1/4 and all of max orders, buys and sells priced normally around 2048 with overlapping ranges.
+
+std::vector<BookOrder> generate(std::size_t count, unsigned spread) {
+    std::mt19937_64 rng(SEED);
+    std::normal_distribution<double> offset(0.0, spread / 3.0);
+    std::vector<BookOrder> orders;
+    orders.reserve(count);
+    for(std::size_t i = 0; i < count; ++i) {
+        const char side = (rng() & 1) ? 'B' : 'S';
+        //buyers centred slightly above the mid and sellers slightly below, so the book crosses over a range of prices
+        const double centre = MID_PRICE + ((side == 'B') ? spread / 8.0 : -(spread / 8.0));
+        const unsigned price = static_cast<unsigned>(std::clamp(centre + offset(rng), 1.0, 4096.0));
+        orders.emplace_back(static_cast<unsigned>(1 + rng() % 10000), static_cast<unsigned>(1 + rng() % 500), price, side, static_cast<unsigned>(i + 1));
+    }
+    return orders;
+}
+
+//maximum of min(demand, supply) over every level price, from the resting orders themselves
+template<class Pool>
+std::uint64_t bruteForceVolume(const Pool& pool) {
+    std::map<unsigned, std::uint64_t> bids;
+    std::map<unsigned, std::uint64_t> asks;
+    pool.forEachOrder('B', [&](const BookOrder& order) { bids[order.getPrice()] += order.getQuantity(); });
+    pool.forEachOrder('S', [&](const BookOrder& order) { asks[order.getPrice()] += order.getQuantity(); });
+    std::vector<unsigned> prices;
+    for(const auto& level : bids) prices.push_back(level.first);
+    for(const auto& level : asks) prices.push_back(level.first);
+    std::uint64_t best = 0;
+    for(const unsigned price : prices) {
+        std::uint64_t demand = 0;
+        std::uint64_t supply = 0;
+        for(const auto& level : bids) demand += (level.first >= price) ? level.second : 0;
+        for(const auto& level : asks) supply += (level.first <= price) ? level.second : 0;
+        best = std::max(best, std::min(demand, supply));
+    }
+    return best;
+}
+
+template<class Pool>
+bool measure(const char* backend, const std::vector<BookOrder>& all, std::size_t count) {
+    Pool pool(count);
+    pool.setCallPhase(true);
+    auto start = Clock::now();
+    for(std::size_t i = 0; i < count; ++i) {
+        BookOrder order = all[i];
+        pool.tryExecute(order);
+    }
+    const auto collectNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    const std::uint64_t expectedVolume = bruteForceVolume(pool);
+
+    start = Clock::now();
+    const AuctionResult indicative = pool.indicativeUncross();
+    const auto curveNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    start = Clock::now();
+    const AuctionResult result = pool.uncross();
+    const auto uncrossNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    std::uint64_t bought = 0;
+    std::uint64_t sold = 0;
+    for(const Fill& fill : pool.fills()) {
+        (fill.m_side == 'B' ? bought : sold) += fill.m_quantity;
+    }
+    const BookLevel bestBid = pool.bestBid();
+    const BookLevel bestAsk = pool.bestAsk();
+    const bool isCrossed = bestBid.m_depth.m_orderCount && bestAsk.m_depth.m_orderCount && bestBid.m_price >= bestAsk.m_price;
+    const bool isCorrect = result.m_volume == expectedVolume && indicative.m_price == result.m_price && bought == result.m_volume
+                           && sold == result.m_volume && !isCrossed;
+    std::cout << backend << "\t" << count << "\t" << result.m_levelCount << "\t" << result.m_price << "\t" << result.m_volume << "\t"
+              << result.m_imbalance << "\t" << pool.fills().size() / 2 << "\t" << static_cast<double>(collectNs) / static_cast<double>(count)
+              << "\t" << curveNs << "\t" << (uncrossNs - curveNs) << "\t" << uncrossNs << (isCorrect ? "" : "\tMISMATCH") << std::endl;
+    return isCorrect;
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t maxOrders = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    const unsigned spread = (argc > 2) ? static_cast<unsigned>(std::atoi(argv[2])) : 1000;
+    if(maxOrders < 16 || spread < 8 || spread > 2000) {
+        std::cerr << "Usage: " << argv[0] << " [max orders, at least 16] [price levels per side, 8..2000]\n";
+        return 1;
+    }
+    const std::vector<BookOrder> all = generate(maxOrders, spread);
+    bool isConsistent = true;
+    std::cout << "backend\torders\tcrossed levels\tclearing price\tvolume\timbalance\texecutions\tcollect ns/order\tcurves ns\tallocation ns\tuncross ns\n";
+    for(const std::size_t count : {maxOrders / 16, maxOrders / 4, maxOrders}) {
+        isConsistent &= measure<MapPool>("std_map", all, count);
+        isConsistent &= measure<LadderPool>("ladder", all, count);
+    }
+    return isConsistent ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.h"
+#include "BenchCommon.h"
+
+//tryExecute() one request at a time against tryExecuteBatch() on a book far larger than L2: millions of resting orders,
+//so cancels, amendments and queue joins miss the cache on the order index and on the resting nodes.
+//The per-request loop is run with a clock read around every request(like Extractor with --batch=1) and without.
+//Usage: tme_batch_bench [resting orders] [requests] [batch size]
+
+constexpr unsigned HALF_RANGE = 1024;//resting prices are spread over this many levels per side
+
+struct Workload {
+    std::vector<BookOrder> m_book;//resting orders, none of them crosses
+    std::vector<BookOrder> m_requests;//40% cancels and 10% amendments of random resting orders, 40% passive and 10% aggressive orders
+};
+
+Workload generate(std::size_t restingCount, std::size_t requestCount) {
+    std::mt19937_64 rng(SEED);
+    Workload workload;
+    unsigned orderId = 0;
+    auto passive = [&]() {
+        const char side = (rng() & 1) ? 'B' : 'S';
+        const unsigned offset = 1 + static_cast<unsigned>(rng() % HALF_RANGE);
+        return passiveOrder(side, offset, 1 + static_cast<unsigned>(rng() % 100), ++orderId, 5000);
+    };
+    workload.m_book.reserve(restingCount);
+    for(std::size_t i = 0; i < restingCount; ++i) {
+        workload.m_book.push_back(passive());
+    }
+    workload.m_requests.reserve(requestCount);
+    for(std::size_t i = 0; i < requestCount; ++i) {
+        const unsigned kind = static_cast<unsigned>(rng() % 10);
+        if(kind < 5) {//requests refer to resting orders of the initial book or to passive orders added since
+            const BookOrder& target = (rng() & 1) ? workload.m_book[rng() % workload.m_book.size()] : workload.m_book[workload.m_book.size() - 1 - rng() % 1000];
+            const bool isCancel = kind < 4;
+            workload.m_requests.emplace_back(target.getId(), isCancel ? 0 : std::max(1u, target.getQuantity() / 2), isCancel ? 0 : target.getPrice(),
+                                             isCancel ? 'C' : 'M', target.getOrderId());
+            ++orderId;
+        } else if(kind < 9) {
+            workload.m_requests.push_back(passive());
+        } else {
+            const char side = (rng() & 1) ? 'B' : 'S';
+            ++orderId;
+            workload.m_requests.emplace_back(1 + orderId % 5000, 1 + static_cast<unsigned>(rng() % 300), side == 'B' ? MID_PRICE + 3 : MID_PRICE - 3, side, orderId);
+        }
+    }
+    return workload;
+}
+
+//order of fills and outcomes, equal for every variant when matching stays sequential
+struct Checksum {
+    std::uint64_t m_value = 0;
+    void add(std::uint64_t value) noexcept { m_value = (m_value ^ value) * 0x100000001B3ull; }
+    template<class Pool>
+    void add(const Pool& pool) noexcept {
+        add(static_cast<std::uint64_t>(pool.outcome()));
+        for(const Fill& fill : pool.fills()) {
+            add((std::uint64_t{fill.m_traderId} << 32) | fill.m_quantity);
+            add((std::uint64_t{fill.m_price} << 8) | static_cast<unsigned char>(fill.m_side));
+        }
+    }
+};
+
+template<class Pool>
+bool run(const char* backend, const Workload& workload, std::size_t batchSize) {
+    std::uint64_t checksums[3] = {};
+    double nsPerRequest[3] = {};
+    for(int variant = 0; variant < 3; ++variant) {
+        Pool pool(workload.m_book.size() + workload.m_requests.size());
+        for(BookOrder order : workload.m_book) {
+            pool.tryExecute(order);
+        }
+        std::vector<BookOrder> requests = workload.m_requests;
+        Checksum checksum;
+        Common::LatencyHistogram latency;//per request, batches record their average for each of their requests
+        const auto start = Clock::now();
+        if(variant == 0) {//clock read around every request
+            for(BookOrder& order : requests) {
+                const auto orderStart = Clock::now();
+                pool.tryExecute(order);
+                latency.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - orderStart).count()));
+                checksum.add(pool);
+            }
+        } else if(variant == 1) {
+            for(BookOrder& order : requests) {
+                pool.tryExecute(order);
+                checksum.add(pool);
+            }
+        } else {//clock read around every batch
+            for(std::size_t begin = 0; begin < requests.size(); begin += batchSize) {
+                const std::span<BookOrder> batch = std::span<BookOrder>(requests).subspan(begin, std::min(batchSize, requests.size() - begin));
+                const auto batchStart = Clock::now();
+                pool.tryExecuteBatch(batch, [&](std::size_t) { checksum.add(pool); });
+                const auto batchNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - batchStart).count();
+                for(std::size_t i = 0; i < batch.size(); ++i) {
+                    latency.record(static_cast<std::uint64_t>(batchNs) / batch.size());
+                }
+            }
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        nsPerRequest[variant] = static_cast<double>(elapsed) / static_cast<double>(requests.size());
+        checksums[variant] = checksum.m_value;
+    }
+    const bool isSame = checksums[0] == checksums[1] && checksums[1] == checksums[2];
+    std::cout << backend << "\t" << workload.m_book.size() << "\t" << workload.m_requests.size() << "\t" << batchSize << "\t"
+              << nsPerRequest[0] << "\t" << nsPerRequest[1] << "\t" << nsPerRequest[2] << "\t"
+              << (1.0 - nsPerRequest[2] / nsPerRequest[0]) * 100.0 << "%\t" << (1.0 - nsPerRequest[2] / nsPerRequest[1]) * 100.0 << "%" << (isSame ? "" : "\tMISMATCH") << std::endl;
+    return isSame;
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t restingCount = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    const std::size_t requestCount = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+    const std::size_t batchSize = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 64;
+    if(restingCount < 1000 || !requestCount || !batchSize) {
+        std::cerr << "Usage: " << argv[0] << " [resting orders, at least 1000] [requests] [batch size]\n";
+        return 1;
+    }
+    const Workload workload = generate(restingCount, requestCount);
+    std::cout << "backend\tresting orders\trequests\tbatch\ttimed tryExecute ns\ttryExecute ns\ttimed tryExecuteBatch ns\tgain over timed tryExecute\tgain over tryExecute\n";
+    bool isConsistent = run<MapPool>("std_map", workload, batchSize);
+    isConsistent &= run<LadderPool>("ladder", workload, batchSize);
+    return isConsistent ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "BinaryOrderStream.h"
+#include "OrderPool.h"
+#include "PriceLadder.h"
+#include "WorkloadGenerator.h"
+
+//Shared by the benches: the clock, the two backends most of them compare, the seed every workload is drawn from
+//and the generators of seeded requests.
+
+using Clock = std::chrono::steady_clock;
+using MapPool = OrderPool<std::map<unsigned, OrderLevel, std::greater<unsigned>>, std::map<unsigned, OrderLevel>>;
+using LadderPool = OrderPool<PriceLadder<OrderLevel, std::greater<unsigned>>, PriceLadder<OrderLevel>>;
+
+constexpr std::uint64_t SEED = 20240917;//benches running several workloads draw workload i from SEED + i
+constexpr unsigned MID_PRICE = 2048;//inside the default PriceLadder band 1..4096
+
+//a non-crossing order offset levels away from the mid, on behalf of one of traderCount traders picked by the order id
+inline BookOrder passiveOrder(char side, unsigned offset, unsigned quantity, unsigned orderId, unsigned traderCount) {
+    return BookOrder{1 + orderId % traderCount, quantity, side == 'B' ? MID_PRICE - offset : MID_PRICE + offset, side, orderId};
+}
+
+//the first count requests of a generator profile, order ids from 1
+inline std::vector<BinaryOrderRecord> generateRecords(const WorkloadProfile& profile, std::size_t count, std::uint64_t seed = SEED) {
+    const ZipfSampler traders(profile.m_traderCount, profile.m_zipfExponent);
+    WorkloadGenerator generator(profile, traders, seed, 1, 0);
+    std::vector<BinaryOrderRecord> records;
+    records.reserve(count);
+    for(std::size_t i = 0; i < count; ++i) {
+        records.push_back(generator.next());
+    }
+    return records;
+}
+
+//hand-shaped requests, ids follow the request sequence number like the text input
+class OrderStream {
+public:
+    OrderStream(std::size_t count, std::uint64_t seed) : m_rng(seed) { m_orders.reserve(count); }
+
+    unsigned uniform(unsigned low, unsigned high) { return std::uniform_int_distribution<unsigned>(low, high)(m_rng); }
+    bool chance(double p) { return std::bernoulli_distribution(p)(m_rng); }
+
+    void add(char side, unsigned quantity, unsigned price) {
+        const unsigned orderId = static_cast<unsigned>(m_orders.size() + 1);
+        m_orders.emplace_back(uniform(1, 1000), quantity, price, side, orderId);
+    }
+    //cancel or amend one of the last window requests, on behalf of its owner
+    void addAmendment(char side, std::size_t window, unsigned quantity = 0, unsigned price = 0) {
+        const std::size_t target = m_orders.size() - 1 - uniform(0, static_cast<unsigned>(std::min(window, m_orders.size()) - 1));
+        const BookOrder& order = m_orders[target];
+        m_orders.emplace_back(order.getId(), quantity, price, side, order.getOrderId());
+    }
+    std::size_t size() const noexcept { return m_orders.size(); }
+    std::vector<BookOrder> take() { return std::move(m_orders); }
+
+private:
+    std::mt19937_64 m_rng;
+    std::vector<BookOrder> m_orders;
+};
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <flat_map>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <absl/container/btree_map.h>
+
+#include "AllocationCounter.h"
+#include "BenchCommon.h"
+#include "LevelMaps.h"
+
+//Runs every OrderPool backend over named, seeded workload shapes and emits the results as JSON.
+//Usage: tme_book_bench [orders per scenario] [repetitions] [json output file, stdout by default]
+
+using Orders = std::vector<BookOrder>;
+
+//passive orders only: bids below and asks above the mid, the book gets deep and nothing trades
+Orders deepBuildUp(std::size_t count, std::uint64_t seed) {
+    OrderStream stream(count, seed);
+    while(stream.size() < count) {
+        const bool isBuy = stream.chance(0.5);
+        const unsigned distance = stream.uniform(1, 500);
+        stream.add(isBuy ? 'B' : 'S', stream.uniform(1, 100), isBuy ? MID_PRICE - distance : MID_PRICE + distance);
+    }
+    return stream.take();
+}
+
+//a passive book refilled continuously and hit by large aggressors crossing many levels
+Orders aggressiveSweeps(std::size_t count, std::uint64_t seed) {
+    OrderStream stream(count, seed);
+    while(stream.size() < count) {
+        const bool isBuy = stream.chance(0.5);
+        if(stream.size() > count / 10 && stream.chance(0.2)) {
+            const unsigned through = stream.uniform(5, 40);
+            stream.add(isBuy ? 'B' : 'S', stream.uniform(500, 3000), isBuy ? MID_PRICE + through : MID_PRICE - through);
+        } else {
+            const unsigned distance = stream.uniform(1, 50);
+            stream.add(isBuy ? 'B' : 'S', stream.uniform(1, 100), isBuy ? MID_PRICE - distance : MID_PRICE + distance);
+        }
+    }
+    return stream.take();
+}
+
+//bids only, now and then a sell takes out the top of the book
+Orders oneSidedMarket(std::size_t count, std::uint64_t seed) {
+    OrderStream stream(count, seed);
+    while(stream.size() < count) {
+        if(stream.chance(0.05)) {
+            stream.add('S', stream.uniform(100, 1000), MID_PRICE - 1000);
+        } else {
+            stream.add('B', stream.uniform(1, 100), MID_PRICE - stream.uniform(0, 1000));
+        }
+    }
+    return stream.take();
+}
+
+//a few levels around the mid, many cancels and amendments of recent orders
+Orders narrowSpreadChurn(std::size_t count, std::uint64_t seed) {
+    OrderStream stream(count, seed);
+    while(stream.size() < count) {
+        if(stream.size() > 16 && stream.chance(0.3)) {
+            stream.addAmendment('C', 1000);
+        } else if(stream.size() > 16 && stream.chance(0.1)) {
+            stream.addAmendment('M', 1000, stream.uniform(1, 100), MID_PRICE + stream.uniform(0, 4) - 2);
+        } else {
+            stream.add(stream.chance(0.5) ? 'B' : 'S', stream.uniform(1, 100), MID_PRICE + stream.uniform(0, 4) - 2);
+        }
+    }
+    return stream.take();
+}
+
+//prices spread over the whole band, few orders per level
+Orders wideSparseRange(std::size_t count, std::uint64_t seed) {
+    OrderStream stream(count, seed);
+    while(stream.size() < count) {
+        stream.add(stream.chance(0.5) ? 'B' : 'S', stream.uniform(1, 100), stream.uniform(1, 4096));
+    }
+    return stream.take();
+}
+
+struct Scenario {
+    const char* m_name;
+    Orders (*m_make)(std::size_t, std::uint64_t);
+};
+
+const Scenario SCENARIOS[] = {
+    {"deep_passive_build_up", deepBuildUp},
+    {"aggressive_multi_level_sweeps", aggressiveSweeps},
+    {"one_sided_market", oneSidedMarket},
+    {"narrow_spread_churn", narrowSpreadChurn},
+    {"wide_sparse_prices", wideSparseRange},
+};
+
+struct RunResult {
+    double          m_nsPerOrder;
+    std::uint64_t   m_allocations;
+    std::uint64_t   m_arenaAllocations;//served by the pool's arena, only pmr backends use it
+    std::uint64_t   m_arenaPeakBytes;
+    std::uint64_t   m_fills;
+    std::uint64_t   m_checksum;//same for every backend, differing checksums mean differing matching
+};
+
+template<class MapContBuy, class MapContSell>
+RunResult runOnce(const Orders& orders) {
+    Orders requests = orders;//tryExecute() consumes quantities
+    OrderPool<MapContBuy, MapContSell> pool(requests.size());
+    RunResult result{0, 0, 0, 0, 0, 0};
+    const std::uint64_t allocationsBefore = g_allocations;
+    const auto start = Clock::now();
+    for(BookOrder& order : requests) {
+        pool.tryExecute(order);
+        for(const Fill& fill : pool.fills()) {
+            result.m_checksum = result.m_checksum * 31 + fill.m_traderId * 7 + fill.m_quantity * 3 + fill.m_price;
+        }
+        result.m_fills += pool.fills().size();
+    }
+    const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    result.m_allocations = g_allocations - allocationsBefore;
+    result.m_arenaAllocations = pool.arena().stats().m_allocations;
+    result.m_arenaPeakBytes = pool.arena().stats().m_peakBytes;
+    result.m_nsPerOrder = elapsed / static_cast<double>(requests.size());
+    return result;
+}
+
+struct Backend {
+    const char* m_name;
+    RunResult (*m_run)(const Orders&);
+};
+
+//add new OrderPool instantiations here
+const Backend BACKENDS[] = {
+    {"std_map", runOnce<std::map<unsigned, OrderLevel, std::greater<unsigned>>, std::map<unsigned, OrderLevel>>},
+    {"btree_map", runOnce<absl::btree_map<unsigned, OrderLevel, std::greater<unsigned>>, absl::btree_map<unsigned, OrderLevel>>},
+    {"std::flat_map", runOnce<std::flat_map<unsigned, OrderLevel, std::greater<unsigned>>, std::flat_map<unsigned, OrderLevel>>},
+    {"pmr_std_map", runOnce<PmrStdMap<std::greater<unsigned>>, PmrStdMap<>>},
+    {"pmr_btree_map", runOnce<PmrBtreeMap<std::greater<unsigned>>, PmrBtreeMap<>>},
+    {"pmr_std::flat_map", runOnce<PmrFlatMap<std::greater<unsigned>>, PmrFlatMap<>>},
+    {"ladder", runOnce<PriceLadder<OrderLevel, std::greater<unsigned>>, PriceLadder<OrderLevel>>},
+};
+
+int main(int argc, char* argv[]) {
+    const std::size_t ordersCount = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    const unsigned repetitions = (argc > 2) ? std::atoi(argv[2]) : 5;
+    if(!ordersCount || !repetitions) {
+        std::cerr << "Usage: " << argv[0] << " [orders per scenario] [repetitions] [json output file]\n";
+        return 1;
+    }
+    std::ofstream jsonFile;
+    if(argc > 3) {
+        jsonFile.open(argv[3]);
+        if(!jsonFile) {
+            std::cerr << "Could not open " << argv[3] << "\n";
+            return 1;
+        }
+    }
+    std::ostream& json = (argc > 3) ? jsonFile : std::cout;
+
+    json << "{\n  \"orders_per_scenario\": " << ordersCount << ",\n  \"repetitions\": " << repetitions
+         << ",\n  \"base_seed\": " << SEED << ",\n  \"results\": [";
+    bool isFirst = true;
+    for(std::size_t s = 0; s < std::size(SCENARIOS); ++s) {
+        const Orders orders = SCENARIOS[s].m_make(ordersCount, SEED + s);
+        for(const Backend& backend : BACKENDS) {
+            std::vector<RunResult> runs;
+            for(unsigned r = 0; r < repetitions; ++r) {
+                runs.push_back(backend.m_run(orders));
+            }
+            std::sort(runs.begin(), runs.end(), [](const RunResult& lhs, const RunResult& rhs) { return lhs.m_nsPerOrder < rhs.m_nsPerOrder; });
+            const RunResult& median = runs[runs.size() / 2];
+            const bool isConsistent = std::all_of(runs.begin(), runs.end(), [&](const RunResult& run) { return run.m_checksum == median.m_checksum; });
+            json << (isFirst ? "\n" : ",\n") << "    {\"scenario\": \"" << SCENARIOS[s].m_name << "\", \"backend\": \"" << backend.m_name
+                 << "\", \"ns_per_order\": " << median.m_nsPerOrder << ", \"min_ns_per_order\": " << runs.front().m_nsPerOrder
+                 << ", \"max_ns_per_order\": " << runs.back().m_nsPerOrder << ", \"orders_per_sec\": " << 1e9 / median.m_nsPerOrder
+                 << ", \"allocations_per_order\": " << static_cast<double>(median.m_allocations) / static_cast<double>(orders.size())
+                 << ", \"arena_allocations_per_order\": " << static_cast<double>(median.m_arenaAllocations) / static_cast<double>(orders.size())
+                 << ", \"arena_peak_bytes\": " << median.m_arenaPeakBytes
+                 << ", \"fills\": " << median.m_fills << ", \"checksum\": " << median.m_checksum
+                 << ", \"consistent\": " << (isConsistent ? "true" : "false") << "}";
+            isFirst = false;
+            std::cerr << SCENARIOS[s].m_name << '\t' << backend.m_name << '\t' << median.m_nsPerOrder << " ns/order\t"
+                      << static_cast<double>(median.m_allocations) / static_cast<double>(orders.size()) << " allocs/order" << std::endl;
+        }
+    }
+    json << "\n  ]\n}\n";
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "BenchCommon.h"
+
+//Cost of the L2 depth queries of OrderPool against the depth of the book, plus a check that the level totals
+//maintained on every add, fill, amendment and cancel match the resting orders after long seeded workloads.
+//Usage: tme_depth_bench [queries per measurement] [orders per level]
+//Books have 16 to 2000 levels per side around price 2048, inside the default PriceLadder band.
+
+constexpr std::size_t TOP_LEVELS = 10;
+constexpr std::size_t WORKLOAD_REQUESTS = 1000000;
+
+//true if every level total equals the sum over the level's orders
+template<class Pool>
+bool isDepthConsistent(const Pool& pool) {
+    for(const char side : {'B', 'S'}) {
+        std::map<unsigned, LevelDepth> walked;
+        pool.forEachOrder(side, [&](const BookOrder& order) {
+            LevelDepth& depth = walked[order.getPrice()];
+            depth.m_quantity += order.getQuantity();
+            ++depth.m_orderCount;
+        });
+        std::size_t levels = 0;
+        bool isSame = true;
+        pool.forEachLevel(side, [&](unsigned price, const LevelDepth& depth) {
+            const auto it = walked.find(price);
+            isSame &= (it != walked.end() && it->second.m_quantity == depth.m_quantity && it->second.m_orderCount == depth.m_orderCount);
+            ++levels;
+        });
+        if(!isSame || levels != walked.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<class Pool>
+bool checkWorkload(const char* backend, const char* profileName) {
+    WorkloadProfile profile;
+    WorkloadProfile::byName(profileName, profile);
+    Pool pool(WORKLOAD_REQUESTS);
+    for(const BinaryOrderRecord& record : generateRecords(profile, WORKLOAD_REQUESTS)) {
+        BookOrder order = record.toOrder();
+        pool.tryExecute(order);
+    }
+    const bool isConsistent = isDepthConsistent(pool);
+    std::cout << "consistency\t" << backend << "\t" << profileName << "\t" << WORKLOAD_REQUESTS << " requests\t"
+              << pool.nodePool().inUse() << " resting orders\t" << (isConsistent ? "ok" : "MISMATCH") << std::endl;
+    return isConsistent;
+}
+
+//ns per call of query(i) over the pre-drawn prices
+template<class Query>
+double timeQueries(std::size_t queries, Query&& query) {
+    const auto start = Clock::now();
+    for(std::size_t i = 0; i < queries; ++i) {
+        query(i);
+    }
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()) / static_cast<double>(queries);
+}
+
+template<class Pool>
+void measure(const char* backend, unsigned levelsPerSide, unsigned ordersPerLevel, std::size_t queries) {
+    Pool pool(2 * static_cast<std::size_t>(levelsPerSide) * ordersPerLevel);
+    std::mt19937_64 rng(SEED);
+    unsigned orderId = 0;
+    for(unsigned level = 1; level <= levelsPerSide; ++level) {
+        for(unsigned i = 0; i < ordersPerLevel; ++i) {
+            for(const char side : {'B', 'S'}) {
+                BookOrder order = passiveOrder(side, level, 1 + static_cast<unsigned>(rng() % 100), ++orderId, 1000);
+                pool.tryExecute(order);
+            }
+        }
+    }
+    std::vector<unsigned> offsets(queries);
+    for(unsigned& offset : offsets) {
+        offset = 1 + static_cast<unsigned>(rng() % levelsPerSide);
+    }
+    std::uint64_t sink = 0;
+    const double atPrice = timeQueries(queries, [&](std::size_t i) {
+        sink += pool.levelDepth((i & 1) ? 'S' : 'B', (i & 1) ? MID_PRICE + offsets[i] : MID_PRICE - offsets[i]).m_quantity;
+    });
+    const double best = timeQueries(queries, [&](std::size_t) {
+        sink += pool.bestBid().m_depth.m_quantity + pool.bestAsk().m_depth.m_quantity;
+    });
+    std::array<BookLevel, TOP_LEVELS> top;
+    const double topN = timeQueries(queries, [&](std::size_t i) {
+        sink += pool.topLevels((i & 1) ? 'S' : 'B', top);
+    });
+    const double upTo = timeQueries(queries, [&](std::size_t i) {
+        sink += pool.depthUpTo((i & 1) ? 'S' : 'B', (i & 1) ? MID_PRICE + offsets[i] : MID_PRICE - offsets[i]).m_quantity;
+    });
+    std::cout << backend << "\t" << levelsPerSide << "\t" << ordersPerLevel << "\t" << atPrice << "\t" << best << "\t"
+              << topN << "\t" << upTo << "\t" << (sink & 1) << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t queries = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const unsigned ordersPerLevel = (argc > 2) ? static_cast<unsigned>(std::atoi(argv[2])) : 8;
+    if(!queries || !ordersPerLevel) {
+        std::cerr << "Usage: " << argv[0] << " [queries per measurement] [orders per level]\n";
+        return 1;
+    }
+    bool isConsistent = true;
+    for(const char* profileName : {"balanced", "passive", "aggressive"}) {
+        isConsistent &= checkWorkload<MapPool>("std_map", profileName);
+        isConsistent &= checkWorkload<LadderPool>("ladder", profileName);
+    }
+    std::cout << "backend\tlevels per side\torders per level\tlevelDepth ns\tbestBid+bestAsk ns\ttopLevels(" << TOP_LEVELS
+              << ") ns\tdepthUpTo ns\t(sink)\n";
+    for(const unsigned levels : {16u, 128u, 1024u, 2000u}) {
+        measure<MapPool>("std_map", levels, ordersPerLevel, queries);
+        measure<LadderPool>("ladder", levels, ordersPerLevel, queries);
+    }
+    return isConsistent ? 0 : 1;
+}
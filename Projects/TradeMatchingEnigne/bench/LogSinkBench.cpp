@@ -0,0 +1,135 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "LogSink.h"
+#include "Logger.h"
+
+//Steady-state log throughput in MB/s: std::ofstream(the former Logger output) against the writev and mmap sinks under
+//the fsync policies, then the whole Logger(producer, formatting thread and sink) for each sink.
+//Usage: tme_log_sink_bench [MiB per run] [output directory]
+//The first tenth of every sink run is a warm-up and isn't timed. Files rotate every 64 MiB and are removed afterwards.
+
+using Clock = std::chrono::steady_clock;
+namespace fs = std::filesystem;
+
+constexpr std::size_t ROTATE_BYTES = 64 * 1024 * 1024;
+constexpr unsigned KEPT_FILES = 16;//every byte written stays on disk until the run is measured
+constexpr std::size_t LINE_VARIANTS = 1024;
+constexpr std::size_t OFSTREAM_FLUSH_LINES = 1000;
+
+std::vector<std::string> makeLines() {
+    std::vector<std::string> lines;
+    for(std::size_t i = 0; i < LINE_VARIANTS; ++i) {
+        lines.push_back("12:00:00." + std::to_string(100000000 + i * 7919) + " Order " + std::to_string(i * 104729)
+                        + " from T" + std::to_string(i % 977) + " filled " + std::to_string(i % 300) + " @ "
+                        + std::to_string(2000 + i % 97) + ", book depth " + std::to_string(i % 61) + "\n");
+    }
+    return lines;
+}
+
+void removeLogs(const fs::path& file) {
+    fs::remove(file);
+    for(unsigned i = 1; i <= KEPT_FILES; ++i) {
+        fs::remove(file.string() + "." + std::to_string(i));
+    }
+}
+
+double toMBps(std::size_t bytes, Clock::duration elapsed) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0) / std::chrono::duration<double>(elapsed).count();
+}
+
+//writes lines until totalBytes, times the part after the warm-up
+template<class Append>
+double timedRun(const std::vector<std::string>& lines, std::size_t totalBytes, Append&& append) {
+    std::size_t written = 0;
+    std::size_t i = 0;
+    for(; written < totalBytes / 10; ++i) {
+        written += append(lines[i % LINE_VARIANTS], i);
+    }
+    const std::size_t warmUp = written;
+    const auto start = Clock::now();
+    for(; written < totalBytes; ++i) {
+        written += append(lines[i % LINE_VARIANTS], i);
+    }
+    return toMBps(written - warmUp, Clock::now() - start);
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t megabytes = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 256;
+    const fs::path directory = (argc > 2) ? argv[2] : ".";
+    if(!megabytes || !fs::is_directory(directory)) {
+        std::cerr << "Usage: " << argv[0] << " [MiB per run] [output directory]\n";
+        return 1;
+    }
+    const std::size_t totalBytes = megabytes * 1024 * 1024;
+    const std::vector<std::string> lines = makeLines();
+    const fs::path file = directory / "tme_log_sink_bench.log";
+
+    {
+        std::ofstream stream(file);
+        const double mbps = timedRun(lines, totalBytes, [&](const std::string& line, std::size_t i) {
+            stream << line;
+            if(i % OFSTREAM_FLUSH_LINES == 0) {
+                stream.flush();
+            }
+            return line.size();
+        });
+        std::cout << "ofstream\tfsync: never\t" << mbps << " MB/s\n";
+    }
+    removeLogs(file);
+
+    struct {
+        const char* m_name;
+        Common::LogSinkMode m_mode;
+    } const modes[] = {{"writev", Common::LogSinkMode::WRITEV}, {"mmap", Common::LogSinkMode::MMAP}};
+    const char* const policies[] = {"never", "rotate", "interval", "flush"};
+
+    for(const auto& mode : modes) {
+        for(const char* policyName : policies) {
+            Common::LogSinkConfig config{.m_fileName = file.string(), .m_mode = mode.m_mode, .m_rotateBytes = ROTATE_BYTES, .m_keptFiles = KEPT_FILES};
+            Common::fsyncPolicyByName(policyName, config.m_fsync);
+            const auto start = Clock::now();
+            double mbps;
+            {
+                Common::LogSink sink(config);
+                mbps = timedRun(lines, totalBytes, [&](const std::string& line, std::size_t i) {
+                    sink.append(line);
+                    if(i % OFSTREAM_FLUSH_LINES == 0) {//the Logger flushes whenever it runs out of records
+                        sink.flush();
+                    }
+                    return line.size();
+                });
+            }
+            std::cout << mode.m_name << "\tfsync: " << policyName << "\t" << mbps << " MB/s\tincluding close: "
+                      << toMBps(totalBytes, Clock::now() - start) << " MB/s\n";
+            removeLogs(file);
+        }
+    }
+
+    //end to end: records are produced on this thread and formatted into the sink on the Logger thread
+    for(const auto& mode : modes) {
+        const Common::LogSinkConfig config{.m_fileName = file.string(), .m_mode = mode.m_mode, .m_rotateBytes = ROTATE_BYTES, .m_keptFiles = KEPT_FILES};
+        auto logger = std::make_unique<Common::Logger>(config);
+        const auto start = Clock::now();//after the start-up of the Logger thread
+        for(std::uint64_t i = 0, bytes = 0; bytes < totalBytes; ++i) {
+            logger->log("Order % from T% filled % @ %, book depth %\n", i * 104729, i % 977, i % 300, 2000 + i % 97, i % 61);
+            bytes += 64;//approximate, the exact size is summed from the files below
+        }
+        logger.reset();
+        const auto elapsed = Clock::now() - start;
+        std::size_t bytes = fs::file_size(file);
+        for(unsigned i = 1; i <= config.m_keptFiles && fs::exists(file.string() + "." + std::to_string(i)); ++i) {
+            bytes += fs::file_size(file.string() + "." + std::to_string(i));
+        }
+        std::cout << "Logger+" << mode.m_name << "\t" << toMBps(bytes, elapsed) << " MB/s of formatted output, including drain\n";
+        removeLogs(file);
+    }
+    return 0;
+}
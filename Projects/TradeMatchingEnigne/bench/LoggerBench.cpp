@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "LatencyHistogram.h"
+#include "LegacyLogger.h"
+#include "Logger.h"
+
+//Cost of a log() call on the calling thread: the character-per-slot legacy Logger against the record-based Logger.
+//Usage: tme_logger_bench [calls per message shape]
+//Each call is timed alone, so the percentiles include the ~20ns of the two clock reads; the mean comes from one
+//timer around the whole loop.
+
+using Clock = std::chrono::steady_clock;
+
+const std::string TRADER = "trader-0042";
+
+template<class L>
+void logNumbers(L& logger, std::uint64_t i) {
+    logger.log("Order % filled % @ % remaining %\n", i, static_cast<unsigned>(i & 0xFFF), 2048u, static_cast<int>(i % 7));
+}
+
+template<class L>
+void logText(L& logger, std::uint64_t i) {
+    logger.log("Trader % sent order %, side %, debug %\n", TRADER, i, 'B', (i & 1) == 0);
+}
+
+template<class L>
+void logLiteral(L& logger, std::uint64_t) {
+    logger.log("Book rebuilt after the opening auction.\n");
+}
+
+template<class L>
+void run(const char* loggerName, const std::string& fileName, std::uint64_t calls) {
+    const auto loggerStart = Clock::now();
+    auto logger = std::make_unique<L>(fileName);
+    struct {
+        const char* m_name;
+        void (*m_call)(L&, std::uint64_t);
+    } const shapes[] = {{"numbers", logNumbers<L>}, {"string_and_numbers", logText<L>}, {"literal", logLiteral<L>}};
+
+    for(const auto& shape : shapes) {
+        Common::LatencyHistogram perCall;
+        for(std::uint64_t i = 0; i < calls; ++i) {
+            const auto start = Clock::now();
+            shape.m_call(*logger, i);
+            perCall.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+        }
+        const auto start = Clock::now();
+        for(std::uint64_t i = 0; i < calls; ++i) {
+            shape.m_call(*logger, i);
+        }
+        const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        std::cout << loggerName << '\t' << shape.m_name << "\tmean(ns/call): " << elapsed / static_cast<double>(calls) << '\t';
+        perCall.print(std::cout, "per call(ns)");
+    }
+    logger.reset();
+    std::cout << loggerName << "\ttotal including drain(ms): "
+              << std::chrono::duration<double, std::milli>(Clock::now() - loggerStart).count() << '\n';
+}
+
+int main(int argc, char* argv[]) {
+    const std::uint64_t calls = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    if(!calls) {
+        std::cerr << "Usage: " << argv[0] << " [calls per message shape]\n";
+        return 1;
+    }
+    run<Common::Legacy::Logger>("legacy", "tme_logger_bench_legacy.log", calls);
+    run<Common::Logger>("record", "tme_logger_bench_record.log", calls);
+    return 0;
+}
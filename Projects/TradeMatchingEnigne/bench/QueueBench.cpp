@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LFQueue.h"
+#include "MPSCRing.h"
+#include "SPSCRing.h"
+#include "ThreadUtils.h"
+
+//Throughput and round-trip latency of Common::LFQueue against SPSCRing and MPSCRing.
+//Items are 64 bit sequence numbers, the consumer checks that every producer's items arrive in order.
+constexpr std::size_t QUEUE_SIZE = 64 * 1024;
+constexpr std::size_t BATCH_SIZE = 64;
+constexpr unsigned PRODUCER_SHIFT = 56;//producer index in the top byte of an item
+
+struct LFQueueAdapter {
+    Common::LFQueue<std::uint64_t> m_queue{QUEUE_SIZE};
+    bool push(std::uint64_t value) {
+        if(m_queue.size() >= m_queue.capacity()) {
+            return false;
+        }
+        *m_queue.getNextToWriteTo() = value;
+        m_queue.updateWriteIndex();
+        return true;
+    }
+    bool pop(std::uint64_t& value) {
+        const std::uint64_t* next = m_queue.getNextToRead();
+        if(!next) {
+            return false;
+        }
+        value = *next;
+        m_queue.updateReadIndex();
+        return true;
+    }
+};
+
+template<class Ring>
+struct RingAdapter {
+    Ring m_queue{QUEUE_SIZE};
+    bool push(std::uint64_t value) { return m_queue.tryPush(value); }
+    bool pop(std::uint64_t& value) { return m_queue.tryPop(value); }
+};
+
+//same ring, moved BATCH_SIZE items per call
+template<class Ring>
+struct BatchRingAdapter : RingAdapter<Ring> {
+    static constexpr bool IS_BATCHED = true;
+};
+
+template<class Q>
+concept Batched = requires { Q::IS_BATCHED; };
+
+void pinCurrentThread(int core) {
+    if(core >= 0 && core < static_cast<int>(std::thread::hardware_concurrency())) {
+        Common::setThreadCore(core);
+    }
+}
+
+void produce(auto& queue, std::uint64_t producer, std::uint64_t count) {
+    unsigned spins = 0;
+    if constexpr(Batched<std::remove_reference_t<decltype(queue)>>) {
+        std::uint64_t batch[BATCH_SIZE];
+        for(std::uint64_t i = 0; i < count;) {
+            const std::size_t n = std::min<std::uint64_t>(BATCH_SIZE, count - i);
+            for(std::size_t k = 0; k < n; ++k) {
+                batch[k] = (producer << PRODUCER_SHIFT) | (i + k);
+            }
+            for(std::size_t pushed = 0; pushed < n;) {
+                const std::size_t step = queue.m_queue.tryPushN(batch + pushed, n - pushed);
+                pushed += step;
+                if(!step) {
+                    Common::spinWait(spins);
+                }
+            }
+            i += n;
+        }
+    } else {
+        for(std::uint64_t i = 0; i < count; ++i) {
+            while(!queue.push((producer << PRODUCER_SHIFT) | i)) {
+                Common::spinWait(spins);
+            }
+        }
+    }
+}
+
+//returns false when an item arrives out of order
+bool consume(auto& queue, unsigned producers, std::uint64_t count) {
+    std::vector<std::uint64_t> expected(producers, 0);
+    unsigned spins = 0;
+    auto check = [&](std::uint64_t item) {
+        const std::uint64_t producer = item >> PRODUCER_SHIFT;
+        if(producer >= producers || (item & ((1ull << PRODUCER_SHIFT) - 1)) != expected[producer]) {
+            return false;
+        }
+        ++expected[producer];
+        return true;
+    };
+    const std::uint64_t total = count * producers;
+    if constexpr(Batched<std::remove_reference_t<decltype(queue)>>) {
+        std::uint64_t batch[BATCH_SIZE];
+        for(std::uint64_t received = 0; received < total;) {
+            const std::size_t n = queue.m_queue.tryPopN(batch, BATCH_SIZE);
+            if(!n) {
+                Common::spinWait(spins);
+                continue;
+            }
+            for(std::size_t k = 0; k < n; ++k) {
+                if(!check(batch[k])) {
+                    return false;
+                }
+            }
+            received += n;
+        }
+    } else {
+        std::uint64_t item;
+        for(std::uint64_t received = 0; received < total;) {
+            if(!queue.pop(item)) {
+                Common::spinWait(spins);
+                continue;
+            }
+            if(!check(item)) {
+                return false;
+            }
+            ++received;
+        }
+    }
+    return true;
+}
+
+template<class Q>
+void throughput(const std::string& name, unsigned producers, std::uint64_t count, int firstCore) {
+    auto queue = std::make_unique<Q>();
+    bool isOrdered = true;
+    const auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&]() {
+        pinCurrentThread(firstCore);
+        isOrdered = consume(*queue, producers, count);
+    });
+    std::vector<std::thread> producerThreads;
+    for(unsigned p = 0; p < producers; ++p) {
+        producerThreads.emplace_back([&, p]() {
+            pinCurrentThread(firstCore < 0 ? -1 : firstCore + 1 + static_cast<int>(p));
+            produce(*queue, p, count);
+        });
+    }
+    for(auto& t : producerThreads) {
+        t.join();
+    }
+    consumer.join();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << "\tproducers: " << producers << "\t" << static_cast<std::uint64_t>(static_cast<double>(count * producers) / elapsed.count())
+              << " items/s" << (isOrdered ? "" : "\tOUT OF ORDER") << std::endl;
+}
+
+//ping-pong over two queues of the same type, reports round-trip percentiles
+template<class Q>
+void latency(const std::string& name, std::uint64_t roundTrips, int firstCore) {
+    auto ping = std::make_unique<Q>();
+    auto pong = std::make_unique<Q>();
+    std::thread echo([&]() {
+        pinCurrentThread(firstCore);
+        std::uint64_t item;
+        unsigned spins = 0;
+        for(std::uint64_t i = 0; i < roundTrips; ++i) {
+            while(!ping->pop(item)) {
+                Common::spinWait(spins);
+            }
+            while(!pong->push(item)) {
+                Common::spinWait(spins);
+            }
+        }
+    });
+    pinCurrentThread(firstCore < 0 ? -1 : firstCore + 1);
+    std::vector<std::uint64_t> samples;
+    samples.reserve(roundTrips);
+    std::uint64_t item;
+    unsigned spins = 0;
+    for(std::uint64_t i = 0; i < roundTrips; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        while(!ping->push(i)) {
+            Common::spinWait(spins);
+        }
+        while(!pong->pop(item)) {
+            Common::spinWait(spins);
+        }
+        samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+    echo.join();
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) { return samples[static_cast<std::size_t>(p * static_cast<double>(samples.size() - 1))]; };
+    std::cout << name << "\tround trip(ns) p50: " << percentile(0.5) << " p99: " << percentile(0.99) << " p99.9: " << percentile(0.999)
+              << " max: " << samples.back() << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    const std::uint64_t count = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+    const std::uint64_t roundTrips = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 200000;
+    const int firstCore = (argc > 3) ? std::atoi(argv[3]) : -1;
+    if(!count || !roundTrips) {
+        std::cerr << "Usage: " << argv[0] << " [items per producer] [round trips] [first core, -1 disables pinning]\n";
+        return 1;
+    }
+    using SPSC = Common::SPSCRing<std::uint64_t>;
+    using MPSC = Common::MPSCRing<std::uint64_t>;
+    std::cout << "queue size: " << QUEUE_SIZE << " items per producer: " << count << " hardware threads: " << std::thread::hardware_concurrency() << '\n';
+    throughput<LFQueueAdapter>("LFQueue", 1, count, firstCore);
+    throughput<RingAdapter<SPSC>>("SPSCRing", 1, count, firstCore);
+    throughput<BatchRingAdapter<SPSC>>("SPSCRing x" + std::to_string(BATCH_SIZE), 1, count, firstCore);
+    throughput<RingAdapter<MPSC>>("MPSCRing", 1, count, firstCore);
+    throughput<BatchRingAdapter<MPSC>>("MPSCRing x" + std::to_string(BATCH_SIZE), 1, count, firstCore);
+    throughput<RingAdapter<MPSC>>("MPSCRing", 2, count / 2, firstCore);
+    throughput<RingAdapter<MPSC>>("MPSCRing", 4, count / 4, firstCore);
+    latency<LFQueueAdapter>("LFQueue", roundTrips, firstCore);
+    latency<RingAdapter<SPSC>>("SPSCRing", roundTrips, firstCore);
+    latency<RingAdapter<MPSC>>("MPSCRing", roundTrips, firstCore);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "PriceLadder.h"
+#include "ShardedEngine.h"
+
+//Throughput of ShardedEngine for a uniform mix of instruments over 1..N shards.
+//Orders are generated in memory upfront and trades go to /dev/null, so only routing, matching and reporting are measured.
+using BenchEngine = ShardedEngine<PriceLadder<OrderLevel, std::greater<unsigned>>, PriceLadder<OrderLevel>>;
+
+struct BenchOrder {
+    std::uint16_t   m_instrument;
+    BookOrder       m_order;
+};
+
+std::vector<BenchOrder> generateOrders(InstrumentRouter& router, unsigned ordersCount, unsigned symbolCount) {
+    std::mt19937 rng(42);
+    std::vector<std::uint16_t> instruments;
+    for(unsigned i = 0; i < symbolCount; ++i) {
+        instruments.push_back(router.intern("SYM" + std::to_string(i)));
+    }
+    std::vector<BenchOrder> orders;
+    orders.reserve(ordersCount);
+    for(unsigned i = 0; i < ordersCount; ++i) {
+        const unsigned randNumber = rng();
+        orders.push_back(BenchOrder{instruments[randNumber % symbolCount],
+            BookOrder(randNumber % 97 + 4, (randNumber >> 8) % 89 + 16, (randNumber >> 16) % 91 + 9, ((randNumber >> 24) % 2) ? 'B' : 'S', i + 1)});
+    }
+    return orders;
+}
+
+double runOnce(const InstrumentRouter& router, const std::vector<BenchOrder>& orders, std::size_t shardCount, int firstCore, int outputFd) {
+    BenchEngine engine(shardCount, firstCore, router, outputFd);
+    const auto start = std::chrono::steady_clock::now();
+    for(const BenchOrder& order : orders) {
+        engine.submit(order.m_instrument, order.m_order);
+    }
+    engine.finish();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(orders.size()) / elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+    const unsigned ordersCount = (argc > 1) ? std::atoi(argv[1]) : 2000000;
+    const unsigned symbolCount = (argc > 2) ? std::atoi(argv[2]) : 64;
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t maxShards = (argc > 3) ? std::atoi(argv[3]) : std::max(1u, cores - 1);//one core is left to the producer
+    const int firstCore = (argc > 4) ? std::atoi(argv[4]) : 1;
+    if(!ordersCount || !symbolCount || !maxShards) {
+        std::cerr << "Usage: " << argv[0] << " [orders] [symbols] [max shards] [first core, -1 disables pinning]\n";
+        return 1;
+    }
+    const int outputFd = ::open("/dev/null", O_WRONLY);
+    if(outputFd < 0) {
+        std::cerr << "Could not open /dev/null\n";
+        return 1;
+    }
+    InstrumentRouter router;
+    const std::vector<BenchOrder> orders = generateOrders(router, ordersCount, symbolCount);
+    std::cout << "orders: " << ordersCount << " symbols: " << symbolCount << " hardware threads: " << cores << '\n';
+    std::cout << "shards\torders/s\tspeedup\n";
+    double baseline = 0;
+    for(std::size_t shards = 1; shards <= maxShards; ++shards) {
+        const double rate = runOnce(router, orders, shards, firstCore, outputFd);
+        if(shards == 1) {
+            baseline = rate;
+        }
+        std::cout << shards << '\t' << static_cast<std::uint64_t>(rate) << '\t' << rate / baseline << std::endl;
+    }
+    ::close(outputFd);
+    return 0;
+}
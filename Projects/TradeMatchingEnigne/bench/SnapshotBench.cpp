@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BenchCommon.h"
+#include "BookSnapshot.h"
+
+//Restart cost of a book: replaying the whole request history through tryExecute() against loading a snapshot of the
+//same book(mmap + restoreOrder() of every resting order). The replay runs on pre-generated binary records without
+//parsing or trade output, so it is a lower bound of what Extractor::process() would take.
+//Usage: tme_snapshot_bench [max requests] [snapshot directory]
+//Runs 1/16, 1/4 and all of max requests of the "passive" profile(deep books) and of the "balanced" one.
+
+using Pool = MapPool;
+namespace fs = std::filesystem;
+
+//both sides, every order in queue order
+std::vector<BinaryOrderRecord> flatten(const Pool& pool) {
+    std::vector<BinaryOrderRecord> orders;
+    for(const char side : {'B', 'S'}) {
+        pool.forEachOrder(side, [&](const BookOrder& order) { orders.push_back(BinaryOrderRecord::fromOrder(order)); });
+    }
+    return orders;
+}
+
+bool isSameBook(const std::vector<BinaryOrderRecord>& lhs, const std::vector<BinaryOrderRecord>& rhs) {
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](const BinaryOrderRecord& a, const BinaryOrderRecord& b) {
+        return a.m_orderId == b.m_orderId && a.m_traderId == b.m_traderId && a.m_quantity == b.m_quantity && a.m_price == b.m_price && a.m_side == b.m_side;
+    });
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t maxRequests = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    const fs::path directory = (argc > 2) ? argv[2] : ".";
+    if(maxRequests < 16 || !fs::is_directory(directory)) {
+        std::cerr << "Usage: " << argv[0] << " [max requests, at least 16] [snapshot directory]\n";
+        return 1;
+    }
+    const std::string path = (directory / "tme_snapshot_bench.snap").string();
+    auto writer = std::make_unique<BookSnapshotWriter>(path);
+    bool isConsistent = true;
+    std::cout << "profile\trequests\tresting orders\tsnapshot bytes\treplay ns\tload ns\tspeedup\tcapture ns\twrite ns\n";
+    for(const char* profileName : {"passive", "balanced"}) {
+        WorkloadProfile profile;
+        WorkloadProfile::byName(profileName, profile);
+        const std::vector<BinaryOrderRecord> all = generateRecords(profile, maxRequests);
+        for(const std::size_t requests : {maxRequests / 16, maxRequests / 4, maxRequests}) {
+            Pool replayed(requests);
+            auto start = Clock::now();
+            for(std::size_t i = 0; i < requests; ++i) {
+                BookOrder order = all[i].toOrder();
+                replayed.tryExecute(order);
+            }
+            const auto replayTime = Clock::now() - start;
+
+            const Common::Nanos captureStart = Common::getCurrentNanos();
+            writer->capture(replayed, requests);
+            const Common::Nanos captureTime = Common::getCurrentNanos() - captureStart;
+            writer->wait();
+            const Common::Nanos writeTime = Common::getCurrentNanos() - captureStart - captureTime;
+
+            start = Clock::now();
+            Pool loaded(replayed.nodePool().inUse());
+            {
+                BookSnapshotReader reader(path);
+                if(!reader.good() || !reader.restore(loaded)) {
+                    std::cerr << "Could not load " << path << ": " << reader.error() << "\n";
+                    return 1;
+                }
+            }
+            const auto loadTime = Clock::now() - start;
+
+            const bool isSame = isSameBook(flatten(replayed), flatten(loaded));
+            isConsistent &= isSame;
+            const auto replayNs = std::chrono::duration_cast<std::chrono::nanoseconds>(replayTime).count();
+            const auto loadNs = std::chrono::duration_cast<std::chrono::nanoseconds>(loadTime).count();
+            std::cout << profileName << "\t" << requests << "\t" << replayed.nodePool().inUse() << "\t" << fs::file_size(path) << "\t"
+                      << replayNs << "\t" << loadNs << "\t" << (loadNs ? static_cast<double>(replayNs) / static_cast<double>(loadNs) : 0.0)
+                      << "x\t" << captureTime << "\t" << writeTime << (isSame ? "" : "\tMISMATCH") << std::endl;
+        }
+    }
+    writer.reset();
+    fs::remove(path);
+    return isConsistent ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "AllocationCounter.h"
+#include "BenchCommon.h"
+#include "TraderRegistry.h"
+
+//Trader id interning: TraderRegistry against an unordered_map of strings over a million distinct alphanumeric identifiers.
+//Warm-up interns every identifier once, then random identifiers are looked up straight from the input buffer and
+//random ids are turned back into names, as TradeReporter does. Allocations of every phase are counted.
+//Usage: tme_trader_bench [distinct traders] [lookups]
+
+struct Workload {
+    std::string                     m_buffer;//identifiers separated by spaces, like trader fields of an input file
+    std::vector<std::string_view>   m_names;//into m_buffer
+    std::vector<std::uint32_t>      m_lookups;//indexes of m_names
+};
+
+Workload generate(std::size_t traderCount, std::size_t lookupCount) {
+    static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    std::mt19937_64 rng(SEED);
+    Workload workload;
+    std::vector<std::size_t> offsets;
+    offsets.reserve(traderCount);
+    for(std::size_t i = 0; i < traderCount; ++i) {
+        offsets.push_back(workload.m_buffer.size());
+        workload.m_buffer += "TRD";//base 62 index keeps the names distinct, random characters vary their length
+        for(std::size_t index = i; index; index /= 62) {
+            workload.m_buffer += ALPHABET[index % 62];
+        }
+        workload.m_buffer += '_';
+        for(std::size_t extra = rng() % 8; extra; --extra) {
+            workload.m_buffer += ALPHABET[rng() % 62];
+        }
+        workload.m_buffer += ' ';
+    }
+    for(std::size_t i = 0; i < traderCount; ++i) {
+        const std::size_t end = workload.m_buffer.find(' ', offsets[i]);
+        workload.m_names.emplace_back(workload.m_buffer.data() + offsets[i], end - offsets[i]);
+    }
+    workload.m_lookups.reserve(lookupCount);
+    for(std::size_t i = 0; i < lookupCount; ++i) {
+        workload.m_lookups.push_back(static_cast<std::uint32_t>(rng() % traderCount));
+    }
+    return workload;
+}
+
+struct StringHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view name) const noexcept { return std::hash<std::string_view>{}(name); }
+};
+
+//the obvious alternative: names as std::string keys, a vector of them for the reverse lookup
+class StringMapRegistry {
+public:
+    unsigned intern(std::string_view name) {
+        const auto it = m_ids.find(name);
+        if(it != m_ids.end()) {
+            return it->second;
+        }
+        m_names.emplace_back(name);
+        return m_ids.emplace(m_names.back(), static_cast<unsigned>(m_names.size())).first->second;
+    }
+    std::string_view name(unsigned id) const noexcept { return m_names[id - 1]; }
+private:
+    std::unordered_map<std::string, unsigned, StringHash, std::equal_to<>>  m_ids;
+    std::vector<std::string>                                                m_names;
+};
+
+struct Phase {
+    double          m_ns = 0.0;//per operation
+    std::uint64_t   m_allocations = 0;
+};
+
+template<class Fn>
+Phase measure(std::size_t operations, Fn&& fn) {
+    const std::uint64_t allocationsBefore = g_allocations;
+    const auto start = Clock::now();
+    fn();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    return Phase{static_cast<double>(elapsed) / static_cast<double>(operations), g_allocations - allocationsBefore};
+}
+
+template<class Registry>
+bool run(const char* name, const Workload& workload) {
+    Registry registry;
+    std::vector<unsigned> ids(workload.m_names.size());
+    bool isCorrect = true;
+    const Phase warmUp = measure(ids.size(), [&]() {
+        for(std::size_t i = 0; i < ids.size(); ++i) {
+            ids[i] = registry.intern(workload.m_names[i]);
+        }
+    });
+    std::uint64_t mismatches = 0;
+    const Phase lookup = measure(workload.m_lookups.size(), [&]() {
+        for(const std::uint32_t index : workload.m_lookups) {
+            mismatches += registry.intern(workload.m_names[index]) != ids[index];
+        }
+    });
+    std::uint64_t nameBytes = 0;
+    const Phase reverse = measure(workload.m_lookups.size(), [&]() {
+        for(const std::uint32_t index : workload.m_lookups) {
+            const std::string_view traderName = registry.name(ids[index]);
+            nameBytes += traderName.size();
+            mismatches += traderName.back() != workload.m_names[index].back();
+        }
+    });
+    for(std::size_t i = 0; i < ids.size(); ++i) {
+        isCorrect &= ids[i] != 0 && registry.name(ids[i]) == workload.m_names[i];
+    }
+    isCorrect &= mismatches == 0;
+    std::cout << name << "\t" << ids.size() << "\t" << workload.m_lookups.size() << "\t" << warmUp.m_ns << "\t" << warmUp.m_allocations << "\t"
+              << lookup.m_ns << "\t" << lookup.m_allocations << "\t" << reverse.m_ns << "\t" << reverse.m_allocations << "\t" << nameBytes
+              << (isCorrect ? "" : "\tMISMATCH") << std::endl;
+    return isCorrect;
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t traderCount = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const std::size_t lookupCount = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+    if(!traderCount || traderCount > TraderRegistry::DEFAULT_MAX_TRADERS || !lookupCount) {
+        std::cerr << "Usage: " << argv[0] << " [distinct traders, 1.." << TraderRegistry::DEFAULT_MAX_TRADERS << "] [lookups]\n";
+        return 1;
+    }
+    const Workload workload = generate(traderCount, lookupCount);
+    std::cout << "registry\ttraders\tlookups\twarm-up ns/intern\twarm-up allocations\tlookup ns\tlookup allocations\tname ns\tname allocations\tname bytes\n";
+    bool isConsistent = run<TraderRegistry>("trader_registry", workload);
+    isConsistent &= run<StringMapRegistry>("unordered_map", workload);
+    return isConsistent ? 0 : 1;
+}
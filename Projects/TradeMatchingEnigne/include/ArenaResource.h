@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "MemoryUtils.h"
+
+namespace Common {
+  /// Where an ArenaResource takes its chunks from.
+  struct ArenaConfig {
+    size_t m_chunkBytes = 1 << 20;
+    bool m_isHugePages = false;//chunks are mapped as 2MB huge pages(MAP_HUGETLB, else transparent ones through madvise)
+    bool m_isPrefaulted = false;//chunks are mapped with their pages faulted in(MAP_POPULATE), e.g. during a warm-up
+  };
+
+  /// Allocation accounting of an ArenaResource over its lifetime.
+  struct ArenaStats {
+    uint64_t m_allocations = 0;
+    uint64_t m_deallocations = 0;
+    uint64_t m_bytes = 0;//requested by all allocations
+    uint64_t m_liveBytes = 0;
+    uint64_t m_peakBytes = 0;//highest m_liveBytes
+    uint64_t m_upstreamAllocations = 0;//blocks too large for a size class, served by the upstream resource
+    uint64_t m_chunkCount = 0;
+    uint64_t m_chunkBytes = 0;
+    uint64_t m_hugePageChunks = 0;//chunks backed by MAP_HUGETLB pages
+  };
+
+  /// Single-threaded memory_resource for the node-based containers of one engine. Blocks up to MAX_CLASS_BYTES are carved
+  /// out of large chunks by size class(multiples of CLASS_GRANULE) and recycled through one free list per class, so once the
+  /// book has been as deep as it gets, inserting and erasing container nodes never reaches malloc. Larger blocks(the arrays
+  /// of flat containers) go to the upstream resource. Chunks are only given back when the arena is destroyed.
+  class ArenaResource final : public std::pmr::memory_resource {
+  public:
+    static constexpr size_t CLASS_GRANULE = 16;
+    static constexpr size_t MAX_CLASS_BYTES = 512;
+    static constexpr size_t CLASS_COUNT = MAX_CLASS_BYTES / CLASS_GRANULE;
+    static constexpr size_t HUGE_PAGE_BYTES = 2 << 20;
+
+    explicit ArenaResource(const ArenaConfig &config = {}, std::pmr::memory_resource *upstream = std::pmr::new_delete_resource()) :
+        m_config(config), mp_upstream(upstream) {
+      m_config.m_chunkBytes = std::max(m_config.m_chunkBytes, MAX_CLASS_BYTES);
+      if (m_config.m_isHugePages)
+        m_config.m_chunkBytes = (m_config.m_chunkBytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    }
+
+    ~ArenaResource() override {
+      for (const Chunk &chunk : m_chunks) {
+        if (chunk.m_isMapped)
+          munmap(chunk.mp_memory, chunk.m_bytes);
+        else
+          mp_upstream->deallocate(chunk.mp_memory, chunk.m_bytes, alignof(std::max_align_t));
+      }
+    }
+
+    ArenaResource(const ArenaResource&) = delete;
+
+    ArenaResource(ArenaResource&&) = delete;
+
+    ArenaResource &operator=(const ArenaResource&) = delete;
+
+    ArenaResource &operator=(ArenaResource&&) = delete;
+
+    auto stats() const noexcept -> const ArenaStats & { return m_stats; }
+
+    /// One line: allocations, bytes, peak live bytes and the chunks holding them.
+    auto print(std::ostream &out, std::string_view title) const -> void {
+      out << title << " allocations: " << m_stats.m_allocations << "(" << m_stats.m_bytes << " bytes, " << m_stats.m_upstreamAllocations
+          << " from upstream) deallocations: " << m_stats.m_deallocations << " live: " << m_stats.m_liveBytes << " bytes peak: "
+          << m_stats.m_peakBytes << " bytes chunks: " << m_stats.m_chunkCount << "(" << m_stats.m_chunkBytes << " bytes, "
+          << m_stats.m_hugePageChunks << " on huge pages)" << std::endl;
+    }
+
+  private:
+    struct FreeBlock {
+      FreeBlock *mp_next;
+    };
+
+    struct Chunk {
+      void *mp_memory;
+      size_t m_bytes;
+      bool m_isMapped;
+    };
+
+    static constexpr auto classOf(size_t bytes) noexcept -> size_t {
+      return (bytes ? bytes - 1 : 0) / CLASS_GRANULE;
+    }
+
+    static constexpr auto isClassed(size_t bytes, size_t alignment) noexcept {
+      return bytes <= MAX_CLASS_BYTES && alignment <= CLASS_GRANULE;
+    }
+
+    auto do_allocate(size_t bytes, size_t alignment) -> void * override {
+      ++m_stats.m_allocations;
+      m_stats.m_bytes += bytes;
+      m_stats.m_liveBytes += bytes;
+      m_stats.m_peakBytes = std::max(m_stats.m_peakBytes, m_stats.m_liveBytes);
+      if (!isClassed(bytes, alignment)) {
+        ++m_stats.m_upstreamAllocations;
+        return mp_upstream->allocate(bytes, alignment);
+      }
+      const size_t sizeClass = classOf(bytes);
+      if (FreeBlock *block = m_freeLists[sizeClass]) {
+        m_freeLists[sizeClass] = block->mp_next;
+        return block;
+      }
+      const size_t blockBytes = (sizeClass + 1) * CLASS_GRANULE;
+      if (m_chunkLeft < blockBytes)
+        addChunk();
+      void *block = mp_chunkCursor;
+      mp_chunkCursor += blockBytes;
+      m_chunkLeft -= blockBytes;
+      return block;
+    }
+
+    auto do_deallocate(void *p, size_t bytes, size_t alignment) -> void override {
+      ++m_stats.m_deallocations;
+      m_stats.m_liveBytes -= bytes;
+      if (!isClassed(bytes, alignment)) {
+        mp_upstream->deallocate(p, bytes, alignment);
+        return;
+      }
+      const size_t sizeClass = classOf(bytes);
+      m_freeLists[sizeClass] = new (p) FreeBlock{m_freeLists[sizeClass]};
+    }
+
+    auto do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool override {
+      return this == &other;
+    }
+
+    /// The rest of the current chunk is abandoned, it is smaller than the block that didn't fit.
+    auto addChunk() -> void {
+      Chunk chunk{MAP_FAILED, m_config.m_chunkBytes, false};
+      if (m_config.m_isHugePages) {
+        const int populate = m_config.m_isPrefaulted ? MAP_POPULATE : 0;
+        chunk.mp_memory = mmap(nullptr, chunk.m_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+        if (chunk.mp_memory != MAP_FAILED)
+          ++m_stats.m_hugePageChunks;
+      }
+      if (chunk.mp_memory == MAP_FAILED && (m_config.m_isHugePages || m_config.m_isPrefaulted)) {//no reserved huge pages, or none asked for
+        chunk.mp_memory = mmap(nullptr, chunk.m_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (chunk.mp_memory != MAP_FAILED && m_config.m_isHugePages)
+          madvise(chunk.mp_memory, chunk.m_bytes, MADV_HUGEPAGE);
+        if (chunk.mp_memory != MAP_FAILED && m_config.m_isPrefaulted)
+          prefault(chunk.mp_memory, chunk.m_bytes);//after madvise(), MAP_POPULATE would fault small pages in
+      }
+      chunk.m_isMapped = chunk.mp_memory != MAP_FAILED;
+      if (!chunk.m_isMapped)
+        chunk.mp_memory = mp_upstream->allocate(chunk.m_bytes, alignof(std::max_align_t));
+      m_chunks.push_back(chunk);
+      ++m_stats.m_chunkCount;
+      m_stats.m_chunkBytes += chunk.m_bytes;
+      mp_chunkCursor = static_cast<std::byte *>(chunk.mp_memory);
+      m_chunkLeft = chunk.m_bytes;
+    }
+
+    ArenaConfig m_config;
+    std::pmr::memory_resource *mp_upstream;
+    std::array<FreeBlock *, CLASS_COUNT> m_freeLists{};
+    std::byte *mp_chunkCursor = nullptr;
+    size_t m_chunkLeft = 0;
+    std::vector<Chunk> m_chunks;
+    ArenaStats m_stats;
+  };
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "BookOrder.h"
+#include "Macros.h"
+#include "TraderRegistry.h"
+
+// Fixed-width order stream: a BinaryStreamHeader followed by BinaryOrderRecord entries, all fields little-endian.
+// Records are read in place from the mapping, therefore only little-endian hosts are supported.
+static_assert(std::endian::native == std::endian::little, "binary order stream is read in place and requires a little-endian host");
+
+constexpr char          BINARY_STREAM_MAGIC[4] = {'T', 'M', 'E', 'B'};
+constexpr std::uint16_t BINARY_STREAM_VERSION = 1;
+
+struct BinaryStreamHeader {
+    char            m_magic[4];
+    std::uint16_t   m_version;
+    std::uint16_t   m_recordSize;
+    std::uint64_t   m_recordCount;//0 if the writer didn't finish, the reader then trusts the file size
+    std::uint64_t   m_firstRequest;//input requests before the first record, non-zero for journals of a restored book
+    std::uint64_t   m_reserved;
+};
+static_assert(sizeof(BinaryStreamHeader) == 32);
+
+struct BinaryOrderRecord {
+    std::uint64_t   m_orderId;//id of a new order or the order referred to by 'C'/'M' requests
+    std::uint64_t   m_timestamp;//nanoseconds, 0 if unknown
+    std::uint32_t   m_traderId;
+    std::uint32_t   m_quantity;
+    std::uint32_t   m_price;
+    char            m_side;//'B', 'S', 'C' or 'M'
+    std::uint8_t    m_reserved[3];
+
+    // the order id as the engine's 32-bit id, 0 if it doesn't fit, which makes the request invalid rather than alias another order
+    [[nodiscard]] unsigned engineOrderId() const noexcept {
+        return (m_orderId <= MAX_ORDER_ID) ? static_cast<unsigned>(m_orderId) : 0;
+    }
+    [[nodiscard]] BookOrder toOrder() const noexcept {
+        return BookOrder{m_traderId, m_quantity, m_price, m_side, engineOrderId()};
+    }
+    static BinaryOrderRecord fromOrder(const BookOrder& order, std::uint64_t timestamp = 0) noexcept {
+        return BinaryOrderRecord{order.getOrderId(), timestamp, order.getId(), order.getQuantity(), order.getPrice(), order.getSide(), {}};
+    }
+};
+static_assert(sizeof(BinaryOrderRecord) == 32);
+
+// Buffered writer, the record count is patched into the header on close().
+class BinaryOrderWriter {
+public:
+    static constexpr std::size_t BUFFER_RECORDS = 32 * 1024;
+
+    explicit BinaryOrderWriter(const std::string& path) :
+        m_fd{::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)},
+        mp_buffer{std::make_unique<BinaryOrderRecord[]>(BUFFER_RECORDS)}
+    {
+        ASSERT(m_fd >= 0, "BinaryOrderWriter: could not open " + path + " errno:" + std::string(strerror(errno)));
+        const BinaryStreamHeader header = makeHeader(0);
+        writeAll(&header, sizeof(header));
+    }
+
+    ~BinaryOrderWriter() { close(); }
+
+    void append(const BinaryOrderRecord& record) {
+        mp_buffer[m_buffered++] = record;
+        if(UNLIKELY(m_buffered == BUFFER_RECORDS)) {
+            flush();
+        }
+    }
+
+    void close() {
+        if(m_fd < 0) {
+            return;
+        }
+        flush();
+        const BinaryStreamHeader header = makeHeader(m_count);
+        ASSERT(::pwrite(m_fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)), "BinaryOrderWriter: header update failed. errno:" + std::string(strerror(errno)));
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    [[nodiscard]] std::uint64_t count() const noexcept { return m_count + m_buffered; }
+
+    BinaryOrderWriter(const BinaryOrderWriter&) = delete;
+    BinaryOrderWriter& operator=(const BinaryOrderWriter&) = delete;
+
+    static BinaryStreamHeader makeHeader(std::uint64_t count, std::uint64_t firstRequest = 0) noexcept {
+        BinaryStreamHeader header{};
+        std::memcpy(header.m_magic, BINARY_STREAM_MAGIC, sizeof(header.m_magic));
+        header.m_version = BINARY_STREAM_VERSION;
+        header.m_recordSize = sizeof(BinaryOrderRecord);
+        header.m_recordCount = count;
+        header.m_firstRequest = firstRequest;
+        return header;
+    }
+
+private:
+    void flush() {
+        writeAll(mp_buffer.get(), m_buffered * sizeof(BinaryOrderRecord));
+        m_count += m_buffered;
+        m_buffered = 0;
+    }
+
+    void writeAll(const void* data, std::size_t size) {
+        const char* pos = static_cast<const char*>(data);
+        while(size) {
+            const ssize_t rc = ::write(m_fd, pos, size);
+            if(rc < 0) {
+                ASSERT(errno == EINTR, "BinaryOrderWriter: write() failed. errno:" + std::string(strerror(errno)));
+                continue;
+            }
+            pos += rc;
+            size -= static_cast<std::size_t>(rc);
+        }
+    }
+
+    int                                     m_fd;
+    std::unique_ptr<BinaryOrderRecord[]>    mp_buffer;
+    std::size_t                             m_buffered = 0;
+    std::uint64_t                           m_count = 0;
+};
+
+// Maps a binary order stream and exposes its records without any parsing.
+class BinaryOrderReader {
+public:
+    // isPopulated maps the whole file in up front(MAP_POPULATE) rather than page by page while reading
+    explicit BinaryOrderReader(const std::string& path, bool isPopulated = false) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            m_error = "could not open " + path;
+            return;
+        }
+        struct stat st{};
+        if(fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(BinaryStreamHeader)) {
+            m_error = path + " is too short for a binary order stream";
+            ::close(fd);
+            return;
+        }
+        m_mapSize = static_cast<std::size_t>(st.st_size);
+        void* map = mmap(nullptr, m_mapSize, PROT_READ, MAP_PRIVATE | (isPopulated ? MAP_POPULATE : 0), fd, 0);
+        ::close(fd);
+        if(map == MAP_FAILED) {
+            m_error = "mmap() failed for " + path;
+            return;
+        }
+        madvise(map, m_mapSize, MADV_SEQUENTIAL);
+        mp_map = static_cast<const char*>(map);
+
+        const auto* header = reinterpret_cast<const BinaryStreamHeader*>(mp_map);
+        if(std::memcmp(header->m_magic, BINARY_STREAM_MAGIC, sizeof(header->m_magic)) != 0) {
+            m_error = path + " is not a binary order stream";
+        } else if(header->m_version != BINARY_STREAM_VERSION || header->m_recordSize != sizeof(BinaryOrderRecord)) {
+            m_error = path + " has unsupported version " + std::to_string(header->m_version);
+        } else {
+            const std::size_t available = (m_mapSize - sizeof(BinaryStreamHeader)) / sizeof(BinaryOrderRecord);
+            const std::size_t count = header->m_recordCount ? std::min<std::size_t>(header->m_recordCount, available) : available;
+            m_records = std::span<const BinaryOrderRecord>(reinterpret_cast<const BinaryOrderRecord*>(mp_map + sizeof(BinaryStreamHeader)), count);
+            m_firstRequest = header->m_firstRequest;
+        }
+    }
+
+    ~BinaryOrderReader() {
+        if(mp_map) {
+            munmap(const_cast<char*>(mp_map), m_mapSize);
+        }
+    }
+
+    [[nodiscard]] bool good() const noexcept { return m_error.empty(); }
+    [[nodiscard]] const std::string& error() const noexcept { return m_error; }
+    [[nodiscard]] std::span<const BinaryOrderRecord> records() const noexcept { return m_records; }
+    [[nodiscard]] std::uint64_t firstRequest() const noexcept { return m_firstRequest; }
+
+    BinaryOrderReader(const BinaryOrderReader&) = delete;
+    BinaryOrderReader& operator=(const BinaryOrderReader&) = delete;
+
+private:
+    const char*                         mp_map = nullptr;
+    std::size_t                         m_mapSize = 0;
+    std::span<const BinaryOrderRecord>  m_records;
+    std::uint64_t                       m_firstRequest = 0;
+    std::string                         m_error;
+};
+
+// Records carry trader ids only, the names of the interned ones(TraderRegistry) a stream refers to are kept next to it in
+// <stream>.traders, in id order as TraderRegistry::appendNames() writes them. Journals and tme_convert write the file,
+// streams of numeric traders only have none.
+constexpr char TRADER_NAMES_SUFFIX[] = ".traders";
+
+// Writes the names of every trader interned so far next to the stream at path, or removes a stale names file if there are none.
+inline bool saveTraderNames(const std::string& path, const TraderRegistry& traders, std::string& error) {
+    const std::string namesPath = path + TRADER_NAMES_SUFFIX;
+    if(!traders.size()) {
+        ::unlink(namesPath.c_str());
+        return true;
+    }
+    std::string table;
+    traders.appendNames(0, traders.size(), table);
+    const int fd = ::open(namesPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    std::size_t written = 0;
+    while(fd >= 0 && written < table.size()) {
+        const ssize_t rc = ::write(fd, table.data() + written, table.size() - written);
+        if(rc < 0 && errno != EINTR) {
+            break;
+        }
+        written += (rc > 0) ? static_cast<std::size_t>(rc) : 0;
+    }
+    if(fd >= 0) {
+        ::close(fd);
+    }
+    if(written != table.size()) {
+        error = "could not write " + namesPath + ": " + std::string(strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// Loads the names of the stream at path into traders, false with the reason in error if they conflict with the names
+// known already. A stream without a names file leaves traders as they are.
+inline bool loadTraderNames(const std::string& path, TraderRegistry& traders, std::string& error) {
+    const std::string namesPath = path + TRADER_NAMES_SUFFIX;
+    const int fd = ::open(namesPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        return true;
+    }
+    struct stat st{};
+    std::string table;
+    if(fstat(fd, &st) == 0) {
+        table.resize(static_cast<std::size_t>(st.st_size));
+    }
+    std::size_t size = 0;
+    while(size < table.size()) {
+        const ssize_t rc = ::read(fd, table.data() + size, table.size() - size);
+        if(rc <= 0) {
+            if(rc < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        size += static_cast<std::size_t>(rc);
+    }
+    ::close(fd);
+    if(size != table.size() || !traders.restoreNames(table)) {
+        error = namesPath + " doesn't hold trader names that fit the traders known already";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "BinaryOrderStream.h"
+#include "BookOrder.h"
+#include "LatencyHistogram.h"
+#include "Macros.h"
+#include "OrderPool.h"
+#include "ThreadUtils.h"
+#include "TimeUtils.h"
+#include "TraderRegistry.h"
+
+// Checkpoint of an OrderPool: a BookSnapshotHeader followed by one BinaryOrderRecord per resting order, buy levels best
+// first, then sell levels best first, every level in queue order. Loading the records in file order therefore rebuilds
+// every level with its time priorities. m_requestCount is the number of input requests the book reflects, a restart
+// loads the book and replays only the requests after them. Since version 2 the records are followed by the name table of
+// the interned trader ids(TraderRegistry::appendNames()), version 1 snapshots have none.
+constexpr char          BOOK_SNAPSHOT_MAGIC[4] = {'T', 'M', 'E', 'S'};
+constexpr std::uint16_t BOOK_SNAPSHOT_VERSION = 2;
+
+struct BookSnapshotHeader {
+    char            m_magic[4];
+    std::uint16_t   m_version;
+    std::uint16_t   m_recordSize;
+    std::uint64_t   m_requestCount;
+    std::uint64_t   m_orderCount;//of records following the header
+    std::uint32_t   m_buyLevelCount;
+    std::uint32_t   m_sellLevelCount;
+    std::uint64_t   m_captureTime;//Common::getCurrentNanos() when the book was copied
+    std::uint32_t   m_traderCount;//names in the table following the records
+    std::uint32_t   m_traderNameBytes;//size of the table
+    std::uint64_t   m_reserved[2];
+};
+static_assert(sizeof(BookSnapshotHeader) == 64);
+
+// Writes snapshots without stalling matching for the I/O: the matching thread only copies the resting orders into a
+// flat buffer, a writer thread writes it to <path>.tmp, syncs it and renames it over <path>, so a crash never leaves a
+// torn snapshot behind. A capture is refused while the previous snapshot is still being written.
+// The trader name table only grows, so a capture copies just the names interned since the previous one.
+class BookSnapshotWriter {
+public:
+    // traderNames is read on the matching thread, which must be the one interning the names
+    explicit BookSnapshotWriter(const std::string& path, const TraderRegistry* traderNames = nullptr) :
+        m_path{path},
+        mp_traderNames{traderNames}
+    {
+        mp_thread = Common::createAndStartThread(-1, "Snapshot/writer", [this]() { writeLoop(); });
+        ASSERT(mp_thread != nullptr, "Failed to start the snapshot writer thread.");
+    }
+
+    ~BookSnapshotWriter() {
+        wait();
+        m_state.store(STOPPING, std::memory_order_release);
+        m_state.notify_one();
+        mp_thread->join();
+        delete mp_thread;
+    }
+
+    // matching thread: copies the book as of requestCount requests, false while the previous snapshot is being written
+    template<class MapContBuy, class MapContSell>
+    bool capture(const OrderPool<MapContBuy, MapContSell>& pool, std::uint64_t requestCount) {
+        if(m_state.load(std::memory_order_acquire) != IDLE) {
+            return false;
+        }
+        const Common::Nanos start = Common::getCurrentNanos();
+        m_records.clear();
+        m_records.reserve(pool.nodePool().inUse());
+        std::uint32_t levelCounts[2] = {};
+        for(const char side : {'B', 'S'}) {
+            std::uint32_t& levels = levelCounts[side == 'S'];
+            pool.forEachOrder(side, [&](const BookOrder& order) {
+                levels += (m_records.empty() || m_records.back().m_side != side || m_records.back().m_price != order.getPrice());
+                m_records.push_back(BinaryOrderRecord::fromOrder(order));
+            });
+        }
+        m_header = BookSnapshotHeader{};
+        std::memcpy(m_header.m_magic, BOOK_SNAPSHOT_MAGIC, sizeof(m_header.m_magic));
+        m_header.m_version = BOOK_SNAPSHOT_VERSION;
+        m_header.m_recordSize = sizeof(BinaryOrderRecord);
+        m_header.m_requestCount = requestCount;
+        m_header.m_orderCount = m_records.size();
+        m_header.m_buyLevelCount = levelCounts[0];
+        m_header.m_sellLevelCount = levelCounts[1];
+        m_header.m_captureTime = static_cast<std::uint64_t>(start);
+        if(mp_traderNames && mp_traderNames->size() > m_traderCount) {
+            mp_traderNames->appendNames(m_traderCount, mp_traderNames->size(), m_traderNames);
+            m_traderCount = mp_traderNames->size();
+        }
+        m_header.m_traderCount = static_cast<std::uint32_t>(m_traderCount);
+        m_header.m_traderNameBytes = static_cast<std::uint32_t>(m_traderNames.size());
+        m_captureStall.record(static_cast<std::uint64_t>(Common::getCurrentNanos() - start));
+        m_state.store(PENDING, std::memory_order_release);
+        m_state.notify_one();
+        return true;
+    }
+
+    // blocks until the snapshot being written is on disk
+    void wait() {
+        while(m_state.load(std::memory_order_acquire) == PENDING) {
+            m_state.wait(PENDING, std::memory_order_acquire);
+        }
+    }
+
+    // after wait()
+    void print(std::ostream& os) const {
+        os << "Snapshots: " << m_writtenCount << " written to " << m_path << ", " << m_failedCount << " failed, last one at request "
+           << m_header.m_requestCount << " with " << m_header.m_orderCount << " orders(" << m_header.m_buyLevelCount << " bid and "
+           << m_header.m_sellLevelCount << " ask levels)" << std::endl;
+        m_captureStall.print(os, "Snapshot capture(ns), matching stalled");
+        m_writeTime.print(os, "Snapshot write(ns), in the background");
+    }
+
+    BookSnapshotWriter(const BookSnapshotWriter&) = delete;
+    BookSnapshotWriter& operator=(const BookSnapshotWriter&) = delete;
+
+private:
+    static constexpr int IDLE = 0;
+    static constexpr int PENDING = 1;//m_header, m_records and m_traderNames belong to the writer thread until it is IDLE again
+    static constexpr int STOPPING = 2;
+
+    void writeLoop() {
+        while(true) {
+            m_state.wait(IDLE, std::memory_order_acquire);
+            const int state = m_state.load(std::memory_order_acquire);
+            if(state == STOPPING) {
+                break;
+            }
+            if(state == PENDING) {
+                writeFile();
+                m_state.store(IDLE, std::memory_order_release);
+                m_state.notify_all();
+            }
+        }
+    }
+
+    void writeFile() {
+        const Common::Nanos start = Common::getCurrentNanos();
+        const std::string tmpPath = m_path + ".tmp";
+        const int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if(fd < 0) {
+            reportError("open", tmpPath);
+            return;
+        }
+        iovec vectors[3] = {{&m_header, sizeof(m_header)}, {m_records.data(), m_records.size() * sizeof(BinaryOrderRecord)},
+                            {m_traderNames.data(), m_traderNames.size()}};
+        iovec* next = vectors;
+        int count = 3;
+        while(count) {//resumed after partial writes
+            const ssize_t written = ::writev(fd, next, count);
+            if(written < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                reportError("writev", tmpPath);
+                ::close(fd);
+                return;
+            }
+            std::size_t left = static_cast<std::size_t>(written);
+            while(count && left >= next->iov_len) {
+                left -= next->iov_len;
+                ++next;
+                --count;
+            }
+            if(count && left) {
+                next->iov_base = static_cast<char*>(next->iov_base) + left;
+                next->iov_len -= left;
+            }
+        }
+        if(::fdatasync(fd) != 0) {
+            reportError("fdatasync", tmpPath);
+            ::close(fd);
+            return;
+        }
+        ::close(fd);
+        if(std::rename(tmpPath.c_str(), m_path.c_str()) != 0) {
+            reportError("rename", m_path);
+            return;
+        }
+        m_writeTime.record(static_cast<std::uint64_t>(Common::getCurrentNanos() - start));
+        ++m_writtenCount;
+    }
+
+    void reportError(const char* call, const std::string& path) {
+        if(!m_failedCount++) {
+            std::cerr << "Snapshot " << call << " failed on " << path << ": " << std::strerror(errno) << std::endl;
+        }
+    }
+
+    const std::string               m_path;
+    const TraderRegistry*           mp_traderNames;
+    std::string                     m_traderNames;//table of the first m_traderCount interned ids
+    std::size_t                     m_traderCount = 0;
+    std::thread*                    mp_thread = nullptr;
+    std::atomic<int>                m_state = {IDLE};
+    BookSnapshotHeader              m_header{};
+    std::vector<BinaryOrderRecord>  m_records;
+    Common::LatencyHistogram        m_captureStall;//matching thread
+    Common::LatencyHistogram        m_writeTime;//writer thread
+    std::uint64_t                   m_writtenCount = 0;
+    std::uint64_t                   m_failedCount = 0;
+};
+
+// Maps a snapshot and exposes its records, like BinaryOrderReader does for order streams.
+class BookSnapshotReader {
+public:
+    explicit BookSnapshotReader(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            m_error = "could not open " + path;
+            return;
+        }
+        struct stat st{};
+        if(fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(BookSnapshotHeader)) {
+            m_error = path + " is too short for a book snapshot";
+            ::close(fd);
+            return;
+        }
+        m_mapSize = static_cast<std::size_t>(st.st_size);
+        void* map = mmap(nullptr, m_mapSize, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);//read in full right away
+        ::close(fd);
+        if(map == MAP_FAILED) {
+            m_error = "mmap() failed for " + path;
+            return;
+        }
+        mp_map = static_cast<const char*>(map);
+
+        const auto* header = reinterpret_cast<const BookSnapshotHeader*>(mp_map);
+        if(std::memcmp(header->m_magic, BOOK_SNAPSHOT_MAGIC, sizeof(header->m_magic)) != 0) {
+            m_error = path + " is not a book snapshot";
+        } else if(header->m_version == 0 || header->m_version > BOOK_SNAPSHOT_VERSION || header->m_recordSize != sizeof(BinaryOrderRecord)) {
+            m_error = path + " has unsupported version " + std::to_string(header->m_version);
+        } else if(m_mapSize != sizeof(BookSnapshotHeader) + header->m_orderCount * sizeof(BinaryOrderRecord) + header->m_traderNameBytes) {
+            m_error = path + " doesn't hold the " + std::to_string(header->m_orderCount) + " orders of its header";
+        } else {//the reserved fields of version 1 were zero, so it reads as a snapshot without names
+            mp_header = header;
+            const char* recordsBegin = mp_map + sizeof(BookSnapshotHeader);
+            m_records = std::span<const BinaryOrderRecord>(reinterpret_cast<const BinaryOrderRecord*>(recordsBegin), header->m_orderCount);
+            m_traderNames = std::string_view(recordsBegin + header->m_orderCount * sizeof(BinaryOrderRecord), header->m_traderNameBytes);
+        }
+    }
+
+    ~BookSnapshotReader() {
+        if(mp_map) {
+            munmap(const_cast<char*>(mp_map), m_mapSize);
+        }
+    }
+
+    [[nodiscard]] bool good() const noexcept { return m_error.empty(); }
+    [[nodiscard]] const std::string& error() const noexcept { return m_error; }
+    [[nodiscard]] const BookSnapshotHeader& header() const noexcept { return *mp_header; }
+    [[nodiscard]] std::span<const BinaryOrderRecord> records() const noexcept { return m_records; }
+
+    // Loads the trader names into traders, which must be empty or hold a prefix of the snapshot's names. False, with the
+    // reason in error(), if they conflict or the snapshot holds interned trader ids without names(a version 1 snapshot).
+    bool restoreTraders(TraderRegistry& traders) {
+        if(!traders.restoreNames(m_traderNames) || traders.size() < mp_header->m_traderCount) {
+            m_error = "the trader names of the snapshot conflict with the traders known already";
+            return false;
+        }
+        for(const BinaryOrderRecord& record : m_records) {
+            if(!traders.isKnown(record.m_traderId)) {
+                m_error = "the snapshot holds orders of named traders without their names";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // loads the records into an empty pool, false if any of them couldn't be placed
+    template<class MapContBuy, class MapContSell>
+    bool restore(OrderPool<MapContBuy, MapContSell>& pool) const {
+        bool isComplete = true;
+        for(const BinaryOrderRecord& record : m_records) {
+            isComplete &= pool.restoreOrder(record.toOrder());
+        }
+        return isComplete;
+    }
+
+    BookSnapshotReader(const BookSnapshotReader&) = delete;
+    BookSnapshotReader& operator=(const BookSnapshotReader&) = delete;
+
+private:
+    const char*                         mp_map = nullptr;
+    std::size_t                         m_mapSize = 0;
+    const BookSnapshotHeader*           mp_header = nullptr;
+    std::span<const BinaryOrderRecord>  m_records;
+    std::string_view                    m_traderNames;
+    std::string                         m_error;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "PrefixSum.h"
+
+// Outcome of a call auction uncross.
+struct AuctionResult {
+    unsigned        m_price = 0;//clearing price, 0 if the book doesn't cross
+    std::uint64_t   m_volume = 0;//executed on each side
+    std::int64_t    m_imbalance = 0;//demand minus supply at the clearing price, the surplus left resting
+    std::size_t     m_levelCount = 0;//distinct prices of the crossed region the curves were built over
+};
+
+// Cumulative demand and supply over the prices where a book crosses, and the clearing price they give.
+// Only prices between the best ask and the best bid matter: below the best ask nothing is supplied, above the best bid
+// nothing is demanded. Executable volume only changes at level prices, so the level prices are the candidates.
+class AuctionCurves {
+public:
+    void clear() noexcept {
+        m_prices.clear();
+        m_bids.clear();
+        m_asks.clear();
+    }
+
+    // levels in ascending price order, with the bid and ask quantity resting at that price
+    void addLevel(unsigned price, std::uint64_t bidQuantity, std::uint64_t askQuantity) {
+        m_prices.push_back(price);
+        m_bids.push_back(bidQuantity);
+        m_asks.push_back(askQuantity);
+    }
+
+    // The price of maximum executable volume. Ties go to the smallest surplus, then to the side of the surplus(the highest
+    // price when demand exceeds supply at every remaining candidate, the lowest when supply does), then to the price closest
+    // to referencePrice, the middle of the remaining candidates if it's 0, the lower one of two equally close prices.
+    AuctionResult clearingPrice(unsigned referencePrice) {
+        const std::size_t count = m_prices.size();
+        AuctionResult result;
+        result.m_levelCount = count;
+        if(!count) {
+            return result;
+        }
+        m_supply.resize(count);
+        m_demand.resize(count);
+        Common::inclusivePrefixSum(m_asks.data(), m_supply.data(), count);//asks priced at or below each price
+        const std::uint64_t totalBids = Common::inclusivePrefixSum(m_bids.data(), m_demand.data(), count);
+        for(std::size_t i = 0; i < count; ++i) {//bids priced at or above each price
+            m_demand[i] = totalBids - m_demand[i] + m_bids[i];
+        }
+
+        std::uint64_t bestVolume = 0;
+        std::uint64_t bestSurplus = std::numeric_limits<std::uint64_t>::max();
+        for(std::size_t i = 0; i < count; ++i) {
+            const std::uint64_t volume = std::min(m_demand[i], m_supply[i]);
+            const std::uint64_t surplus = std::max(m_demand[i], m_supply[i]) - volume;
+            if(volume > bestVolume || (volume == bestVolume && surplus < bestSurplus)) {
+                bestVolume = volume;
+                bestSurplus = surplus;
+            }
+        }
+        if(!bestVolume) {
+            return result;
+        }
+        std::size_t first = count;
+        std::size_t last = 0;
+        bool isDemandSurplus = true;
+        bool isSupplySurplus = true;
+        for(std::size_t i = 0; i < count; ++i) {
+            if(isCandidate(i, bestVolume, bestSurplus)) {
+                first = std::min(first, i);
+                last = i;
+                isDemandSurplus &= m_demand[i] > m_supply[i];
+                isSupplySurplus &= m_supply[i] > m_demand[i];
+            }
+        }
+        std::size_t chosen = first;
+        if(isDemandSurplus) {
+            chosen = last;
+        } else if(!isSupplySurplus) {
+            const unsigned reference = referencePrice ? referencePrice : m_prices[first] + (m_prices[last] - m_prices[first]) / 2;
+            unsigned bestDistance = std::numeric_limits<unsigned>::max();
+            for(std::size_t i = first; i <= last; ++i) {
+                const unsigned distance = (m_prices[i] > reference) ? m_prices[i] - reference : reference - m_prices[i];
+                if(distance < bestDistance && isCandidate(i, bestVolume, bestSurplus)) {
+                    bestDistance = distance;
+                    chosen = i;
+                }
+            }
+        }
+        result.m_price = m_prices[chosen];
+        result.m_volume = bestVolume;
+        result.m_imbalance = static_cast<std::int64_t>(m_demand[chosen]) - static_cast<std::int64_t>(m_supply[chosen]);
+        return result;
+    }
+
+private:
+    [[nodiscard]] bool isCandidate(std::size_t i, std::uint64_t volume, std::uint64_t surplus) const noexcept {
+        return std::min(m_demand[i], m_supply[i]) == volume && std::max(m_demand[i], m_supply[i]) - volume == surplus;
+    }
+
+    std::vector<unsigned>       m_prices;
+    std::vector<std::uint64_t>  m_bids;
+    std::vector<std::uint64_t>  m_asks;
+    std::vector<std::uint64_t>  m_demand;
+    std::vector<std::uint64_t>  m_supply;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+// What the last OrderPool::tryExecute() call did with its request.
+enum class ExecOutcome : std::uint8_t {
+    Ignored,            //invalid, unknown order id or duplicate
+    Rested,             //no match, the whole order was added to the book
+    PartiallyFilled,    //matched, the remainder was added to the book
+    Filled,             //matched completely
+    Cancelled,
+    Amended,            //quantity decreased in place, repriced amendments report the outcome of the re-entry
+    Rejected,           //priced outside the band of a bounded backend(PriceLadder), or refused by the gateway before reaching the book
+    COUNT
+};
+
+inline constexpr const char* outcomeName(ExecOutcome outcome) noexcept {
+    constexpr const char* NAMES[] = {"ignored", "rested", "partially filled", "filled", "cancelled", "amended", "rejected"};
+    return NAMES[static_cast<std::size_t>(outcome)];
+}
@@ -1,10 +1,25 @@
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <istream>
-#include <sstream>
 #include <cstdlib>
 #include <fstream>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
 
-#include "BookOrder.h"
+#include "BinaryOrderStream.h"
+#include "BookSnapshot.h"
+#include "InputReader.h"
+#include "LineParser.h"
+#include "LineSplitter.h"
+#include "MarketDataPublisher.h"
+#include "OrderJournal.h"
+#include "OrderLatency.h"
+#include "OrderPool.h"
+#include "TradeReporter.h"
+#include "TraderRegistry.h"
 #include "Macros.h"
 
 #include <stdlib.h>
@@ -12,50 +27,392 @@
 
 template<class MapContBuy, class MapContSell>
 class Extractor {
-    struct LineParser {
-        BookOrder process(const std::string& line) {
-            if(UNLIKELY(line.empty())) {
-                std::cerr << "Invalid input. Exiting.\n";
-                return BookOrder{};//invalid order
-            }
-            std::istringstream iss(line);
-            unsigned trId{}; char side{}; unsigned quantity{}; unsigned price{};
-            iss >> trId >> side >>  quantity >> price;
-            BookOrder tmp{trId, quantity, price, side};
-            if(!tmp.isValid()) {
-                if(m_dbgMode) {
-                std::cerr << "Invalid order. Dumping the order(id, side, quantity, price): " << trId <<" "<< side <<" "<< quantity<<" "<< price<<'\n';
-                }
-            }
-            return tmp;
-        }
-        void setDbgMode(const bool flag) noexcept { m_dbgMode = flag; }
-private:
-        bool m_dbgMode = false;
-    } m_lineParser;
 public:
-    void process(std::ifstream& input) {
+    void process(std::istream& input) {
         std::string currLine;
-        std::chrono::nanoseconds total_time{};
         while(std::getline(input, currLine)) {
+            if(UNLIKELY(m_skipRequests)) {
+                --m_skipRequests;
+                continue;
+            }
             BookOrder currOrder = m_lineParser.process(currLine);
-            using clock = std::chrono::high_resolution_clock;
-            auto start = clock::now();
-            m_orderPool.tryExecute(currOrder);
-            auto end = clock::now();
-            auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
-            total_time += elapsed_ns;
+            execute(currOrder);
         }
-        std::cout << "Orders' total processed time(ns): " << total_time.count()<<std::endl;
+        m_reporter.flush();
+        finishStages();
+        dumpStats();
+    }
+
+    //Zero-copy path: lines are split with SIMD byte scans and parsed in place, a chunk of lines at a time,
+    //so parsing and matching are timed separately.
+    void process(Common::InputReader& input) {
+        using clock = std::chrono::high_resolution_clock;
+        std::chrono::nanoseconds parse_time{};
+        std::size_t totalBytes = 0;
+        auto newlines = std::make_unique<std::uint32_t[]>(Common::LINE_SCAN_CHUNK_SIZE);
+        std::vector<BookOrder> batch;
+        batch.reserve(Common::LINE_SCAN_CHUNK_SIZE);
+        std::string_view block;
+        auto parseStart = clock::now();
+        while(input.nextBlock(block)) {
+            totalBytes += block.size();
+            Common::forEachLine(block, newlines.get(),
+                [&](const char* lineBegin, const char* lineEnd) {
+                    if(UNLIKELY(m_skipRequests)) {
+                        --m_skipRequests;
+                        return;
+                    }
+                    batch.push_back(m_lineParser.process(lineBegin, lineEnd));
+                },
+                [&]() {
+                    parse_time += clock::now() - parseStart;
+                    executeBatch(batch);
+                    batch.clear();
+                    parseStart = clock::now();
+                });
+        }
+        m_reporter.flush();
+        finishStages();
+        const double parseSeconds = std::chrono::duration<double>(parse_time).count();
+        std::cout << "Parsed " << totalBytes << " bytes in " << parse_time.count() << " ns("
+                  << (parseSeconds > 0 ? static_cast<double>(totalBytes) / parseSeconds / 1e6 : 0.0) << " MB/s)" << std::endl;
+        dumpStats();
     }
 
     constexpr Extractor() = default;
-    explicit Extractor(bool dbgMode) :
-        m_orderPool{}
+    explicit Extractor(bool dbgMode, std::size_t expectedOrders = OrderPool<MapContBuy, MapContSell>::DEFAULT_NODE_CAPACITY,
+                       const Common::ArenaConfig& arenaConfig = {}) :
+        m_orderPool{expectedOrders, arenaConfig}
     { 
         m_lineParser.setDbgMode(dbgMode); 
+        m_lineParser.setPriceBand(&OrderPool<MapContBuy, MapContSell>::isInBand);
+    }
+
+    //Parse-free path: fixed-width records are read straight from the mapping, so the run measures pure tryExecute cost.
+    void process(const BinaryOrderReader& input) {
+        const auto records = input.records();
+        if(input.firstRequest() > m_skipRequests) {
+            std::cerr << "The orders start at input request " << input.firstRequest() << ", the book doesn't reflect the "
+                      << input.firstRequest() - m_skipRequests << " requests before them\n";
+        }
+        //a journal of a restored book starts after the requests of its snapshot
+        const std::uint64_t toSkip = m_skipRequests - std::min(m_skipRequests, input.firstRequest());
+        const std::size_t skipped = std::min<std::uint64_t>(toSkip, records.size());
+        m_skipRequests = 0;
+        std::vector<BookOrder> batch;
+        batch.reserve(BINARY_CHUNK_SIZE);
+        for(const BinaryOrderRecord& record : records.subspan(skipped)) {
+            batch.push_back(m_lineParser.makeOrder(record.m_traderId, record.m_side, record.m_quantity, record.m_price, record.engineOrderId()));
+            if(batch.size() == BINARY_CHUNK_SIZE) {
+                executeBatch(batch);
+                batch.clear();
+            }
+        }
+        executeBatch(batch);
+        m_reporter.flush();
+        finishStages();
+        dumpStats();
+    }
+
+    // prints the latency percentiles of every interval of this many requests, 0 reports at the end only
+    void setLatencyInterval(std::uint64_t requests) noexcept { m_latencyInterval = requests; }
+
+    // Before the first request and any restore: grows the book to its working size and touches its memory through synthetic
+    // matching(OrderPool::warmUp()) and reserves the batch buffers.
+    void warmUp(const WarmUpConfig& config) {
+        const Common::Nanos start = Common::getCurrentNanos();
+        const std::size_t orders = m_orderPool.warmUp(config);
+        m_batchResults.reserve(m_batchSize);
+        m_batchFills.reserve(2 * m_batchSize);//an execution per request
+        std::cout << "Warm-up: " << orders << " orders on " << config.m_levels << " levels per side in " << Common::getCurrentNanos() - start
+                  << " ns" << std::endl;
+    }
+
+    // time-to-first-order is measured from launch, the process start in practice
+    void setLaunchTime(Common::Nanos launch) noexcept { m_launchTime = launch; }
+
+    // mmap and binary input are matched through OrderPool::tryExecuteBatch() this many requests at a time, 1 times every request
+    void setBatchSize(std::size_t requests) noexcept { m_batchSize = std::max<std::size_t>(requests, 1); }
+
+    // publishes the level changes of every request over UDP multicast, before any input is processed
+    void enableMarketData(const MarketDataConfig& config) {
+        m_orderPool.trackLevelChanges(true);
+        mp_marketData = std::make_unique<MarketDataPublisher>(config);
+        mp_marketData->publishBook(m_orderPool);//a restored book
+    }
+
+    // writes a snapshot of the book every interval requests(0 only at the end of the input) and whenever onDemand is set
+    void enableSnapshots(const std::string& path, std::uint64_t interval, std::atomic<bool>* onDemand) {
+        mp_snapshots = std::make_unique<BookSnapshotWriter>(path, &m_traders);
+        m_snapshotInterval = interval;
+        mp_isSnapshotRequested = onDemand;
+    }
+
+    // journals every request before it is executed, after restore() so the journal starts where the restored book ends
+    void enableJournal(const JournalConfig& config) {
+        mp_journal = std::make_unique<OrderJournal>(config, m_requestCount, &m_traders);
+        if(mp_journal->isStrict()) {
+            m_reporter.setOutputBarrier([journal = mp_journal.get()]() { journal->waitCommitted(); });
+        }
+    }
+
+    // collects requests without matching and uncrosses the book after every interval requests of the input and at its end
+    void enableAuction(std::uint64_t interval) {
+        m_auctionInterval = interval;
+        m_orderPool.setCallPhase(true);
+    }
+
+    // Loads the trader names of binary input(<input>.traders), after restore(). A replayed journal must name every trader it
+    // refers to, other streams report ids without a name as T<id>. False if the names can't be used.
+    bool loadTraders(const std::string& inputPath, const BinaryOrderReader& input, bool isReplay) {
+        std::string error;
+        if(!loadTraderNames(inputPath, m_traders, error)) {
+            std::cerr << "Could not load the trader names: " << error << "\n";
+            return false;
+        }
+        if(isReplay) {
+            for(const BinaryOrderRecord& record : input.records()) {
+                if(!m_traders.isKnown(record.m_traderId)) {
+                    std::cerr << "Could not replay the journal: it refers to named traders missing from " << inputPath << TRADER_NAMES_SUFFIX << "\n";
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // loads the book and the trader names of a snapshot into the empty pool, the first requests of the input it already reflects are skipped
+    bool restore(const std::string& path) {
+        const Common::Nanos start = Common::getCurrentNanos();
+        BookSnapshotReader reader(path);
+        if(!reader.good() || !reader.restoreTraders(m_traders)) {
+            std::cerr << "Could not load snapshot: " << reader.error() << "\n";
+            return false;
+        }
+        if(!reader.restore(m_orderPool)) {
+            std::cerr << "Snapshot " << path << " holds orders that can't be restored into this book\n";
+            return false;
+        }
+        const BookSnapshotHeader& header = reader.header();
+        if(header.m_requestCount > MAX_ORDER_ID) {
+            std::cerr << "Snapshot " << path << " is taken after " << header.m_requestCount << " requests, past the 32-bit order ids\n";
+            return false;
+        }
+        m_requestCount = m_skipRequests = header.m_requestCount;
+        m_lineParser.setSequence(static_cast<unsigned>(header.m_requestCount));
+        std::cout << "Restored " << header.m_orderCount << " orders(" << header.m_buyLevelCount << " bid and " << header.m_sellLevelCount
+                  << " ask levels) as of request " << header.m_requestCount << " from " << path << " in "
+                  << Common::getCurrentNanos() - start << " ns" << std::endl;
+        return true;
     }
 
 private:
+    void execute(BookOrder& order) {
+        using clock = std::chrono::high_resolution_clock;
+        auto start = clock::now();
+        if(UNLIKELY(mp_journal != nullptr)) {
+            mp_journal->append(order);//tryExecute() consumes the quantity
+        }
+        m_orderPool.tryExecute(order);
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+        recordLatency(static_cast<std::uint64_t>(elapsed), m_orderPool.outcome(), m_orderPool.levelsSwept());
+        m_reporter.report(m_orderPool.fills());
+        if(UNLIKELY(mp_marketData != nullptr)) {
+            mp_marketData->publish(m_orderPool);
+        }
+        ++m_requestCount;
+        passBoundaries();
+    }
+
+    // Matches like execute() on every order in turn, m_batchSize orders per OrderPool::tryExecuteBatch() call. A batch never
+    // runs past an uncross or a snapshot point and is journaled before it is executed. One clock pair times the whole batch,
+    // so every request of it is recorded with the batch's average latency. Fills are buffered while the batch is timed and
+    // reported afterwards, market data is published after each request like in execute().
+    void executeBatch(std::span<BookOrder> orders) {
+        if(m_batchSize == 1) {
+            for(BookOrder& order : orders) {
+                execute(order);
+            }
+            return;
+        }
+        using clock = std::chrono::high_resolution_clock;
+        while(!orders.empty()) {
+            const std::span<BookOrder> batch = orders.first(nextBatchSize(orders.size()));
+            orders = orders.subspan(batch.size());
+            if(UNLIKELY(mp_journal != nullptr)) {
+                for(const BookOrder& order : batch) {
+                    mp_journal->append(order);
+                }
+            }
+            m_batchResults.clear();
+            m_batchFills.clear();
+            auto start = clock::now();
+            m_orderPool.tryExecuteBatch(batch, [this](std::size_t) {
+                m_batchFills.insert(m_batchFills.end(), m_orderPool.fills().begin(), m_orderPool.fills().end());
+                m_batchResults.push_back(BatchResult{m_orderPool.outcome(), m_orderPool.levelsSwept(), m_batchFills.size()});
+                if(UNLIKELY(mp_marketData != nullptr)) {
+                    mp_marketData->publish(m_orderPool);
+                }
+            });
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+            const std::uint64_t perRequest = static_cast<std::uint64_t>(elapsed) / batch.size();
+            std::size_t fillsBegin = 0;
+            for(const BatchResult& result : m_batchResults) {
+                recordLatency(perRequest, result.m_outcome, result.m_levelsSwept);
+                m_reporter.report(std::span<const Fill>(m_batchFills).subspan(fillsBegin, result.m_fillsEnd - fillsBegin));
+                fillsBegin = result.m_fillsEnd;
+            }
+            m_requestCount += batch.size();
+            passBoundaries();
+        }
+    }
+
+    // up to m_batchSize of the available orders, ending at the next uncross or snapshot point
+    [[nodiscard]] std::size_t nextBatchSize(std::size_t available) const noexcept {
+        std::uint64_t size = std::min<std::uint64_t>(available, m_batchSize);
+        for(const std::uint64_t interval : {m_auctionInterval, m_snapshotInterval}) {
+            if(interval) {
+                size = std::min(size, interval - m_requestCount % interval);
+            }
+        }
+        return static_cast<std::size_t>(size);
+    }
+
+    void recordLatency(std::uint64_t nanoseconds, ExecOutcome outcome, unsigned levelsSwept) {
+        m_latency.record(nanoseconds, outcome, levelsSwept);
+        if(UNLIKELY(m_startupLatency.count() < STARTUP_REQUESTS)) {
+            if(!m_startupLatency.count()) {
+                m_firstOrderTime = Common::getCurrentNanos();
+            }
+            m_startupLatency.record(nanoseconds);
+        }
+        if(UNLIKELY(m_latencyInterval)) {
+            m_intervalLatency.record(nanoseconds);
+            if(m_intervalLatency.count() == m_latencyInterval) {
+                m_intervalLatency.print(std::cerr, "Latency(ns) interval ending at request " + std::to_string(m_latency.all().count()));
+                m_intervalLatency.reset();
+            }
+        }
+    }
+
+    // the uncross and the snapshot due once m_requestCount requests are executed
+    void passBoundaries() {
+        if(UNLIKELY(m_auctionInterval) && m_requestCount % m_auctionInterval == 0) {
+            uncross();
+        }
+        if(UNLIKELY(mp_snapshots != nullptr)) {
+            checkpoint();
+        }
+    }
+
+    // one trade line for the whole auction, the book is published like after any request
+    void uncross() {
+        const Common::Nanos start = Common::getCurrentNanos();
+        const AuctionResult result = m_orderPool.uncross();//no reference price, so a restored run clears like the original
+        m_uncrossTime.record(static_cast<std::uint64_t>(Common::getCurrentNanos() - start));
+        ++m_auctionCount;
+        m_auctionVolume += result.m_volume;
+        m_auctionFills += m_orderPool.fills().size();
+        m_reporter.report(m_orderPool.fills());
+        if(UNLIKELY(mp_marketData != nullptr)) {
+            mp_marketData->publish(m_orderPool);
+        }
+    }
+
+    // a snapshot that can't be taken because the previous one is still being written is retried on the next requests
+    void checkpoint() {
+        if(m_snapshotInterval && m_requestCount % m_snapshotInterval == 0) {
+            m_isSnapshotDue = true;
+        }
+        if(mp_isSnapshotRequested && mp_isSnapshotRequested->load(std::memory_order_relaxed)) {
+            mp_isSnapshotRequested->store(false, std::memory_order_relaxed);
+            m_isSnapshotDue = true;
+        }
+        if(m_isSnapshotDue && mp_snapshots->capture(m_orderPool, m_requestCount)) {
+            m_isSnapshotDue = false;
+        }
+    }
+
+    // once the input is exhausted: the last auction, the rest of the journal, the last market data and a snapshot of the final book
+    void finishStages() {
+        if(m_auctionInterval) {
+            if(m_requestCount % m_auctionInterval) {
+                uncross();
+                m_reporter.flush();
+            }
+            std::cout << "Auctions: " << m_auctionCount << " uncrosses, " << m_auctionVolume << " traded in " << m_auctionFills / 2
+                      << " executions, requests collected in " << m_latency.all().sum() << " ns, uncrossed in " << m_uncrossTime.sum()
+                      << " ns" << std::endl;
+            m_uncrossTime.print(std::cout, "Uncross(ns)");
+        }
+        if(mp_journal) {
+            mp_journal->close();
+            m_reporter.setOutputBarrier({});
+            mp_journal.reset();
+        }
+        if(mp_marketData) {
+            mp_marketData->finish(m_orderPool);
+            mp_marketData.reset();
+        }
+        if(mp_snapshots) {
+            mp_snapshots->wait();
+            mp_snapshots->capture(m_orderPool, m_requestCount);
+            mp_snapshots->wait();
+            mp_snapshots->print(std::cout);
+            mp_snapshots.reset();
+        }
+    }
+
+    void dumpStats() const {
+        std::cout << "Orders' total processed time(ns): " << m_latency.all().sum() << std::endl;
+        if(m_launchTime && m_firstOrderTime) {
+            std::cout << "Time to first order(ns): " << m_firstOrderTime - m_launchTime << std::endl;
+        }
+        m_startupLatency.print(std::cout, "Latency(ns) first " + std::to_string(STARTUP_REQUESTS) + " requests");
+        m_latency.print(std::cout);
+        dumpPoolStats();
+    }
+
+    void dumpPoolStats() const {
+        const OrderNodePool& nodes = m_orderPool.nodePool();
+        std::cout << "Order node pool capacity: " << nodes.capacity() << " high-water mark: " << nodes.highWater()
+                  << " grow events: " << nodes.growCount() << std::endl;
+        m_orderPool.arena().print(std::cout, "Level arena");
+    }
+
+    static constexpr std::size_t BINARY_CHUNK_SIZE = 4096;//records converted to orders ahead of matching
+    static constexpr std::uint64_t STARTUP_REQUESTS = 1000;//the first requests after launch get their own histogram
+
+    struct BatchResult {
+        ExecOutcome     m_outcome;
+        unsigned        m_levelsSwept;
+        std::size_t     m_fillsEnd;//of the request's fills in m_batchFills
+    };
+
+    TraderRegistry                              m_traders;
+    LineParser                                  m_lineParser{&m_traders};
     OrderPool<MapContBuy, MapContSell>          m_orderPool;
+    TradeReporter                               m_reporter{STDOUT_FILENO, nullptr, &m_traders};
+    OrderLatencyStats                           m_latency;
+    Common::LatencyHistogram                    m_intervalLatency;
+    Common::LatencyHistogram                    m_startupLatency;//of the first STARTUP_REQUESTS requests
+    Common::Nanos                               m_launchTime = 0;
+    Common::Nanos                               m_firstOrderTime = 0;//when the first request was matched
+    std::uint64_t                               m_latencyInterval = 0;
+    std::size_t                                 m_batchSize = 1;
+    std::vector<BatchResult>                    m_batchResults;
+    std::vector<Fill>                           m_batchFills;
+    std::unique_ptr<MarketDataPublisher>        mp_marketData;
+    std::unique_ptr<BookSnapshotWriter>         mp_snapshots;
+    std::unique_ptr<OrderJournal>               mp_journal;
+    std::uint64_t                               m_snapshotInterval = 0;
+    std::atomic<bool>*                          mp_isSnapshotRequested = nullptr;
+    bool                                        m_isSnapshotDue = false;
+    std::uint64_t                               m_auctionInterval = 0;//requests per call auction, 0 matches continuously
+    std::uint64_t                               m_auctionCount = 0;
+    std::uint64_t                               m_auctionVolume = 0;
+    std::uint64_t                               m_auctionFills = 0;
+    Common::LatencyHistogram                    m_uncrossTime;
+    std::uint64_t                               m_requestCount = 0;//of the whole input, including the requests of a restored snapshot
+    std::uint64_t                               m_skipRequests = 0;//input requests a restored snapshot already reflects
 };
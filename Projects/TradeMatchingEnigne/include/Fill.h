@@ -0,0 +1,10 @@
+#pragma once
+
+// One side of a trade: a trader bought('B') or sold('S') quantity at price through order orderId.
+struct Fill {
+    unsigned    m_traderId;
+    unsigned    m_quantity;
+    unsigned    m_price;
+    char        m_side;
+    unsigned    m_orderId;//of the resting order or of the aggressor, whichever this side is
+};
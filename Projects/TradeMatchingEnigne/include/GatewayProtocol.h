@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include "BinaryOrderStream.h"
+
+// Order entry protocol of the TCP gateway, fixed-width little-endian messages without any framing:
+// clients send BinaryOrderRecord requests(32 bytes) and receive ExecutionReport messages(40 bytes).
+//  - 'B'/'S' requests carry the client's own order reference in m_orderId, the gateway assigns the engine order id.
+//  - 'C'/'M' requests carry the engine order id they refer to, as received in the acknowledgement of the order.
+//  - m_timestamp is opaque to the gateway and echoed in the acknowledgement(e.g. the client's send time).
+// Every request is answered by exactly one acknowledgement, sent after the fills it caused.
+// Fills go to the session that entered the filled order and carry its engine and client order ids.
+// A trader id is bound to the first session sending a request for it until that session closes. Requests of other
+// sessions for it, and new orders once the engine order ids are used up, are acknowledged as ExecOutcome::Rejected
+// with engine order id 0.
+
+constexpr char EXEC_REPORT_ACK = 'A';
+constexpr char EXEC_REPORT_FILL = 'F';
+
+struct ExecutionReport {
+    std::uint64_t   m_orderId;//engine order id of the request or of the filled order
+    std::uint64_t   m_clientOrderId;//m_orderId of the request or of the 'B'/'S' request that entered the filled order
+    std::uint64_t   m_timestamp;//m_timestamp of the request, 0 for fills
+    std::uint32_t   m_traderId;
+    std::uint32_t   m_quantity;//requested quantity or the traded quantity of a fill
+    std::uint32_t   m_price;//requested price or the price of a fill
+    char            m_type;//EXEC_REPORT_ACK or EXEC_REPORT_FILL
+    char            m_side;
+    std::uint8_t    m_outcome;//ExecOutcome of the request, acknowledgements only
+    std::uint8_t    m_reserved;
+};
+static_assert(sizeof(ExecutionReport) == 40);
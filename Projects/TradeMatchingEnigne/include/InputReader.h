@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Macros.h"
+
+namespace Common {
+  /// Hands out input in blocks made of whole lines, without copying when it can be avoided.
+  /// Regular files are mmap'ed and delivered as a single block. Anything else(stdin when path is "-", pipes, FIFOs)
+  /// is read() in large chunks and the trailing partial line of a chunk is carried over into the next one.
+  class InputReader final {
+  public:
+    static constexpr size_t READ_CHUNK_SIZE = 4 * 1024 * 1024;
+
+    /// isPopulated maps a regular file in up front(MAP_POPULATE) rather than page by page while it is parsed.
+    explicit InputReader(const std::string &path, bool isPopulated = false) {
+      m_fd = (path == "-") ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY);
+      m_ownsFd = (path != "-");
+      if (m_fd < 0)
+        return;
+
+      struct stat st{};
+      if (fstat(m_fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        m_mapSize = static_cast<size_t>(st.st_size);
+        if (m_mapSize) {
+          void *map = mmap(nullptr, m_mapSize, PROT_READ, MAP_PRIVATE | (isPopulated ? MAP_POPULATE : 0), m_fd, 0);
+          ASSERT(map != MAP_FAILED, "InputReader: mmap() failed for " + path + " errno:" + std::string(strerror(errno)));
+          madvise(map, m_mapSize, MADV_SEQUENTIAL);
+          madvise(map, m_mapSize, MADV_WILLNEED);
+          mp_map = static_cast<const char *>(map);
+        }
+        return;
+      }
+      mp_buffer = std::make_unique<char[]>(READ_CHUNK_SIZE);
+    }
+
+    ~InputReader() {
+      if (mp_map)
+        munmap(const_cast<char *>(mp_map), m_mapSize);
+      if (m_ownsFd && m_fd >= 0)
+        ::close(m_fd);
+    }
+
+    auto good() const noexcept { return m_fd >= 0; }
+
+    auto isMapped() const noexcept { return mp_buffer == nullptr; }
+
+    /// Next block of input, every line but the last line of the input ends with '\n' inside the block.
+    auto nextBlock(std::string_view &block) -> bool {
+      if (!good())
+        return false;
+      if (isMapped()) {
+        if (m_isMapDelivered || !m_mapSize)
+          return false;
+        m_isMapDelivered = true;
+        block = std::string_view(mp_map, m_mapSize);
+        return true;
+      }
+
+      // move the partial line left from the previous block to the front.
+      if (m_carry)
+        std::memmove(mp_buffer.get(), mp_buffer.get() + m_blockEnd, m_carry);
+      size_t filled = m_carry;
+      m_carry = 0;
+      while (!m_isEof && filled < READ_CHUNK_SIZE) {
+        const ssize_t rc = ::read(m_fd, mp_buffer.get() + filled, READ_CHUNK_SIZE - filled);
+        if (rc < 0) {
+          ASSERT(errno == EINTR, "InputReader: read() failed. errno:" + std::string(strerror(errno)));
+          continue;
+        }
+        if (rc == 0) {
+          m_isEof = true;
+          break;
+        }
+        const auto received = static_cast<size_t>(rc);
+        filled += received;
+        if (std::memchr(mp_buffer.get() + filled - received, '\n', received))
+          break; // at least one whole line is available.
+      }
+      if (!filled)
+        return false;
+
+      m_blockEnd = filled;
+      if (!m_isEof) {
+        const auto lastNewline = static_cast<const char *>(memrchr(mp_buffer.get(), '\n', filled));
+        if (lastNewline) { // otherwise the line doesn't fit into the chunk and is handed out split.
+          m_blockEnd = static_cast<size_t>(lastNewline - mp_buffer.get()) + 1;
+          m_carry = filled - m_blockEnd;
+        }
+      }
+      block = std::string_view(mp_buffer.get(), m_blockEnd);
+      return true;
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    InputReader() = delete;
+
+    InputReader(const InputReader &) = delete;
+
+    InputReader(const InputReader &&) = delete;
+
+    InputReader &operator=(const InputReader &) = delete;
+
+    InputReader &operator=(const InputReader &&) = delete;
+
+  private:
+    int m_fd = -1;
+    bool m_ownsFd = false;
+
+    const char *mp_map = nullptr;
+    size_t m_mapSize = 0;
+    bool m_isMapDelivered = false;
+
+    std::unique_ptr<char[]> mp_buffer;
+    size_t m_blockEnd = 0;
+    size_t m_carry = 0;
+    bool m_isEof = false;
+  };
+}
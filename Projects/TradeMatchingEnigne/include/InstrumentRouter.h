@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+// Interns instrument symbols into dense ids and maps ids onto shards.
+// All storage is fixed at construction: interning a known symbol is a hash plus a short probe, and the name of an id
+// never moves once published, so shard threads can read it while the producer keeps interning new symbols.
+class InstrumentRouter {
+public:
+    static constexpr std::size_t   MAX_INSTRUMENTS = 4096;
+    static constexpr std::size_t   MAX_SYMBOL_LENGTH = 15;
+    static constexpr std::uint16_t INVALID_INSTRUMENT = 0xFFFF;
+
+    InstrumentRouter() :
+        mp_names{std::make_unique<Name[]>(MAX_INSTRUMENTS)}
+    {
+        m_slots.fill(INVALID_INSTRUMENT);
+    }
+
+    // returns INVALID_INSTRUMENT for empty or too long symbols and when the table is full
+    [[nodiscard]] std::uint16_t intern(std::string_view symbol) noexcept {
+        if(symbol.empty() || symbol.size() > MAX_SYMBOL_LENGTH) {
+            return INVALID_INSTRUMENT;
+        }
+        for(std::size_t pos = hash(symbol) & SLOT_MASK;; pos = (pos + 1) & SLOT_MASK) {
+            const std::uint16_t id = m_slots[pos];
+            if(id == INVALID_INSTRUMENT) {
+                if(m_count == MAX_INSTRUMENTS) {
+                    return INVALID_INSTRUMENT;
+                }
+                Name& name = mp_names[m_count];
+                std::memcpy(name.m_chars, symbol.data(), symbol.size());
+                name.m_length = static_cast<std::uint8_t>(symbol.size());
+                m_slots[pos] = static_cast<std::uint16_t>(m_count);
+                return static_cast<std::uint16_t>(m_count++);
+            }
+            if(name(id) == symbol) {
+                return id;
+            }
+        }
+    }
+
+    [[nodiscard]] std::string_view name(std::uint16_t id) const noexcept {
+        return std::string_view(mp_names[id].m_chars, mp_names[id].m_length);
+    }
+
+    [[nodiscard]] static std::size_t shardOf(std::uint16_t id, std::size_t shardCount) noexcept { return id % shardCount; }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_count; }
+
+private:
+    struct Name {
+        char            m_chars[MAX_SYMBOL_LENGTH];
+        std::uint8_t    m_length;
+    };
+
+    static constexpr std::size_t SLOT_COUNT = MAX_INSTRUMENTS * 2;
+    static constexpr std::size_t SLOT_MASK = SLOT_COUNT - 1;
+
+    static std::size_t hash(std::string_view symbol) noexcept {//FNV-1a
+        std::uint64_t h = 0xcbf29ce484222325ull;
+        for(const char c : symbol) {
+            h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        }
+        return static_cast<std::size_t>(h);
+    }
+
+    std::array<std::uint16_t, SLOT_COUNT>   m_slots;
+    std::unique_ptr<Name[]>                 mp_names;
+    std::size_t                             m_count = 0;
+};
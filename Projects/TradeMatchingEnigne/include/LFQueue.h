@@ -4,6 +4,8 @@
 #include <vector>
 #include <atomic>
 
+#include "Macros.h"
+
 namespace Common {
   template<typename T>
   class LFQueue final {
@@ -35,6 +37,10 @@ namespace Common {
       return m_numElements.load();
     }
 
+    auto capacity() const noexcept {
+      return m_storage.size();
+    }
+
     // Deleted default, copy & move constructors and assignment-operators.
     LFQueue() = delete;
 
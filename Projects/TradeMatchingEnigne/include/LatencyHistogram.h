@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string_view>
+
+namespace Common {
+  /// Fixed-memory log-linear histogram of non-negative values(e.g. nanoseconds), in the spirit of HdrHistogram.
+  /// Values below 2^SUB_BUCKET_BITS are counted exactly, above that every power of two is split into 2^SUB_BUCKET_BITS
+  /// equal buckets, so any recorded value is reported within 1/2^SUB_BUCKET_BITS(~3%) of its true value.
+  /// Recording is a bit scan and an increment; histograms of the same type merge by adding counts.
+  class LatencyHistogram final {
+  public:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKET_COUNT = 1ull << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKET_COUNT * (64 - SUB_BUCKET_BITS + 1);
+
+    auto record(uint64_t value) noexcept {
+      ++m_counts[bucketOf(value)];
+      ++m_count;
+      m_sum += value;
+      m_min = std::min(m_min, value);
+      m_max = std::max(m_max, value);
+    }
+
+    auto merge(const LatencyHistogram &other) noexcept {
+      for (size_t i = 0; i < BUCKET_COUNT; ++i)
+        m_counts[i] += other.m_counts[i];
+      m_count += other.m_count;
+      m_sum += other.m_sum;
+      m_min = std::min(m_min, other.m_min);
+      m_max = std::max(m_max, other.m_max);
+    }
+
+    auto reset() noexcept {
+      *this = LatencyHistogram{};
+    }
+
+    /// Highest value equivalent to the bucket holding the p-th fraction(0..1) of the recorded values, capped by max().
+    auto percentile(double p) const noexcept -> uint64_t {
+      if (!m_count)
+        return 0;
+      const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * static_cast<double>(m_count) + 0.5));
+      uint64_t seen = 0;
+      for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += m_counts[i];
+        if (seen >= rank)
+          return std::min(highestEquivalent(i), m_max);
+      }
+      return m_max;
+    }
+
+    auto count() const noexcept { return m_count; }
+    auto sum() const noexcept { return m_sum; }
+    auto min() const noexcept { return m_count ? m_min : 0; }
+    auto max() const noexcept { return m_max; }
+    auto mean() const noexcept { return m_count ? static_cast<double>(m_sum) / static_cast<double>(m_count) : 0.0; }
+
+    /// One line: "<name> count: .. p50: .. p90: .. p99: .. p99.9: .. max: ..".
+    auto print(std::ostream &os, std::string_view name) const -> std::ostream & {
+      return os << name << " count: " << m_count << " p50: " << percentile(0.5) << " p90: " << percentile(0.9)
+                << " p99: " << percentile(0.99) << " p99.9: " << percentile(0.999) << " max: " << m_max << '\n';
+    }
+
+  private:
+    static constexpr auto bucketOf(uint64_t value) noexcept -> size_t {
+      if (value < SUB_BUCKET_COUNT)
+        return static_cast<size_t>(value);
+      const unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS;
+      return static_cast<size_t>(SUB_BUCKET_COUNT * (shift + 1) + (value >> shift) - SUB_BUCKET_COUNT);
+    }
+
+    static constexpr auto highestEquivalent(size_t bucket) noexcept -> uint64_t {
+      if (bucket < SUB_BUCKET_COUNT)
+        return bucket;
+      const uint64_t shift = bucket / SUB_BUCKET_COUNT - 1;
+      const uint64_t low = (SUB_BUCKET_COUNT + bucket % SUB_BUCKET_COUNT) << shift;
+      return low + ((1ull << shift) - 1);
+    }
+
+    std::array<uint64_t, BUCKET_COUNT> m_counts{};
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_min = std::numeric_limits<uint64_t>::max();
+    uint64_t m_max = 0;
+  };
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <flat_map>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+#include <absl/container/btree_map.h>
+
+#include "OrderNodePool.h"
+
+// Price level containers of the map backends, allocating through std::pmr::polymorphic_allocator. OrderPool constructs
+// them on its own ArenaResource, so level inserts and erases recycle arena blocks instead of calling malloc.
+template<class Compare = std::less<unsigned>>
+using PmrStdMap = std::pmr::map<unsigned, OrderLevel, Compare>;
+
+template<class Compare = std::less<unsigned>>
+using PmrBtreeMap = absl::btree_map<unsigned, OrderLevel, Compare, std::pmr::polymorphic_allocator<std::pair<const unsigned, OrderLevel>>>;
+
+template<class Compare = std::less<unsigned>>
+using PmrFlatMap = std::flat_map<unsigned, OrderLevel, Compare, std::pmr::vector<unsigned>, std::pmr::vector<OrderLevel>>;
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "BookOrder.h"
+#include "Macros.h"
+#include "TraderRegistry.h"
+
+// Parses request lines into orders:
+// <Trader Identifier> <B|S> <Quantity> <Price>, <Trader Identifier> C <Order Id> or <Trader Identifier> M <Order Id> <Quantity> <Price>
+class LineParser {
+public:
+    // alphanumeric trader identifiers are interned into traders, without it only numeric ones are valid
+    explicit LineParser(TraderRegistry* traders = nullptr) noexcept :
+        mp_traders{traders}
+    {}
+
+    BookOrder process(const std::string& line) {
+        return process(line.data(), line.data() + line.size());
+    }
+    //parsed straight from the input bytes [begin, end) of one line
+    BookOrder process(const char* begin, const char* end) {
+        if(UNLIKELY(m_seqNo == MAX_ORDER_ID)) {//the next id would wrap to 0 and alias the first orders
+            if(!m_isExhausted) {
+                std::cerr << "Order ids exhausted: a run takes at most " << MAX_ORDER_ID << " requests, ignoring the rest of the input\n";
+                m_isExhausted = true;
+            }
+            return BookOrder{};//invalid order
+        }
+        ++m_seqNo;
+        if(UNLIKELY(begin == end)) {
+            std::cerr << "Invalid input. Exiting.\n";
+            return BookOrder{};//invalid order
+        }
+        unsigned trId{}; char side{}; unsigned quantity{}; unsigned price{}; unsigned orderId{m_seqNo};
+        if(parseTrader(begin, end, trId) && parseChar(begin, end, side)) {
+            if(side == 'C') {
+                parseNumber(begin, end, orderId);
+            } else if(side == 'M') {
+                parseNumber(begin, end, orderId) && parseNumber(begin, end, quantity) && parseNumber(begin, end, price);
+            } else {
+                parseNumber(begin, end, quantity) && parseNumber(begin, end, price);
+            }
+        }
+        return makeOrder(trId, side, quantity, price, orderId);
+    }
+    void setDbgMode(const bool flag) noexcept { m_dbgMode = flag; }
+    // in debug mode orders priced outside the band the book can hold are reported too, the book rejects them
+    void setPriceBand(bool (*isInBand)(unsigned) noexcept) noexcept { mp_isInBand = isInBand; }
+    // numbering continues after seqNo requests, e.g. the ones a restored book already reflects
+    void setSequence(unsigned seqNo) noexcept { m_seqNo = seqNo; }
+    //builds the order and reports it in debug mode if it isn't valid
+    BookOrder makeOrder(unsigned trId, char side, unsigned quantity, unsigned price, unsigned orderId) const {
+        BookOrder tmp{trId, quantity, price, side, orderId};
+        if(!tmp.isValid() || (mp_isInBand && side != 'C' && !mp_isInBand(price))) {
+            if(m_dbgMode) {
+            std::cerr << "Invalid order. Dumping the order(id, side, quantity, price, order id): " << trId <<" "<< side <<" "<< quantity<<" "<< price<<" "<< orderId<<'\n';
+            }
+        }
+        return tmp;
+    }
+private:
+    static bool isBlank(char c) noexcept { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+    static void skipBlanks(const char*& pos, const char* end) noexcept {
+        while(pos != end && isBlank(*pos)) {
+            ++pos;
+        }
+    }
+    //like istream extraction a malformed field leaves 0 and stops parsing of the rest of the line
+    static bool parseNumber(const char*& pos, const char* end, unsigned& value) noexcept {
+        skipBlanks(pos, end);
+        std::uint64_t acc = 0;
+        const char* start = pos;
+        for(; pos != end && static_cast<unsigned char>(*pos - '0') < 10; ++pos) {
+            acc = acc * 10 + static_cast<unsigned>(*pos - '0');
+            if(UNLIKELY(acc > std::numeric_limits<unsigned>::max())) {
+                value = 0;
+                return false;
+            }
+        }
+        value = static_cast<unsigned>(acc);
+        return pos != start;
+    }
+    //"T<N>" without leading zeros and a bare number(the legacy form) are trader N, any other token is a name interned into
+    //mp_traders, so "T7" and "7" are the same trader and are reported as T7 like before
+    bool parseTrader(const char*& pos, const char* end, unsigned& value) {
+        skipBlanks(pos, end);
+        const char* const start = pos;
+        while(pos != end && !isBlank(*pos)) {
+            ++pos;
+        }
+        const char* digit = (pos - start > 1 && *start == 'T' && start[1] != '0') ? start + 1 : start;
+        std::uint64_t acc = 0;
+        for(; digit != pos && static_cast<unsigned char>(*digit - '0') < 10; ++digit) {
+            if(acc < TraderRegistry::INTERNED_BIT) {
+                acc = acc * 10 + static_cast<unsigned>(*digit - '0');
+            }
+        }
+        if(LIKELY(digit == pos && pos != start)) {//numeric, ids from INTERNED_BIT on belong to names
+            value = (acc < TraderRegistry::INTERNED_BIT) ? static_cast<unsigned>(acc) : 0;
+            return value || acc == 0;
+        }
+        value = mp_traders ? mp_traders->intern(std::string_view(start, static_cast<std::size_t>(pos - start))) : 0;
+        return value != 0;
+    }
+    static bool parseChar(const char*& pos, const char* end, char& value) noexcept {
+        skipBlanks(pos, end);
+        if(pos == end) {
+            return false;
+        }
+        value = *pos++;
+        return true;
+    }
+    TraderRegistry* mp_traders;
+    bool (*mp_isInBand)(unsigned) noexcept = nullptr;
+    bool m_dbgMode = false;
+    bool m_isExhausted = false;
+    unsigned m_seqNo = 0;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Macros.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace Common {
+  namespace detail {
+    inline auto scanNewlinesScalar(const char *data, size_t len, uint32_t *out) noexcept -> size_t {
+      size_t count = 0;
+      for (size_t i = 0; i < len; ++i) {
+        if (data[i] == '\n')
+          out[count++] = static_cast<uint32_t>(i);
+      }
+      return count;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    /// Compares 16 bytes per step and walks the set bits of the resulting mask.
+    inline auto scanNewlinesSSE2(const char *data, size_t len, uint32_t *out) noexcept -> size_t {
+      const __m128i newline = _mm_set1_epi8('\n');
+      size_t count = 0;
+      size_t i = 0;
+      for (; i + 16 <= len; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+        while (mask) {
+          out[count++] = static_cast<uint32_t>(i + std::countr_zero(mask));
+          mask &= mask - 1;
+        }
+      }
+      const size_t tail = scanNewlinesScalar(data + i, len - i, out + count);
+      for (size_t k = count; k < count + tail; ++k)
+        out[k] += static_cast<uint32_t>(i);
+      return count + tail;
+    }
+
+    /// Same as SSE2 version with 32 bytes per step, compiled for AVX2 regardless of the global -march.
+    __attribute__((target("avx2"))) inline auto scanNewlinesAVX2(const char *data, size_t len, uint32_t *out) noexcept -> size_t {
+      const __m256i newline = _mm256_set1_epi8('\n');
+      size_t count = 0;
+      size_t i = 0;
+      for (; i + 32 <= len; i += 32) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)));
+        while (mask) {
+          out[count++] = static_cast<uint32_t>(i + std::countr_zero(mask));
+          mask &= mask - 1;
+        }
+      }
+      const size_t tail = scanNewlinesSSE2(data + i, len - i, out + count);
+      for (size_t k = count; k < count + tail; ++k)
+        out[k] += static_cast<uint32_t>(i);
+      return count + tail;
+    }
+#endif
+
+    using ScanNewlinesFn = size_t (*)(const char *, size_t, uint32_t *) noexcept;
+
+    inline auto pickScanNewlines() noexcept -> ScanNewlinesFn {
+#if defined(__x86_64__) || defined(__i386__)
+      if (__builtin_cpu_supports("avx2"))
+        return scanNewlinesAVX2;
+      return scanNewlinesSSE2;
+#else
+      return scanNewlinesScalar;
+#endif
+    }
+  }
+
+  /// Writes offsets of all '\n' bytes of data[0, len) into out and returns their count.
+  /// out must have room for len entries. The widest byte scan supported by the CPU is picked once at first use.
+  inline auto scanNewlines(const char *data, size_t len, uint32_t *out) noexcept -> size_t {
+    static const detail::ScanNewlinesFn scan = detail::pickScanNewlines();
+    return scan(data, len, out);
+  }
+
+  constexpr size_t LINE_SCAN_CHUNK_SIZE = 64 * 1024;
+
+  /// Calls onLine(begin, end) for every line of block(terminators excluded, an unterminated last line included)
+  /// and onChunk() once the lines of a LINE_SCAN_CHUNK_SIZE chunk are done. newlines must hold LINE_SCAN_CHUNK_SIZE entries.
+  template<typename L, typename C>
+  inline auto forEachLine(std::string_view block, uint32_t *newlines, L &&onLine, C &&onChunk) {
+    const char *chunk = block.data();
+    const char *const blockEnd = block.data() + block.size();
+    while (chunk != blockEnd) {
+      const size_t chunkLen = std::min<size_t>(LINE_SCAN_CHUNK_SIZE, static_cast<size_t>(blockEnd - chunk));
+      const size_t count = scanNewlines(chunk, chunkLen, newlines);
+      const char *lineBegin = chunk;
+      for (size_t i = 0; i < count; ++i) {
+        onLine(lineBegin, chunk + newlines[i]);
+        lineBegin = chunk + newlines[i] + 1;
+      }
+      const bool isLastChunk = (chunk + chunkLen == blockEnd);
+      if (UNLIKELY((isLastChunk && lineBegin != blockEnd) || count == 0)) { // unterminated last line or a line longer than a chunk.
+        const char *lineEnd = isLastChunk ? blockEnd : chunk + chunkLen;
+        onLine(lineBegin, lineEnd);
+        lineBegin = lineEnd;
+      }
+      onChunk();
+      chunk = lineBegin;
+    }
+  }
+}
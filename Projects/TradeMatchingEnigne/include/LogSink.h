@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "Macros.h"
+#include "TimeUtils.h"
+
+namespace Common {
+  enum class LogSinkMode : uint8_t {
+    WRITEV = 0, // formatted output is gathered in large buffers written with one writev() call.
+    MMAP = 1    // formatted output is copied into a pre-extended, shared mapping of the file.
+  };
+
+  enum class FsyncPolicy : uint8_t {
+    NEVER = 0,      // the kernel writes back whenever it likes.
+    ON_ROTATE = 1,  // a file is synced when it is closed by rotation or at exit.
+    INTERVAL = 2,   // also at most every m_fsyncInterval while logging.
+    EVERY_FLUSH = 3 // also whenever the sink flushes(e.g. the Logger thread going idle).
+  };
+
+  struct LogSinkConfig {
+    std::string m_fileName = "tradeMatchingEngine.log";
+    LogSinkMode m_mode = LogSinkMode::WRITEV;
+    size_t m_rotateBytes = 0;   // the file is rotated at the first line end past this size, 0 never rotates.
+    unsigned m_keptFiles = 4;   // rotated files are <name>.1(newest) .. <name>.<m_keptFiles>, older ones are dropped.
+    FsyncPolicy m_fsync = FsyncPolicy::NEVER;
+    Nanos m_fsyncInterval = 100 * NANOS_TO_MILLIS;
+  };
+
+  inline auto logSinkModeByName(std::string_view name, LogSinkMode &mode) noexcept {
+    if (name == "writev")
+      mode = LogSinkMode::WRITEV;
+    else if (name == "mmap")
+      mode = LogSinkMode::MMAP;
+    else
+      return false;
+    return true;
+  }
+
+  inline auto fsyncPolicyByName(std::string_view name, FsyncPolicy &policy) noexcept {
+    if (name == "never")
+      policy = FsyncPolicy::NEVER;
+    else if (name == "rotate")
+      policy = FsyncPolicy::ON_ROTATE;
+    else if (name == "interval")
+      policy = FsyncPolicy::INTERVAL;
+    else if (name == "flush")
+      policy = FsyncPolicy::EVERY_FLUSH;
+    else
+      return false;
+    return true;
+  }
+
+  /// Append-only log file written in large batches: a few syscalls per megabytes of output instead of one per flush of
+  /// a stream. Used by a single thread(the Logger thread). Rotation happens on line boundaries so every file holds whole
+  /// lines; a file may exceed m_rotateBytes by the rest of the line that crossed it.
+  class LogSink final {
+  public:
+    static constexpr size_t BUFFER_SIZE = 256 * 1024;
+    static constexpr size_t BUFFER_COUNT = 8;
+    static constexpr size_t MAP_CHUNK_SIZE = 16 * 1024 * 1024; // the file grows and is remapped by this much, page aligned.
+
+    explicit LogSink(const LogSinkConfig &config) :
+        m_config(config) {
+      if (m_config.m_mode == LogSinkMode::WRITEV) {
+        for (auto &buffer : m_buffers)
+          buffer = std::make_unique<char[]>(BUFFER_SIZE);
+      }
+      open();
+    }
+
+    ~LogSink() {
+      close();
+    }
+
+    auto append(const char *data, size_t size) noexcept -> void {
+      while (UNLIKELY(m_isRotationDue)) {
+        const auto lineEnd = static_cast<const char *>(std::memchr(data, '\n', size));
+        if (!lineEnd)
+          break;
+        const size_t head = static_cast<size_t>(lineEnd - data) + 1;
+        appendRaw(data, head);
+        rotate();
+        data += head;
+        size -= head;
+      }
+      appendRaw(data, size);
+      m_isRotationDue = m_config.m_rotateBytes && fileSize() >= m_config.m_rotateBytes;
+    }
+
+    auto append(std::string_view text) noexcept {
+      append(text.data(), text.size());
+    }
+
+    auto append(char c) noexcept {
+      append(&c, 1);
+    }
+
+    /// Integers in decimal, floating point values as printf's %g(the default format of std::ostream).
+    template<typename T>
+    auto appendNumber(T value) noexcept {
+      char text[32];
+      std::to_chars_result result;
+      if constexpr (std::is_floating_point_v<T>)
+        result = std::to_chars(text, text + sizeof(text), value, std::chars_format::general, 6);
+      else
+        result = std::to_chars(text, text + sizeof(text), value);
+      append(text, static_cast<size_t>(result.ptr - text));
+    }
+
+    /// Hands the buffered output to the kernel and syncs it as the policy asks.
+    auto flush() noexcept -> void {
+      if (m_config.m_mode == LogSinkMode::WRITEV)
+        writeBuffers();
+      if (m_config.m_fsync == FsyncPolicy::EVERY_FLUSH)
+        sync();
+      else
+        syncIfDue();
+    }
+
+    /// Bytes of the current file including the ones still buffered.
+    auto fileSize() const noexcept -> size_t {
+      if (m_config.m_mode == LogSinkMode::WRITEV)
+        return m_writtenBytes + m_current * BUFFER_SIZE + m_used;
+      return m_mapOffset + m_used;
+    }
+
+    auto rotations() const noexcept {
+      return m_rotations;
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    LogSink() = delete;
+
+    LogSink(const LogSink&) = delete;
+
+    LogSink(const LogSink&&) = delete;
+
+    LogSink &operator=(const LogSink&) = delete;
+
+    LogSink &operator=(const LogSink&&) = delete;
+
+  private:
+    auto open() noexcept -> void {
+      const int flags = (m_config.m_mode == LogSinkMode::MMAP) ? O_RDWR : O_WRONLY;
+      m_fd = ::open(m_config.m_fileName.c_str(), flags | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      ASSERT(m_fd >= 0, "Could not open log file:" + m_config.m_fileName + " " + std::strerror(errno));
+      m_writtenBytes = 0;
+      m_current = 0;
+      m_used = 0;
+      m_mapOffset = 0;
+      if (m_config.m_mode == LogSinkMode::MMAP)
+        mapChunk();
+    }
+
+    auto close() noexcept -> void {
+      if (m_fd < 0)
+        return;
+      if (m_config.m_mode == LogSinkMode::WRITEV) {
+        writeBuffers();
+      } else {
+        ::munmap(mp_map, MAP_CHUNK_SIZE);
+        mp_map = nullptr;
+        if (::ftruncate(m_fd, static_cast<off_t>(m_mapOffset + m_used)) != 0) // drop the unused, pre-extended tail.
+          reportError("ftruncate");
+      }
+      if (m_config.m_fsync != FsyncPolicy::NEVER)
+        sync();
+      ::close(m_fd);
+      m_fd = -1;
+    }
+
+    /// <name> -> <name>.1 -> ... -> <name>.<m_keptFiles>, then a fresh <name>.
+    auto rotate() noexcept -> void {
+      close();
+      if (m_config.m_keptFiles) {
+        for (unsigned i = m_config.m_keptFiles - 1; i > 0; --i) {
+          const std::string from = m_config.m_fileName + "." + std::to_string(i);
+          std::rename(from.c_str(), (m_config.m_fileName + "." + std::to_string(i + 1)).c_str());
+        }
+        std::rename(m_config.m_fileName.c_str(), (m_config.m_fileName + ".1").c_str());
+      }
+      open();
+      m_isRotationDue = false;
+      ++m_rotations;
+    }
+
+    auto appendRaw(const char *data, size_t size) noexcept -> void {
+      while (size) {
+        size_t room;
+        char *destination;
+        if (m_config.m_mode == LogSinkMode::WRITEV) {
+          if (m_used == BUFFER_SIZE) {
+            if (m_current + 1 == BUFFER_COUNT)
+              writeBuffers();
+            else {
+              ++m_current;
+              m_used = 0;
+            }
+          }
+          room = BUFFER_SIZE - m_used;
+          destination = m_buffers[m_current].get() + m_used;
+        } else {
+          if (m_used == MAP_CHUNK_SIZE) {
+            ::munmap(mp_map, MAP_CHUNK_SIZE);
+            m_mapOffset += MAP_CHUNK_SIZE;
+            m_used = 0;
+            mapChunk();
+            syncIfDue();
+          }
+          room = MAP_CHUNK_SIZE - m_used;
+          destination = mp_map + m_used;
+        }
+        const size_t n = std::min(room, size);
+        std::memcpy(destination, data, n);
+        m_used += n;
+        data += n;
+        size -= n;
+      }
+    }
+
+    /// All filled buffers in one writev(), resumed after partial writes.
+    auto writeBuffers() noexcept -> void {
+      std::array<iovec, BUFFER_COUNT> vectors;
+      int count = 0;
+      for (size_t i = 0; i <= m_current; ++i) {
+        const size_t size = (i == m_current) ? m_used : BUFFER_SIZE;
+        if (size)
+          vectors[count++] = {m_buffers[i].get(), size};
+      }
+      iovec *next = vectors.data();
+      while (count) {
+        const ssize_t written = ::writev(m_fd, next, count);
+        if (written < 0) {
+          if (errno == EINTR)
+            continue;
+          reportError("writev"); // the batch is dropped rather than blocking the Logger forever.
+          break;
+        }
+        m_writtenBytes += static_cast<size_t>(written);
+        size_t left = static_cast<size_t>(written);
+        while (count && left >= next->iov_len) {
+          left -= next->iov_len;
+          ++next;
+          --count;
+        }
+        if (count && left) {
+          next->iov_base = static_cast<char *>(next->iov_base) + left;
+          next->iov_len -= left;
+        }
+      }
+      m_current = 0;
+      m_used = 0;
+      if (m_config.m_fsync == FsyncPolicy::INTERVAL)
+        syncIfDue();
+    }
+
+    auto mapChunk() noexcept -> void {
+      if (::ftruncate(m_fd, static_cast<off_t>(m_mapOffset + MAP_CHUNK_SIZE)) != 0)
+        FATAL("Could not extend log file:" + m_config.m_fileName + " " + std::strerror(errno));
+      void *map = ::mmap(nullptr, MAP_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, static_cast<off_t>(m_mapOffset));
+      if (map == MAP_FAILED)
+        FATAL("Could not map log file:" + m_config.m_fileName + " " + std::strerror(errno));
+      mp_map = static_cast<char *>(map);
+    }
+
+    auto syncIfDue() noexcept -> void {
+      if (m_config.m_fsync == FsyncPolicy::INTERVAL && getCurrentNanos() - m_lastSync >= m_config.m_fsyncInterval)
+        sync();
+    }
+
+    /// fdatasync() also writes back the pages dirtied through the mapping.
+    auto sync() noexcept -> void {
+      if (::fdatasync(m_fd) != 0)
+        reportError("fdatasync");
+      m_lastSync = getCurrentNanos();
+    }
+
+    auto reportError(const char *call) noexcept -> void {
+      if (!m_isErrorReported)
+        std::cerr << "LogSink " << call << " failed on " << m_config.m_fileName << ": " << std::strerror(errno) << std::endl;
+      m_isErrorReported = true;
+    }
+
+    const LogSinkConfig m_config;
+    int m_fd = -1;
+
+    std::array<std::unique_ptr<char[]>, BUFFER_COUNT> m_buffers; // WRITEV: m_buffers[0..m_current] hold pending output.
+    size_t m_current = 0;
+    size_t m_writtenBytes = 0;
+
+    char *mp_map = nullptr; // MMAP: file bytes [m_mapOffset, m_mapOffset + MAP_CHUNK_SIZE).
+    size_t m_mapOffset = 0;
+
+    size_t m_used = 0; // bytes used in the current buffer or mapping.
+    bool m_isRotationDue = false;
+    bool m_isErrorReported = false;
+    Nanos m_lastSync = 0;
+    size_t m_rotations = 0;
+  };
+}
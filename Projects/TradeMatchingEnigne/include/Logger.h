@@ -1,99 +1,121 @@
 #pragma once
 
-#include <string>
-#include <fstream>
+#include <array>
+#include <atomic>
 #include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
 
+#include "LogSink.h"
 #include "Macros.h"
-#include "LFQueue.h"
+#include "SPSCByteRing.h"
 #include "ThreadUtils.h"
 #include "TimeUtils.h"
 
 namespace Common {
-  constexpr size_t LOG_QUEUE_SIZE = 8 * 1024 * 1024;
+  constexpr size_t LOG_RING_SIZE = 8 * 1024 * 1024; // bytes per producing thread.
+  constexpr size_t MAX_LOG_PRODUCERS = 64;
 
-  enum class LogType : int8_t {
+  enum class LogType : uint8_t {
     CHAR = 0,
-    INTEGER = 1,
-    LONG_INTEGER = 2,
-    LONG_LONG_INTEGER = 3,
-    UNSIGNED_INTEGER = 4,
-    UNSIGNED_LONG_INTEGER = 5,
-    UNSIGNED_LONG_LONG_INTEGER = 6,
-    FLOAT = 7,
-    DOUBLE = 8
+    BOOL = 1,
+    INTEGER = 2,          // any signed integer, widened to 64 bits.
+    UNSIGNED_INTEGER = 3, // any unsigned integer, widened to 64 bits.
+    FLOAT = 4,
+    DOUBLE = 5,
+    STRING = 6            // 32 bit length followed by the characters.
   };
 
-  struct LogElement {
-    LogType m_type = LogType::CHAR;
-    union {
-      char c;
-      int i;
-      long l;
-      long long ll;
-      unsigned u;
-      unsigned long ul;
-      unsigned long long ull;
-      float f;
-      double d;
-    } u_logElem;
+  /// Start of every record: the format string is not copied, so it must outlive the Logger(a literal, in practice).
+  struct LogRecordHeader {
+    const char *m_format;
+    Nanos m_timestamp;
+    uint32_t m_argumentCount;
   };
 
-  class Logger final {
-  public:
-    static Logger& getInstance() {
-        static Logger instance("tradeMatchingEngine.log");
-        return instance;
+  namespace detail {
+    template<typename T>
+    constexpr auto logTypeOf() noexcept {
+      using D = std::decay_t<T>;
+      if constexpr (std::is_same_v<D, bool>)
+        return LogType::BOOL;
+      else if constexpr (std::is_same_v<D, char>)
+        return LogType::CHAR;
+      else if constexpr (std::is_convertible_v<const T &, std::string_view>)
+        return LogType::STRING;
+      else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>)
+        return LogType::INTEGER;
+      else if constexpr (std::is_integral_v<D>)
+        return LogType::UNSIGNED_INTEGER;
+      else if constexpr (std::is_same_v<D, float>)
+        return LogType::FLOAT;
+      else {
+        static_assert(std::is_same_v<D, double>, "unsupported log() argument type");
+        return LogType::DOUBLE;
+      }
     }
-  private:
-    auto flushQueue() noexcept {
-      while (m_running) {
 
-        for (auto next = m_queue.getNextToRead(); m_queue.size() && next; next = m_queue.getNextToRead()) {
-          switch (next->m_type) {
-            case LogType::CHAR:
-              m_file << next->u_logElem.c;
-              break;
-            case LogType::INTEGER:
-              m_file << next->u_logElem.i;
-              break;
-            case LogType::LONG_INTEGER:
-              m_file << next->u_logElem.l;
-              break;
-            case LogType::LONG_LONG_INTEGER:
-              m_file << next->u_logElem.ll;
-              break;
-            case LogType::UNSIGNED_INTEGER:
-              m_file << next->u_logElem.u;
-              break;
-            case LogType::UNSIGNED_LONG_INTEGER:
-              m_file << next->u_logElem.ul;
-              break;
-            case LogType::UNSIGNED_LONG_LONG_INTEGER:
-              m_file << next->u_logElem.ull;
-              break;
-            case LogType::FLOAT:
-              m_file << next->u_logElem.f;
-              break;
-            case LogType::DOUBLE:
-              m_file << next->u_logElem.d;
-              break;
-          }
-          m_queue.updateReadIndex();
-        }
-        m_file.flush();
+    template<typename T>
+    constexpr auto logPayloadSize(const T &value) noexcept -> size_t {
+      constexpr LogType type = logTypeOf<T>();
+      if constexpr (type == LogType::STRING)
+        return sizeof(uint32_t) + std::string_view(value).size();
+      else if constexpr (type == LogType::INTEGER || type == LogType::UNSIGNED_INTEGER)
+        return sizeof(uint64_t);
+      else
+        return sizeof(std::decay_t<T>);
+    }
 
-        using namespace std::literals::chrono_literals;
-        std::this_thread::sleep_for(10ms);
+    template<typename T>
+    inline auto writeLogArgument(char *&position, const T &value) noexcept {
+      constexpr LogType type = logTypeOf<T>();
+      *position++ = static_cast<char>(type);
+      if constexpr (type == LogType::STRING) {
+        const std::string_view text(value);
+        const auto length = static_cast<uint32_t>(text.size());
+        std::memcpy(position, &length, sizeof(length));
+        std::memcpy(position + sizeof(length), text.data(), text.size());
+        position += sizeof(length) + text.size();
+      } else {
+        const auto stored = [&value] {
+          if constexpr (type == LogType::INTEGER)
+            return static_cast<int64_t>(value);
+          else if constexpr (type == LogType::UNSIGNED_INTEGER)
+            return static_cast<uint64_t>(value);
+          else
+            return value;
+        }();
+        std::memcpy(position, &stored, sizeof(stored));
+        position += sizeof(stored);
       }
     }
+  }
+
+  /// Asynchronous logger with deferred formatting. log() copies the format string pointer, a timestamp and the raw
+  /// argument bytes(strings inline) into one record of the calling thread's ring; the logger thread expands the % place
+  /// holders into a LogSink. Every line is prefixed with the local time of the record that started it.
+  class Logger final {
+  public:
+    /// The sink configuration of the first call creates the instance, later calls get that instance.
+    static Logger& getInstance(const LogSinkConfig &config = LogSinkConfig{}) {
+        static Logger instance(config);
+        return instance;
+    }
 
     explicit Logger(const std::string &fileName):
-        m_fileName(fileName), 
-        m_queue(LOG_QUEUE_SIZE) {
-        m_file.open(m_fileName);
-        ASSERT(m_file.is_open(), "Could not open log file:" + m_fileName);
-        mp_loggerThread = createAndStartThread(-1, "Common/Logger " + m_fileName, [this]() { flushQueue(); });
+        Logger(LogSinkConfig{.m_fileName = fileName}) {
+    }
+
+    explicit Logger(const LogSinkConfig &config):
+        m_fileName(config.m_fileName),
+        m_sink(config) {
+        mp_loggerThread = createAndStartThread(-1, "Common/Logger " + m_fileName, [this]() { flushRings(); });
         ASSERT(mp_loggerThread != nullptr, "Failed to start Logger thread.");
     }
 
@@ -101,116 +123,204 @@ namespace Common {
       std::string time_str;
       std::cerr << Common::getCurrentTimeStr(&time_str) << " Flushing and closing Logger for " << m_fileName << std::endl;
 
-      while (m_queue.size()) {
-        using namespace std::literals::chrono_literals;
-        std::this_thread::sleep_for(1s);
-      }
       m_running = false;
       mp_loggerThread->join();
+      delete mp_loggerThread;
+      while (drainRings()) // producers are done, this thread is the consumer now.
+        ;
+      m_sink.flush();
 
-      m_file.close();
       std::cerr << Common::getCurrentTimeStr(&time_str) << " Logger for " << m_fileName << " exiting." << std::endl;
     }
 
-    auto pushValue(const LogElement &log_element) noexcept {
-      *(m_queue.getNextToWriteTo()) = log_element;
-      m_queue.updateWriteIndex();
+    /// Every % in format is substituted by the next argument, %% is an escaped %.
+    template<typename... A>
+    auto log(const char *format, const A &... args) noexcept {
+      const size_t size = sizeof(LogRecordHeader) + ((1 + detail::logPayloadSize(args)) + ... + 0);
+      SPSCByteRing &ring = producerRing();
+      if (UNLIKELY(size > ring.maxPayload()))
+        FATAL("log() record too large");
+
+      char *position;
+      unsigned spins = 0;
+      while (UNLIKELY(!(position = ring.tryReserve(size)))) // wait for the logger thread rather than drop the record.
+        spinWait(spins);
+
+      const LogRecordHeader header{format, getCurrentNanos(), static_cast<uint32_t>(sizeof...(A))};
+      std::memcpy(position, &header, sizeof(header));
+      position += sizeof(header);
+      (detail::writeLogArgument(position, args), ...);
+      ring.commitWrite();
     }
 
-    auto pushValue(const char value) noexcept {
-      pushValue(LogElement{LogType::CHAR, {.c = value}});
-    }
-
-    auto pushValue(const int value) noexcept {
-      pushValue(LogElement{LogType::INTEGER, {.i = value}});
-    }
+    // Deleted default, copy & move constructors and assignment-operators.
+    Logger() = delete;
 
-    auto pushValue(const long value) noexcept {
-      pushValue(LogElement{LogType::LONG_INTEGER, {.l = value}});
-    }
+    Logger(const Logger&) = delete;
 
-    auto pushValue(const long long value) noexcept {
-      pushValue(LogElement{LogType::LONG_LONG_INTEGER, {.ll = value}});
-    }
+    Logger(const Logger&&) = delete;
 
-    auto pushValue(const unsigned value) noexcept {
-      pushValue(LogElement{LogType::UNSIGNED_INTEGER, {.u = value}});
-    }
+    Logger &operator=(const Logger&) = delete;
 
-    auto pushValue(const unsigned long value) noexcept {
-      pushValue(LogElement{LogType::UNSIGNED_LONG_INTEGER, {.ul = value}});
-    }
+    Logger &operator=(const Logger&&) = delete;
 
-    auto pushValue(const unsigned long long value) noexcept {
-      pushValue(LogElement{LogType::UNSIGNED_LONG_LONG_INTEGER, {.ull = value}});
+  private:
+    /// The calling thread's ring, registered on its first log() call to this logger.
+    auto producerRing() -> SPSCByteRing & {
+      thread_local uint64_t t_loggerId = 0;
+      thread_local SPSCByteRing *tp_ring = nullptr;
+      if (UNLIKELY(t_loggerId != m_id)) {
+        tp_ring = &registerProducer();
+        t_loggerId = m_id;
+      }
+      return *tp_ring;
     }
 
-    auto pushValue(const float value) noexcept {
-      pushValue(LogElement{LogType::FLOAT, {.f = value}});
+    auto registerProducer() -> SPSCByteRing & {
+      std::lock_guard lock(m_registrationMutex);
+      const size_t count = m_ringCount.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < count; ++i) {
+        if (m_producers[i] == std::this_thread::get_id())
+          return *m_rings[i];
+      }
+      if (count == MAX_LOG_PRODUCERS)
+        FATAL("too many threads logging to " + m_fileName);
+      m_rings[count] = std::make_unique<SPSCByteRing>(LOG_RING_SIZE);
+      m_producers[count] = std::this_thread::get_id();
+      m_ringCount.store(count + 1, std::memory_order_release);
+      return *m_rings[count];
     }
 
-    auto pushValue(const double value) noexcept {
-      pushValue(LogElement{LogType::DOUBLE, {.d = value}});
+    auto flushRings() noexcept -> void {
+      while (m_running) {
+        if (!drainRings()) {
+          m_sink.flush();
+          using namespace std::literals::chrono_literals;
+          std::this_thread::sleep_for(1ms);
+        }
+      }
     }
 
-    auto pushValue(const char *value) noexcept {
-      while (*value) {
-        pushValue(*value);
-        ++value;
+    /// Formats every record available in the rings, returns whether there was any.
+    auto drainRings() noexcept -> bool {
+      bool isDrained = false;
+      const size_t count = m_ringCount.load(std::memory_order_acquire);
+      for (size_t i = 0; i < count; ++i) {
+        size_t size;
+        for (auto record = m_rings[i]->nextToRead(size); record; record = m_rings[i]->nextToRead(size)) {
+          formatRecord(record);
+          m_rings[i]->commitRead();
+          isDrained = true;
+        }
       }
+      return isDrained;
     }
 
-    auto pushValue(const std::string &value) noexcept {
-      pushValue(value.c_str());
-    }
-  public:
-    template<typename T, typename... A>
-    auto log(const char *s, const T &value, A... args) noexcept {
+    auto formatRecord(const char *record) noexcept -> void {
+      LogRecordHeader header;
+      std::memcpy(&header, record, sizeof(header));
+      const char *argument = record + sizeof(header);
+      uint32_t remaining = header.m_argumentCount;
+
+      const char *s = header.m_format;
       while (*s) {
-        if (*s == '%') {
-          if (UNLIKELY(*(s + 1) == '%')) { // to allow %% -> % escape character.
-            ++s;
-          } else {
-            pushValue(value); // substitute % with the value specified in the arguments.
-            log(s + 1, args...); // pop an argument and call self recursively.
-            return;
-          }
+        writePrefix(header.m_timestamp);
+        const char *end = s + std::strcspn(s, "%\n"); // literal text is written in runs up to the next % or line end.
+        if (*end == '\n') {
+          m_sink.append(s, static_cast<size_t>(end + 1 - s));
+          m_isLineStart = true;
+          s = end + 1;
+          continue;
+        }
+        m_sink.append(s, static_cast<size_t>(end - s));
+        s = end;
+        if (!*s)
+          break;
+        if (UNLIKELY(*(s + 1) == '%')) { // to allow %% -> % escape character.
+          m_sink.append('%');
+          s += 2;
+          continue;
         }
-        pushValue(*s++);
+        if (UNLIKELY(!remaining))
+          FATAL("missing arguments to log()");
+        argument = formatArgument(argument);
+        --remaining;
+        ++s;
       }
-      FATAL("extra arguments provided to log()");
+      if (UNLIKELY(remaining))
+        FATAL("extra arguments provided to log()");
     }
 
-    // note that this is overloading not specialization. gcc does not allow inline specializations.
-    auto log(const char *s) noexcept {
-      while (*s) {
-        if (*s == '%') {
-          if (UNLIKELY(*(s + 1) == '%')) { // to allow %% -> % escape character.
-            ++s;
-          } else {
-            FATAL("missing arguments to log()");
-          }
+    /// Writes one argument, returns the start of the next one.
+    auto formatArgument(const char *argument) noexcept -> const char * {
+      const auto type = static_cast<LogType>(*argument++);
+      const auto read = [&argument]<typename T>(T value) {
+        std::memcpy(&value, argument, sizeof(value));
+        argument += sizeof(value);
+        return value;
+      };
+      switch (type) {
+        case LogType::CHAR:
+          m_sink.append(read(char{}));
+          break;
+        case LogType::BOOL:
+          m_sink.appendNumber(static_cast<int>(read(bool{})));
+          break;
+        case LogType::INTEGER:
+          m_sink.appendNumber(read(int64_t{}));
+          break;
+        case LogType::UNSIGNED_INTEGER:
+          m_sink.appendNumber(read(uint64_t{}));
+          break;
+        case LogType::FLOAT:
+          m_sink.appendNumber(read(float{}));
+          break;
+        case LogType::DOUBLE:
+          m_sink.appendNumber(read(double{}));
+          break;
+        case LogType::STRING: {
+          const auto length = read(uint32_t{});
+          m_sink.append(argument, length);
+          argument += length;
+          break;
         }
-        pushValue(*s++);
       }
+      return argument;
     }
 
-    // Deleted default, copy & move constructors and assignment-operators.
-    Logger() = delete;
+    /// "HH:MM:SS.nnnnnnnnn " at the start of every line.
+    auto writePrefix(Nanos timestamp) noexcept -> void {
+      if (!m_isLineStart)
+        return;
+      m_isLineStart = false;
+      const time_t seconds = timestamp / NANOS_TO_SECS;
+      if (seconds != m_prefixSeconds) {
+        tm local;
+        localtime_r(&seconds, &local);
+        std::strftime(m_prefixTime, sizeof(m_prefixTime), "%H:%M:%S", &local);
+        m_prefixSeconds = seconds;
+      }
+      char fraction[16];
+      const int length = std::snprintf(fraction, sizeof(fraction), ".%09lld ", static_cast<long long>(timestamp % NANOS_TO_SECS));
+      m_sink.append(std::string_view(m_prefixTime));
+      m_sink.append(fraction, static_cast<size_t>(length));
+    }
 
-    Logger(const Logger&) = delete;
+    static inline std::atomic<uint64_t> s_nextId = {1};
 
-    Logger(const Logger&&) = delete;
-
-    Logger &operator=(const Logger&) = delete;
+    const uint64_t m_id = s_nextId.fetch_add(1);
+    const std::string m_fileName;
+    LogSink m_sink; // logger thread only, closed(flushed) when the Logger is destroyed.
 
-    Logger &operator=(const Logger&&) = delete;
+    std::mutex m_registrationMutex;
+    std::array<std::unique_ptr<SPSCByteRing>, MAX_LOG_PRODUCERS> m_rings;
+    std::array<std::thread::id, MAX_LOG_PRODUCERS> m_producers;
+    std::atomic<size_t> m_ringCount = {0};
 
-  private:
-    const std::string m_fileName;
-    std::ofstream m_file;
+    bool m_isLineStart = true; // logger thread only.
+    time_t m_prefixSeconds = -1;
+    char m_prefixTime[16] = {};
 
-    LFQueue<LogElement> m_queue;
     std::atomic<bool> m_running = {true};
     std::thread* mp_loggerThread = nullptr;
   };
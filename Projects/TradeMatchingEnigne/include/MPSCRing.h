@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+#include "Macros.h"
+#include "SPSCRing.h"
+
+namespace Common {
+  /// Bounded multi-producer/single-consumer ring.
+  /// Every slot carries a sequence number telling whose turn it is: producers claim a slot by a CAS on the shared tail
+  /// and publish it by bumping the slot sequence, the consumer waits for the sequence of the head slot only.
+  /// A producer stalled between claim and publish holds back the consumer, never the other producers.
+  template<typename T>
+  class MPSCRing final {
+  public:
+    /// Capacity is rounded up to a power of two.
+    explicit MPSCRing(std::size_t num_elems) :
+        m_capacity(std::bit_ceil(std::max<std::size_t>(num_elems, 2))),
+        m_mask(m_capacity - 1),
+        mp_cells(std::make_unique<Cell[]>(m_capacity)) {
+      for (size_t i = 0; i < m_capacity; ++i)
+        mp_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+    }
+
+    auto tryPush(const T &value) noexcept {
+      size_t tail = m_tail.load(std::memory_order_relaxed);
+      while (true) {
+        Cell &cell = mp_cells[tail & m_mask];
+        const size_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+        if (sequence == tail) {
+          if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+            detail::storeSlot(cell.m_value, value);
+            cell.m_sequence.store(tail + 1, std::memory_order_release);
+            return true;
+          }
+        } else if (sequence < tail) {
+          return false; // the slot still holds an element of the previous lap: full.
+        } else {
+          tail = m_tail.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    /// Claims count consecutive slots with one CAS when they are all free, otherwise pushes as many as fit one by one.
+    /// Returns how many were pushed; elements of one call stay contiguous only when all of them fit at once.
+    auto tryPushN(const T *values, std::size_t count) noexcept -> std::size_t {
+      if (UNLIKELY(!count))
+        return 0;
+      size_t tail = m_tail.load(std::memory_order_relaxed);
+      while (count <= m_capacity &&
+             mp_cells[(tail + count - 1) & m_mask].m_sequence.load(std::memory_order_acquire) == tail + count - 1 &&
+             mp_cells[tail & m_mask].m_sequence.load(std::memory_order_acquire) == tail) {
+        if (m_tail.compare_exchange_weak(tail, tail + count, std::memory_order_relaxed)) {
+          for (size_t i = 0; i < count; ++i) {
+            Cell &cell = mp_cells[(tail + i) & m_mask];
+            detail::storeSlot(cell.m_value, values[i]);
+            cell.m_sequence.store(tail + i + 1, std::memory_order_release);
+          }
+          return count;
+        }
+      }
+      size_t pushed = 0;
+      while (pushed < count && tryPush(values[pushed]))
+        ++pushed;
+      return pushed;
+    }
+
+    /// Oldest published element or nullptr; release it with commitRead(). Consumer only.
+    auto nextToRead() noexcept -> const T * {
+      Cell &cell = mp_cells[m_head & m_mask];
+      if (cell.m_sequence.load(std::memory_order_acquire) != m_head + 1)
+        return nullptr;
+      return &cell.m_value;
+    }
+
+    auto commitRead() noexcept {
+      mp_cells[m_head & m_mask].m_sequence.store(m_head + m_capacity, std::memory_order_release);
+      ++m_head;
+      m_headPublished.store(m_head, std::memory_order_relaxed);
+    }
+
+    auto tryPop(T &value) noexcept {
+      const T *slot = nextToRead();
+      if (UNLIKELY(!slot))
+        return false;
+      detail::storeSlot(value, *slot);
+      commitRead();
+      return true;
+    }
+
+    auto tryPopN(T *values, std::size_t count) noexcept -> std::size_t {
+      size_t popped = 0;
+      for (const T *slot; popped < count && (slot = nextToRead()); ++popped) {
+        detail::storeSlot(values[popped], *slot);
+        mp_cells[m_head & m_mask].m_sequence.store(m_head + m_capacity, std::memory_order_release);
+        ++m_head;
+      }
+      m_headPublished.store(m_head, std::memory_order_relaxed);
+      return popped;
+    }
+
+    /// Claimed slots, including those whose producers haven't published yet. Approximate while producers run.
+    auto size() const noexcept {
+      const size_t head = m_headPublished.load(std::memory_order_acquire);
+      return m_tail.load(std::memory_order_acquire) - head;
+    }
+
+    auto empty() const noexcept {
+      return size() == 0;
+    }
+
+    auto capacity() const noexcept {
+      return m_capacity;
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    MPSCRing() = delete;
+
+    MPSCRing(const MPSCRing&) = delete;
+
+    MPSCRing(const MPSCRing&&) = delete;
+
+    MPSCRing &operator=(const MPSCRing&) = delete;
+
+    MPSCRing &operator=(const MPSCRing&&) = delete;
+
+  private:
+    struct Cell {
+      std::atomic<size_t> m_sequence = {0};
+      T m_value{};
+    };
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> mp_cells;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail = {0}; // shared by the producers.
+
+    alignas(CACHE_LINE_SIZE) size_t m_head = 0; // consumer private.
+    std::atomic<size_t> m_headPublished = {0}; // m_head for size() callers.
+  };
+}
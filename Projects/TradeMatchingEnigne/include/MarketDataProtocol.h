@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Market data of the engine's book over UDP multicast, little-endian datagrams of one MarketDataHeader followed by
+// m_count LevelUpdate entries. A level update carries the new aggregate of the level, zero orders remove it.
+//  - Incremental channel(<port>): packets sequenced from 1 without gaps, every packet coalesces the changes of one or more
+//    requests and leaves the book consistent as of its last one.
+//  - Snapshot channel(<port> + 1): the whole book every snapshot interval, split into packets flagged from
+//    MD_FLAG_FIRST to MD_FLAG_LAST. m_bookSequence is the last incremental packet reflected in it, so a late joiner
+//    loads the snapshot and applies the incremental packets after m_bookSequence. Snapshot packets have their own sequence.
+//  - The engine sends one more snapshot flagged MD_FLAG_FINAL when it stops, taken from the engine's book itself.
+
+constexpr char MD_INCREMENTAL = 'I';
+constexpr char MD_SNAPSHOT = 'S';
+
+constexpr std::uint8_t MD_FLAG_FIRST = 1;
+constexpr std::uint8_t MD_FLAG_LAST = 2;
+constexpr std::uint8_t MD_FLAG_FINAL = 4;
+
+constexpr std::size_t MD_MAX_PACKET_SIZE = 1472;//one Ethernet frame without fragmentation
+
+struct MarketDataHeader {
+    std::uint64_t   m_sequence;//of the packet on its channel
+    std::uint64_t   m_bookSequence;//last incremental packet reflected in the book after this one
+    std::uint64_t   m_sendTime;//Common::getCurrentNanos() of the publisher
+    std::uint16_t   m_count;//of LevelUpdate entries following the header
+    char            m_type;//MD_INCREMENTAL or MD_SNAPSHOT
+    std::uint8_t    m_flags;
+    std::uint32_t   m_reserved;
+};
+static_assert(sizeof(MarketDataHeader) == 32);
+
+struct LevelUpdate {
+    std::uint64_t   m_quantity;//total resting quantity of the level
+    std::uint32_t   m_price;
+    std::uint32_t   m_orderCount;
+    char            m_side;//'B' or 'S'
+    std::uint8_t    m_reserved[7];
+};
+static_assert(sizeof(LevelUpdate) == 24);
+
+constexpr std::size_t MD_MAX_UPDATES = (MD_MAX_PACKET_SIZE - sizeof(MarketDataHeader)) / sizeof(LevelUpdate);
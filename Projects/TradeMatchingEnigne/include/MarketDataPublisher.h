@@ -0,0 +1,319 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Logger.h"
+#include "Macros.h"
+#include "MarketDataProtocol.h"
+#include "LatencyHistogram.h"
+#include "OrderPool.h"
+#include "SocketUtils.h"
+#include "SPSCRing.h"
+#include "ThreadUtils.h"
+#include "TimeUtils.h"
+
+struct MarketDataConfig {
+    std::string     m_group = "239.255.0.1";
+    int             m_port = 0;//incremental channel, snapshots go to m_port + 1, 0 disables market data
+    unsigned        m_snapshotIntervalMs = 1000;
+};
+
+// "<multicast group>:<port>"
+inline bool parseMarketDataAddress(std::string_view address, MarketDataConfig& config) {
+    const auto colonPos = address.rfind(':');
+    if(colonPos == std::string_view::npos || colonPos == 0) {
+        return false;
+    }
+    int port = 0;
+    const std::string_view portText = address.substr(colonPos + 1);
+    const auto result = std::from_chars(portText.data(), portText.data() + portText.size(), port);
+    if(result.ec != std::errc{} || result.ptr != portText.data() + portText.size() || port <= 0 || port >= 65535) {
+        return false;
+    }
+    config.m_group = address.substr(0, colonPos);
+    config.m_port = port;
+    return true;
+}
+
+// A level update on its way from the matching thread to the publisher thread.
+struct MarketDataEvent {
+    LevelUpdate     m_update;
+    Common::Nanos   m_time;//when the matching thread produced it
+};
+
+// Publishes the book of one OrderPool over UDP multicast(see MarketDataProtocol.h). The matching thread turns the level
+// changes of every request into level updates and hands them over an SPSC ring. The publisher thread coalesces them into
+// incremental packets: a packet is sent when it is full or when the ring runs dry, so it carries a single request at low
+// rates and many at high ones. The publisher keeps its own copy of the book to send snapshots from, so the matching
+// thread never waits for a snapshot.
+class MarketDataPublisher {
+public:
+    static constexpr std::size_t EVENT_RING_SIZE = 1 << 20;
+    static constexpr std::size_t PUBLISH_BATCH_SIZE = 256;
+    static constexpr int SEND_BUFFER_BYTES = 4 * 1024 * 1024;
+
+    explicit MarketDataPublisher(const MarketDataConfig& config) :
+        m_config{config},
+        m_events{EVENT_RING_SIZE}
+    {
+        m_incrementalFd = openChannel(config.m_port);
+        m_snapshotFd = openChannel(config.m_port + 1);
+        mp_thread = Common::createAndStartThread(-1, "MarketData/publish", [this]() { publishLoop(); });
+        ASSERT(mp_thread != nullptr, "Failed to start the market data publisher thread.");
+    }
+
+    ~MarketDataPublisher() {
+        stop();
+        ::close(m_incrementalFd);
+        ::close(m_snapshotFd);
+    }
+
+    // matching thread: the new aggregates of the levels changed by the last tryExecute() call
+    template<class MapContBuy, class MapContSell>
+    void publish(const OrderPool<MapContBuy, MapContSell>& pool) {
+        const auto changes = pool.levelChanges();
+        if(changes.empty()) {
+            return;
+        }
+        const Common::Nanos now = Common::getCurrentNanos();
+        for(const LevelChange& change : changes) {
+            const LevelDepth depth = pool.levelDepth(change.m_side, change.m_price);
+            const MarketDataEvent event{LevelUpdate{depth.m_quantity, change.m_price, depth.m_orderCount, change.m_side, {}}, now};
+            unsigned spins = 0;
+            while(!m_events.tryPush(event)) {
+                Common::spinWait(spins);
+            }
+        }
+    }
+
+    // matching thread: every level of the book, e.g. after it was restored from a snapshot
+    template<class MapContBuy, class MapContSell>
+    void publishBook(const OrderPool<MapContBuy, MapContSell>& pool) {
+        const Common::Nanos now = Common::getCurrentNanos();
+        for(const char side : {'B', 'S'}) {
+            pool.forEachLevel(side, [&](unsigned price, const LevelDepth& depth) {
+                const MarketDataEvent event{LevelUpdate{depth.m_quantity, price, depth.m_orderCount, side, {}}, now};
+                unsigned spins = 0;
+                while(!m_events.tryPush(event)) {
+                    Common::spinWait(spins);
+                }
+            });
+        }
+    }
+
+    // matching thread, after its last request: drains the publisher, sends the final snapshot from the book itself
+    // and prints the statistics
+    template<class MapContBuy, class MapContSell>
+    void finish(const OrderPool<MapContBuy, MapContSell>& pool) {
+        stop();
+        m_snapshotLevels.clear();
+        for(const char side : {'B', 'S'}) {
+            pool.forEachLevel(side, [&](unsigned price, const LevelDepth& depth) {
+                m_snapshotLevels.push_back(LevelUpdate{depth.m_quantity, price, depth.m_orderCount, side, {}});
+            });
+        }
+        sendSnapshot(MD_FLAG_FINAL);
+        printStats(std::cout);
+    }
+
+    MarketDataPublisher(const MarketDataPublisher&) = delete;
+    MarketDataPublisher& operator=(const MarketDataPublisher&) = delete;
+
+private:
+    int openChannel(int port) {
+        const Common::SocketCfg config{m_config.m_group, "", port, true, false, false};
+        const int fd = Common::createSocket(Common::Logger::getInstance(), config);
+        ASSERT(fd >= 0, "Market data socket set-up failed for " + m_config.m_group + ":" + std::to_string(port));
+        const int bytes = SEND_BUFFER_BYTES;
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes));//best effort, capped by net.core.wmem_max
+        return fd;
+    }
+
+    void stop() {
+        if(mp_thread) {
+            m_isPublishing.store(false, std::memory_order_release);
+            mp_thread->join();
+            delete mp_thread;
+            mp_thread = nullptr;
+        }
+    }
+
+    void publishLoop() {
+        std::vector<MarketDataEvent> batch(PUBLISH_BATCH_SIZE);
+        const Common::Nanos snapshotInterval = static_cast<Common::Nanos>(m_config.m_snapshotIntervalMs) * Common::NANOS_TO_MILLIS;
+        m_startTime = Common::getCurrentNanos();
+        Common::Nanos lastSnapshot = m_startTime;
+        unsigned spins = 0;
+        while(true) {
+            const std::size_t count = m_events.tryPopN(batch.data(), PUBLISH_BATCH_SIZE);
+            for(std::size_t i = 0; i < count; ++i) {
+                addUpdate(batch[i]);
+            }
+            if(!count) {
+                sendIncremental();//nothing else is coming yet, so updates aren't held back
+            }
+            if(Common::getCurrentNanos() - lastSnapshot >= snapshotInterval) {
+                sendIncremental();//the snapshot covers exactly the incremental packets sent so far
+                takeMirrorSnapshot();
+                sendSnapshot(0);
+                lastSnapshot = Common::getCurrentNanos();
+            }
+            if(!count) {
+                if(!m_isPublishing.load(std::memory_order_acquire) && m_events.empty()) {
+                    break;
+                }
+                Common::spinWait(spins);
+            }
+        }
+        sendIncremental();
+        m_stopTime = Common::getCurrentNanos();
+    }
+
+    void addUpdate(const MarketDataEvent& event) {
+        const LevelUpdate& update = event.m_update;
+        applyToMirror(update);
+        ++m_updateCount;
+        for(std::size_t i = 0; i < m_pendingCount; ++i) {//a later state of a level replaces the one already in the packet
+            if(m_pending[i].m_price == update.m_price && m_pending[i].m_side == update.m_side) {
+                m_pending[i] = update;
+                ++m_coalescedCount;
+                return;
+            }
+        }
+        if(m_pendingCount == MD_MAX_UPDATES) {
+            sendIncremental();
+        }
+        if(!m_pendingCount) {
+            m_oldestPendingTime = event.m_time;
+        }
+        m_pending[m_pendingCount++] = update;
+    }
+
+    void applyToMirror(const LevelUpdate& update) {
+        if(update.m_side == 'S') {
+            applyToSide(m_mirrorAsks, update);
+        } else {
+            applyToSide(m_mirrorBids, update);
+        }
+    }
+
+    template<class Side>
+    static void applyToSide(Side& side, const LevelUpdate& update) {
+        if(update.m_orderCount) {
+            side.insert_or_assign(update.m_price, update);
+        } else {
+            side.erase(update.m_price);
+        }
+    }
+
+    void takeMirrorSnapshot() {
+        m_snapshotLevels.clear();
+        for(const auto& level : m_mirrorBids) {
+            m_snapshotLevels.push_back(level.second);
+        }
+        for(const auto& level : m_mirrorAsks) {
+            m_snapshotLevels.push_back(level.second);
+        }
+    }
+
+    void sendIncremental() {
+        if(!m_pendingCount) {
+            return;
+        }
+        ++m_incrementalSequence;
+        const MarketDataHeader header{m_incrementalSequence, m_incrementalSequence, 0, static_cast<std::uint16_t>(m_pendingCount), MD_INCREMENTAL, 0, 0};
+        const Common::Nanos sendTime = sendPacket(m_incrementalFd, header, m_pending, m_pendingCount);
+        m_publishLatency.record(static_cast<std::uint64_t>(sendTime - m_oldestPendingTime));
+        ++m_incrementalPacketCount;
+        m_pendingCount = 0;
+    }
+
+    // m_snapshotLevels as of incremental packet m_incrementalSequence, at least one packet even for an empty book
+    void sendSnapshot(std::uint8_t flags) {
+        std::size_t sent = 0;
+        do {
+            const std::size_t count = std::min(MD_MAX_UPDATES, m_snapshotLevels.size() - sent);
+            std::uint8_t packetFlags = flags;
+            packetFlags |= (sent == 0) ? MD_FLAG_FIRST : 0;
+            packetFlags |= (sent + count == m_snapshotLevels.size()) ? MD_FLAG_LAST : 0;
+            const MarketDataHeader header{++m_snapshotSequence, m_incrementalSequence, 0, static_cast<std::uint16_t>(count), MD_SNAPSHOT, packetFlags, 0};
+            sendPacket(m_snapshotFd, header, m_snapshotLevels.data() + sent, count);
+            ++m_snapshotPacketCount;
+            sent += count;
+        } while(sent < m_snapshotLevels.size());
+        ++m_snapshotCount;
+    }
+
+    // a full socket buffer is waited out, the datagram is only dropped on other errors
+    Common::Nanos sendPacket(int fd, MarketDataHeader header, const LevelUpdate* updates, std::size_t count) {
+        const std::size_t size = sizeof(MarketDataHeader) + count * sizeof(LevelUpdate);
+        header.m_sendTime = static_cast<std::uint64_t>(Common::getCurrentNanos());
+        std::memcpy(m_packet, &header, sizeof(header));
+        std::memcpy(m_packet + sizeof(header), updates, count * sizeof(LevelUpdate));
+        while(::send(fd, m_packet, size, 0) < 0) {
+            if(errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS || errno == EINTR) {
+                ++m_sendRetryCount;
+                std::this_thread::yield();
+                continue;
+            }
+            if(!m_sendErrorCount++) {
+                std::cerr << "Market data send() failed: " << std::strerror(errno) << std::endl;
+            }
+            break;
+        }
+        m_sentBytes += size;
+        return static_cast<Common::Nanos>(header.m_sendTime);
+    }
+
+    void printStats(std::ostream& os) const {
+        const double seconds = static_cast<double>(m_stopTime - m_startTime) / static_cast<double>(Common::NANOS_TO_SECS);
+        const std::uint64_t packets = m_incrementalPacketCount + m_snapshotPacketCount;
+        os << "Market data: " << m_updateCount << " level updates(" << m_coalescedCount << " coalesced) in "
+           << m_incrementalPacketCount << " incremental packets, " << m_snapshotCount << " snapshots in "
+           << m_snapshotPacketCount << " packets, " << m_sentBytes << " bytes, "
+           << (seconds > 0 ? static_cast<double>(packets) / seconds : 0.0) << " packets/s, "
+           << m_sendRetryCount << " send retries, " << m_sendErrorCount << " send errors" << std::endl;
+        m_publishLatency.print(os, "Market data publish latency(ns), request matched to packet sent");
+    }
+
+    const MarketDataConfig                                  m_config;
+    int                                                     m_incrementalFd = -1;
+    int                                                     m_snapshotFd = -1;
+    Common::SPSCRing<MarketDataEvent>                       m_events;
+    std::thread*                                            mp_thread = nullptr;
+    std::atomic<bool>                                       m_isPublishing = {true};
+    LevelUpdate                                             m_pending[MD_MAX_UPDATES];//publisher thread only, from here on
+    std::size_t                                             m_pendingCount = 0;
+    Common::Nanos                                           m_oldestPendingTime = 0;
+    std::map<unsigned, LevelUpdate, std::greater<unsigned>> m_mirrorBids;
+    std::map<unsigned, LevelUpdate>                         m_mirrorAsks;
+    std::vector<LevelUpdate>                                m_snapshotLevels;
+    char                                                    m_packet[MD_MAX_PACKET_SIZE];
+    std::uint64_t                                           m_incrementalSequence = 0;
+    std::uint64_t                                           m_snapshotSequence = 0;
+    Common::LatencyHistogram                                m_publishLatency;
+    Common::Nanos                                           m_startTime = 0;
+    Common::Nanos                                           m_stopTime = 0;
+    std::uint64_t                                           m_updateCount = 0;
+    std::uint64_t                                           m_coalescedCount = 0;
+    std::uint64_t                                           m_incrementalPacketCount = 0;
+    std::uint64_t                                           m_snapshotCount = 0;
+    std::uint64_t                                           m_snapshotPacketCount = 0;
+    std::uint64_t                                           m_sentBytes = 0;
+    std::uint64_t                                           m_sendRetryCount = 0;
+    std::uint64_t                                           m_sendErrorCount = 0;
+};
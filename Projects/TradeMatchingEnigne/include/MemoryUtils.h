@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Common {
+  constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+  /// Asks for transparent huge pages over the whole 2MB pages inside [p, p + bytes). Only pages not touched yet are
+  /// affected, so call it between allocating and first writing a large block. A no-op for blocks below one huge page.
+  inline auto adviseHugePages(const void *p, size_t bytes) noexcept -> void {
+    const auto begin = (reinterpret_cast<uintptr_t>(p) + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    const auto end = (reinterpret_cast<uintptr_t>(p) + bytes) & ~(HUGE_PAGE_SIZE - 1);
+    if (begin < end)
+      madvise(reinterpret_cast<void *>(begin), end - begin, MADV_HUGEPAGE);
+  }
+
+  /// Writes one byte of every page of [p, p + bytes) without changing its value, so the page faults are taken now.
+  inline auto prefault(void *p, size_t bytes) noexcept -> void {
+    const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto *bytePtr = static_cast<volatile char *>(p);
+    for (size_t offset = 0; offset < bytes; offset += pageSize)
+      bytePtr[offset] = bytePtr[offset];
+  }
+
+  /// Locks all current and future pages of the process in memory(mlockall), error holds the reason when it fails.
+  /// Needs CAP_IPC_LOCK or an RLIMIT_MEMLOCK larger than the process will ever map.
+  inline auto lockMemory(std::string &error) noexcept -> bool {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+      return true;
+    error = strerror(errno);
+    return false;
+  }
+}
@@ -0,0 +1,558 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "BinaryOrderStream.h"
+#include "BookOrder.h"
+#include "GatewayProtocol.h"
+#include "Logger.h"
+#include "Macros.h"
+#include "MarketDataPublisher.h"
+#include "OrderIndex.h"
+#include "OrderLatency.h"
+#include "OrderPool.h"
+#include "SocketUtils.h"
+#include "SPSCRing.h"
+#include "ThreadUtils.h"
+#include "TimeUtils.h"
+
+// A decoded request on its way to the matching thread, tagged with the session it came from.
+struct GatewayRequest {
+    BookOrder       m_order;
+    std::uint64_t   m_clientOrderId;
+    std::uint64_t   m_timestamp;
+    std::uint32_t   m_session;
+    std::uint32_t   m_generation;//of the session slot, reports for a closed session are dropped
+    bool            m_isRejected;//refused by the gateway, acknowledged as ExecOutcome::Rejected without reaching the book
+};
+
+struct GatewayReport {
+    ExecutionReport m_report;
+    std::uint32_t   m_session;
+    std::uint32_t   m_generation;
+};
+
+// One client connection. Requests are decoded in place from the receive buffer, reports are gathered in the send
+// buffer and written with one send() per gateway loop iteration.
+struct GatewaySession {
+    int                         m_fd = -1;
+    std::uint32_t               m_generation = 0;
+    std::unique_ptr<char[]>     mp_receive;//allocated on the first connection of the slot and kept for the next ones
+    std::size_t                 m_receiveSize = 0;//only a partial request is left between reads
+    std::unique_ptr<char[]>     mp_send;
+    std::size_t                 m_sendSize = 0;
+    bool                        m_isWriteBlocked = false;//waits for EPOLLOUT
+    bool                        m_isDirty = false;//has unsent reports and is queued for flushing
+    std::vector<unsigned>       m_traders;//bound to the session by its requests, released when it closes
+};
+
+// Non-blocking, edge-triggered epoll TCP order entry(see GatewayProtocol.h) in front of one OrderPool.
+// The gateway thread accepts sessions, decodes requests and sends reports; the matching thread owns the OrderPool.
+// They exchange batches through two SPSC rings, the matching thread wakes the gateway with an eventfd only while the
+// gateway is blocked in epoll_wait(). A session that doesn't read its reports fast enough to keep its send buffer
+// from overflowing is disconnected. The matching thread remembers the session and client order id of every resting
+// order in a table sized like the book, so fills go to the session that entered the order without any allocation.
+// A trader id belongs to the first session sending a request for it until that session closes, requests of other
+// sessions for it are rejected. So are new orders once the 32-bit engine order ids are used up.
+template<class MapContBuy, class MapContSell>
+class OrderGateway {
+public:
+    static constexpr std::size_t MAX_SESSIONS = 1024;
+    static constexpr std::size_t RECEIVE_BUFFER_SIZE = 64 * 1024;//a multiple of the request size
+    static constexpr std::size_t SEND_BUFFER_SIZE = 1024 * 1024;
+    static constexpr std::size_t REQUEST_RING_SIZE = 64 * 1024;
+    static constexpr std::size_t REPORT_RING_SIZE = 256 * 1024;
+    static constexpr std::size_t GATEWAY_BATCH_SIZE = 256;
+    static constexpr int MAX_EPOLL_EVENTS = 256;
+    static constexpr int EPOLL_TIMEOUT_MS = 100;//how often a blocked gateway checks whether it should stop
+    static constexpr std::uint64_t LISTEN_TAG = std::numeric_limits<std::uint64_t>::max();
+    static constexpr std::uint64_t WAKE_TAG = LISTEN_TAG - 1;
+
+    static_assert(RECEIVE_BUFFER_SIZE % sizeof(BinaryOrderRecord) == 0);
+
+    // matching thread is pinned to firstCore and the calling(gateway) thread to firstCore + 1, negative disables pinning
+    OrderGateway(int port, int firstCore, std::size_t nodeCapacity = OrderPool<MapContBuy, MapContSell>::DEFAULT_NODE_CAPACITY,
+                 const Common::ArenaConfig& arenaConfig = {}) :
+        m_firstCore{firstCore},
+        m_orderPool{nodeCapacity, arenaConfig},
+        m_ownerIndex{nodeCapacity},
+        m_requests{REQUEST_RING_SIZE},
+        m_reports{REPORT_RING_SIZE},
+        m_sessions(MAX_SESSIONS),
+        m_traderSessions{MAX_SESSIONS}
+    {
+        const Common::SocketCfg config{"0.0.0.0", "", port, false, true, false};
+        m_listenFd = Common::createSocket(Common::Logger::getInstance(), config);
+        m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+        m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        ASSERT(m_listenFd >= 0 && m_epollFd >= 0 && m_wakeFd >= 0, "OrderGateway set-up failed. errno:" + std::string(strerror(errno)));
+        watch(m_listenFd, EPOLLIN | EPOLLET, LISTEN_TAG);
+        watch(m_wakeFd, EPOLLIN | EPOLLET, WAKE_TAG);
+        for(std::uint32_t i = MAX_SESSIONS; i > 0; --i) {
+            m_freeSessions.push_back(i - 1);
+        }
+        m_owners.reserve(nodeCapacity);
+        m_freeOwners.reserve(nodeCapacity);
+    }
+
+    ~OrderGateway() {
+        for(GatewaySession& session : m_sessions) {
+            if(session.m_fd >= 0) {
+                ::close(session.m_fd);
+            }
+        }
+        ::close(m_wakeFd);
+        ::close(m_epollFd);
+        ::close(m_listenFd);
+    }
+
+    // serves clients until isRunning turns false, then drains both rings and prints the statistics
+    void run(const std::atomic<bool>& isRunning) {
+        const int coreCount = static_cast<int>(std::thread::hardware_concurrency());
+        auto coreOf = [&](int thread) { return (m_firstCore >= 0 && m_firstCore + thread < coreCount) ? m_firstCore + thread : -1; };
+        std::thread* matchThread = Common::createAndStartThread(coreOf(0), "Gateway/match", [this]() { matchLoop(); });
+        ASSERT(matchThread != nullptr, "Failed to start the gateway matching thread.");
+        if(coreOf(1) >= 0) {
+            Common::setThreadCore(coreOf(1));
+        }
+        const auto start = std::chrono::steady_clock::now();
+        epoll_event events[MAX_EPOLL_EVENTS];
+        while(isRunning.load(std::memory_order_relaxed)) {
+            m_isGatewayWaiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);//pairs with the fence of the matching thread, see wakeGateway()
+            const int timeout = (m_reports.empty() && m_dirtySessions.empty()) ? EPOLL_TIMEOUT_MS : 0;
+            const int count = epoll_wait(m_epollFd, events, MAX_EPOLL_EVENTS, timeout);
+            m_isGatewayWaiting.store(false, std::memory_order_relaxed);
+            for(int i = 0; i < count; ++i) {
+                handleEvent(events[i]);
+            }
+            drainReports();
+            flushDirtySessions();
+        }
+        m_isMatching.store(false, std::memory_order_release);
+        matchThread->join();
+        delete matchThread;
+        drainReports();
+        flushDirtySessions();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << "Gateway: " << m_acceptedCount << " sessions, " << m_requestCount << " requests, " << m_reportCount
+                  << " reports in " << elapsed.count() << " ns, " << m_rejectedCount << " requests rejected, " << m_droppedReportCount << " reports dropped, "
+                  << m_slowSessionCount << " slow sessions disconnected" << std::endl;
+        m_latency.print(std::cout);
+    }
+
+    // before run() and enableMarketData(): grows the book to its working size and touches its memory through synthetic
+    // matching(OrderPool::warmUp())
+    void warmUp(const WarmUpConfig& config) {
+        const Common::Nanos start = Common::getCurrentNanos();
+        const std::size_t orders = m_orderPool.warmUp(config);
+        std::cout << "Warm-up: " << orders << " orders on " << config.m_levels << " levels per side in " << Common::getCurrentNanos() - start
+                  << " ns" << std::endl;
+    }
+
+    // publishes the level changes of every request over UDP multicast, before run()
+    void enableMarketData(const MarketDataConfig& config) {
+        m_orderPool.trackLevelChanges(true);
+        mp_marketData = std::make_unique<MarketDataPublisher>(config);
+    }
+
+    OrderGateway(const OrderGateway&) = delete;
+    OrderGateway& operator=(const OrderGateway&) = delete;
+
+private:
+    // where the fills of a resting order go
+    struct OrderOwner {
+        std::uint64_t m_clientOrderId;
+        std::uint32_t m_session;
+        std::uint32_t m_generation;
+    };
+
+    void watch(int fd, std::uint32_t events, std::uint64_t tag) {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = tag;
+        ASSERT(epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) == 0, "epoll_ctl() failed. errno:" + std::string(strerror(errno)));
+    }
+
+    void handleEvent(const epoll_event& event) {
+        if(event.data.u64 == LISTEN_TAG) {
+            acceptSessions();
+            return;
+        }
+        if(event.data.u64 == WAKE_TAG) {
+            eventfd_t value;
+            eventfd_read(m_wakeFd, &value);
+            return;
+        }
+        const auto index = static_cast<std::uint32_t>(event.data.u64);
+        GatewaySession& session = m_sessions[index];
+        if(session.m_fd < 0) {//closed by an earlier event of the same epoll_wait()
+            return;
+        }
+        if(event.events & EPOLLIN) {
+            receive(index, session);
+        }
+        if(session.m_fd >= 0 && (event.events & EPOLLOUT) && session.m_isWriteBlocked) {
+            session.m_isWriteBlocked = false;
+            flush(session);
+        }
+        if(session.m_fd >= 0 && (event.events & (EPOLLERR | EPOLLHUP))) {
+            closeSession(session);
+        }
+    }
+
+    void acceptSessions() {
+        while(true) {
+            const int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if(fd < 0) {
+                if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    std::cerr << "OrderGateway: accept4() failed. errno:" << strerror(errno) << std::endl;
+                }
+                if(errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            if(m_freeSessions.empty()) {
+                std::cerr << "OrderGateway: more than " << MAX_SESSIONS << " sessions, connection refused" << std::endl;
+                ::close(fd);
+                continue;
+            }
+            Common::disableNagle(fd);
+            const std::uint32_t index = m_freeSessions.back();
+            m_freeSessions.pop_back();
+            GatewaySession& session = m_sessions[index];
+            if(!session.mp_receive) {
+                session.mp_receive = std::make_unique<char[]>(RECEIVE_BUFFER_SIZE);
+                session.mp_send = std::make_unique<char[]>(SEND_BUFFER_SIZE);
+            }
+            session.m_fd = fd;
+            session.m_receiveSize = 0;
+            session.m_sendSize = 0;
+            session.m_isWriteBlocked = false;
+            session.m_isDirty = false;
+            watch(fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, index);
+            ++m_acceptedCount;
+        }
+    }
+
+    // edge-triggered: read until the socket is drained, decoding every complete request straight from the buffer
+    void receive(std::uint32_t index, GatewaySession& session) {
+        while(session.m_fd >= 0) {
+            const ssize_t received = ::recv(session.m_fd, session.mp_receive.get() + session.m_receiveSize, RECEIVE_BUFFER_SIZE - session.m_receiveSize, 0);
+            if(received <= 0) {
+                if(received < 0 && errno == EINTR) {
+                    continue;
+                }
+                if(received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    closeSession(session);
+                }
+                return;
+            }
+            session.m_receiveSize += static_cast<std::size_t>(received);
+            const std::size_t count = session.m_receiveSize / sizeof(BinaryOrderRecord);
+            //requests always start at the beginning of the buffer, which operator new[] aligns for them
+            const auto* records = reinterpret_cast<const BinaryOrderRecord*>(session.mp_receive.get());
+            for(std::size_t i = 0; i < count; ++i) {
+                submit(index, session, records[i]);
+            }
+            const std::size_t consumed = count * sizeof(BinaryOrderRecord);
+            session.m_receiveSize -= consumed;
+            if(session.m_receiveSize) {
+                std::memmove(session.mp_receive.get(), session.mp_receive.get() + consumed, session.m_receiveSize);
+            }
+        }
+    }
+
+    void submit(std::uint32_t index, GatewaySession& session, const BinaryOrderRecord& record) {
+        const bool isNewOrder = record.m_side == 'B' || record.m_side == 'S';
+        const bool isRejected = !bindTrader(index, session, record.m_traderId) || (isNewOrder && !hasOrderIdLeft());
+        const unsigned orderId = isRejected ? 0 : isNewOrder ? ++m_lastOrderId : record.engineOrderId();
+        std::construct_at(&m_pending[m_pendingCount++], BookOrder{record.m_traderId, record.m_quantity, record.m_price, record.m_side, orderId},
+                          record.m_orderId, record.m_timestamp, index, session.m_generation, isRejected);//BookOrder can't be assigned
+        ++m_requestCount;
+        m_rejectedCount += isRejected;
+        if(m_pendingCount == GATEWAY_BATCH_SIZE) {
+            pushPending();
+        }
+    }
+
+    // false if another session holds the trader, 0 is no trader and makes the request invalid rather than rejected
+    bool bindTrader(std::uint32_t index, GatewaySession& session, unsigned traderId) {
+        if(UNLIKELY(traderId == 0)) {
+            return true;
+        }
+        const std::uint32_t holder = m_traderSessions.find(traderId);
+        if(LIKELY(holder == index)) {
+            return true;
+        }
+        if(holder != OrderNodePool::NIL) {
+            return false;
+        }
+        m_traderSessions.insert(traderId, index);
+        session.m_traders.push_back(traderId);
+        return true;
+    }
+
+    // the engine order id of the next new order would wrap to 0 and alias the first orders, so they are refused from then on
+    bool hasOrderIdLeft() {
+        if(LIKELY(m_lastOrderId != MAX_ORDER_ID)) {
+            return true;
+        }
+        if(!m_isOutOfOrderIds) {
+            std::cerr << "OrderGateway: all " << MAX_ORDER_ID << " order ids are used, new orders are rejected" << std::endl;
+            m_isOutOfOrderIds = true;
+        }
+        return false;
+    }
+
+    // a full request ring means the matching thread waits for the report ring to drain, so drain it meanwhile
+    void pushPending() {
+        std::size_t pushed = 0;
+        unsigned spins = 0;
+        while(pushed < m_pendingCount) {
+            const std::size_t step = m_requests.tryPushN(m_pending + pushed, m_pendingCount - pushed);
+            pushed += step;
+            if(!step) {
+                drainReports();
+                Common::spinWait(spins);
+            }
+        }
+        m_pendingCount = 0;
+    }
+
+    void drainReports() {
+        if(m_pendingCount) {
+            pushPending();
+        }
+        GatewayReport batch[GATEWAY_BATCH_SIZE];
+        while(const std::size_t count = m_reports.tryPopN(batch, GATEWAY_BATCH_SIZE)) {
+            for(std::size_t i = 0; i < count; ++i) {
+                queueReport(batch[i]);
+            }
+        }
+    }
+
+    void queueReport(const GatewayReport& report) {
+        GatewaySession& session = m_sessions[report.m_session];
+        if(session.m_fd < 0 || session.m_generation != report.m_generation) {
+            ++m_droppedReportCount;
+            return;
+        }
+        if(UNLIKELY(SEND_BUFFER_SIZE - session.m_sendSize < sizeof(ExecutionReport))) {
+            flush(session);
+            if(session.m_fd < 0 || SEND_BUFFER_SIZE - session.m_sendSize < sizeof(ExecutionReport)) {
+                ++m_slowSessionCount;
+                ++m_droppedReportCount;
+                closeSession(session);
+                return;
+            }
+        }
+        std::memcpy(session.mp_send.get() + session.m_sendSize, &report.m_report, sizeof(ExecutionReport));
+        session.m_sendSize += sizeof(ExecutionReport);
+        ++m_reportCount;
+        if(!session.m_isDirty) {
+            session.m_isDirty = true;
+            m_dirtySessions.push_back(report.m_session);
+        }
+    }
+
+    void flushDirtySessions() {
+        for(const std::uint32_t index : m_dirtySessions) {
+            GatewaySession& session = m_sessions[index];
+            session.m_isDirty = false;
+            if(session.m_fd >= 0) {
+                flush(session);
+            }
+        }
+        m_dirtySessions.clear();
+    }
+
+    // writes as much of the send buffer as the socket takes, the rest waits for EPOLLOUT
+    void flush(GatewaySession& session) {
+        std::size_t sent = 0;
+        while(sent < session.m_sendSize && !session.m_isWriteBlocked) {
+            const ssize_t rc = ::send(session.m_fd, session.mp_send.get() + sent, session.m_sendSize - sent, MSG_NOSIGNAL);
+            if(rc < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                    session.m_isWriteBlocked = true;
+                    break;
+                }
+                closeSession(session);
+                return;
+            }
+            sent += static_cast<std::size_t>(rc);
+        }
+        session.m_sendSize -= sent;
+        if(session.m_sendSize && sent) {
+            std::memmove(session.mp_send.get(), session.mp_send.get() + sent, session.m_sendSize);
+        }
+    }
+
+    void closeSession(GatewaySession& session) {
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, session.m_fd, nullptr);
+        ::close(session.m_fd);
+        session.m_fd = -1;
+        ++session.m_generation;
+        for(const unsigned traderId : session.m_traders) {
+            m_traderSessions.erase(traderId);
+        }
+        session.m_traders.clear();
+        m_freeSessions.push_back(static_cast<std::uint32_t>(&session - m_sessions.data()));
+    }
+
+    void matchLoop() {
+        using clock = std::chrono::high_resolution_clock;
+        std::unique_ptr<GatewayRequest[]> batch = std::make_unique<GatewayRequest[]>(GATEWAY_BATCH_SIZE);
+        std::vector<GatewayReport> out;
+        out.reserve(GATEWAY_BATCH_SIZE * 4);
+        unsigned spins = 0;
+        while(true) {
+            const std::size_t count = m_requests.tryPopN(batch.get(), GATEWAY_BATCH_SIZE);
+            if(!count) {
+                if(!m_isMatching.load(std::memory_order_acquire) && m_requests.empty()) {
+                    if(mp_marketData) {
+                        mp_marketData->finish(m_orderPool);
+                    }
+                    break;
+                }
+                Common::spinWait(spins);
+                continue;
+            }
+            for(std::size_t i = 0; i < count; ++i) {
+                GatewayRequest& request = batch[i];
+                BookOrder& order = request.m_order;
+                const unsigned quantity = order.getQuantity();//tryExecute() consumes it
+                if(UNLIKELY(request.m_isRejected)) {
+                    out.push_back(GatewayReport{ExecutionReport{0, request.m_clientOrderId, request.m_timestamp, order.getId(), quantity, order.getPrice(),
+                                                                EXEC_REPORT_ACK, order.getSide(), static_cast<std::uint8_t>(ExecOutcome::Rejected), 0},
+                                                request.m_session, request.m_generation});
+                    continue;
+                }
+                const auto start = clock::now();
+                m_orderPool.tryExecute(order);
+                const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+                m_latency.record(static_cast<std::uint64_t>(elapsed), m_orderPool.outcome(), m_orderPool.levelsSwept());
+                if(mp_marketData) {
+                    mp_marketData->publish(m_orderPool);
+                }
+                const bool isNewOrder = order.getSide() == 'B' || order.getSide() == 'S';
+                const OrderOwner requester{request.m_clientOrderId, request.m_session, request.m_generation};
+                for(const Fill& fill : m_orderPool.fills()) {
+                    const bool isAggressor = fill.m_orderId == order.getOrderId();
+                    const OrderOwner owner = (isAggressor && isNewOrder) ? requester : ownerOf(fill.m_orderId);
+                    if(owner.m_session != NO_SESSION) {
+                        out.push_back(GatewayReport{ExecutionReport{fill.m_orderId, owner.m_clientOrderId, 0, fill.m_traderId, fill.m_quantity,
+                                                                    fill.m_price, EXEC_REPORT_FILL, fill.m_side, 0, 0},
+                                                    owner.m_session, owner.m_generation});
+                    }
+                    if(!isAggressor && !m_orderPool.isResting(fill.m_orderId)) {
+                        releaseOwner(fill.m_orderId);
+                    }
+                }
+                if(isNewOrder && m_orderPool.isResting(order.getOrderId())) {
+                    trackOwner(order.getOrderId(), requester);
+                } else if(!isNewOrder && !m_orderPool.isResting(order.getOrderId())) {//cancelled, or amended and filled in full
+                    releaseOwner(order.getOrderId());
+                }
+                out.push_back(GatewayReport{ExecutionReport{order.getOrderId(), request.m_clientOrderId, request.m_timestamp, order.getId(), quantity,
+                                                            order.getPrice(), EXEC_REPORT_ACK, order.getSide(), static_cast<std::uint8_t>(m_orderPool.outcome()), 0},
+                                            request.m_session, request.m_generation});
+            }
+            std::size_t pushed = 0;
+            while(pushed < out.size()) {
+                const std::size_t step = m_reports.tryPushN(out.data() + pushed, out.size() - pushed);
+                pushed += step;
+                if(!step) {
+                    wakeGateway();
+                    Common::spinWait(spins);
+                }
+            }
+            out.clear();
+            wakeGateway();
+        }
+    }
+
+    // the gateway publishes m_isGatewayWaiting before checking the report ring, this thread publishes reports before
+    // checking the flag: with a full fence on both sides at least one of them sees the other
+    void wakeGateway() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_isGatewayWaiting.load(std::memory_order_relaxed)) {
+            eventfd_write(m_wakeFd, 1);
+        }
+    }
+
+    static constexpr std::uint32_t NO_SESSION = std::numeric_limits<std::uint32_t>::max();
+
+    OrderOwner ownerOf(unsigned orderId) const {
+        const std::uint32_t slot = m_ownerIndex.find(orderId);
+        return (slot != OrderNodePool::NIL) ? m_owners[slot] : OrderOwner{0, NO_SESSION, 0};
+    }
+
+    // slots are reused, the table only grows past the book's node capacity if the book does
+    void trackOwner(unsigned orderId, const OrderOwner& owner) {
+        std::uint32_t slot;
+        if(!m_freeOwners.empty()) {
+            slot = m_freeOwners.back();
+            m_freeOwners.pop_back();
+            m_owners[slot] = owner;
+        } else {
+            slot = static_cast<std::uint32_t>(m_owners.size());
+            m_owners.push_back(owner);
+        }
+        m_ownerIndex.insert(orderId, slot);
+    }
+
+    void releaseOwner(unsigned orderId) {
+        const std::uint32_t slot = m_ownerIndex.find(orderId);
+        if(slot != OrderNodePool::NIL) {
+            m_ownerIndex.erase(orderId);
+            m_freeOwners.push_back(slot);
+        }
+    }
+
+    int                                         m_firstCore;
+    int                                         m_listenFd = -1;
+    int                                         m_epollFd = -1;
+    int                                         m_wakeFd = -1;
+    OrderPool<MapContBuy, MapContSell>          m_orderPool;//matching thread only
+    OrderIndex                                  m_ownerIndex;//matching thread only, engine order id of a resting order to its slot
+    std::vector<OrderOwner>                     m_owners;//matching thread only, by slot
+    std::vector<std::uint32_t>                  m_freeOwners;//matching thread only
+    OrderLatencyStats                           m_latency;//matching thread only
+    std::unique_ptr<MarketDataPublisher>        mp_marketData;//matching thread only, after run() started
+    Common::SPSCRing<GatewayRequest>            m_requests;
+    Common::SPSCRing<GatewayReport>             m_reports;
+    std::atomic<bool>                           m_isMatching = {true};
+    std::atomic<bool>                           m_isGatewayWaiting = {false};
+    std::vector<GatewaySession>                 m_sessions;//gateway thread only, from here on
+    std::vector<std::uint32_t>                  m_freeSessions;
+    std::vector<std::uint32_t>                  m_dirtySessions;
+    GatewayRequest                              m_pending[GATEWAY_BATCH_SIZE];
+    std::size_t                                 m_pendingCount = 0;
+    OrderIndex                                  m_traderSessions;//trader id to the session slot it's bound to
+    unsigned                                    m_lastOrderId = 0;
+    bool                                        m_isOutOfOrderIds = false;
+    std::uint64_t                               m_acceptedCount = 0;
+    std::uint64_t                               m_requestCount = 0;
+    std::uint64_t                               m_rejectedCount = 0;
+    std::uint64_t                               m_reportCount = 0;
+    std::uint64_t                               m_droppedReportCount = 0;
+    std::uint64_t                               m_slowSessionCount = 0;
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Macros.h"
+#include "MemoryUtils.h"
+#include "OrderNodePool.h"
+
+// Open-addressing(linear probing) map from order id to its node in OrderNodePool.
+// Order id 0 marks an empty slot, deletions use backward shifting so there are no tombstones and probe chains stay short
+// under heavy cancel flow. The table doubles once it's half full, so rehashing is amortized and rare when pre-sized.
+class OrderIndex {
+    struct Slot {
+        unsigned        m_orderId = 0;
+        std::uint32_t   m_nodeIdx = OrderNodePool::NIL;
+    };
+public:
+    explicit OrderIndex(std::size_t expectedOrders) :
+        m_slots(makeSlots(std::bit_ceil(std::max<std::size_t>(expectedOrders * 2, 16)))),
+        m_mask(m_slots.size() - 1)
+    {}
+
+    [[nodiscard]] std::uint32_t find(unsigned orderId) const noexcept {
+        for(std::size_t pos = slotOf(orderId);; pos = (pos + 1) & m_mask) {
+            const Slot& slot = m_slots[pos];
+            if(slot.m_orderId == orderId) {
+                return slot.m_nodeIdx;
+            }
+            if(slot.m_orderId == 0) {
+                return OrderNodePool::NIL;
+            }
+        }
+    }
+
+    // returns false if the id is already present or 0, the empty slot marker
+    bool insert(unsigned orderId, std::uint32_t nodeIdx) {
+        if(UNLIKELY(orderId == 0)) {
+            return false;
+        }
+        if(UNLIKELY((m_size + 1) * 2 > m_slots.size())) {
+            rehash(m_slots.size() * 2);
+        }
+        std::size_t pos = slotOf(orderId);
+        while(m_slots[pos].m_orderId != 0) {
+            if(m_slots[pos].m_orderId == orderId) {
+                return false;
+            }
+            pos = (pos + 1) & m_mask;
+        }
+        m_slots[pos] = Slot{orderId, nodeIdx};
+        ++m_size;
+        return true;
+    }
+
+    void erase(unsigned orderId) noexcept {
+        if(UNLIKELY(orderId == 0)) {//would match the first empty slot
+            return;
+        }
+        std::size_t pos = slotOf(orderId);
+        while(m_slots[pos].m_orderId != orderId) {
+            if(m_slots[pos].m_orderId == 0) {
+                return;
+            }
+            pos = (pos + 1) & m_mask;
+        }
+        // shift back following entries of the cluster which would become unreachable through the hole
+        std::size_t hole = pos;
+        for(std::size_t next = (hole + 1) & m_mask; m_slots[next].m_orderId != 0; next = (next + 1) & m_mask) {
+            const std::size_t home = slotOf(m_slots[next].m_orderId);
+            if(((next - home) & m_mask) >= ((next - hole) & m_mask)) {
+                m_slots[hole] = m_slots[next];
+                hole = next;
+            }
+        }
+        m_slots[hole] = Slot{};
+        --m_size;
+    }
+
+    // requests the home slot of an order id, so a later find() or erase() of it doesn't wait for memory
+    [[gnu::always_inline]] void prefetch(unsigned orderId) const noexcept { __builtin_prefetch(&m_slots[slotOf(orderId)], 1); }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_slots.size(); }
+
+private:
+    [[nodiscard]] std::size_t slotOf(unsigned orderId) const noexcept {
+        return static_cast<std::size_t>((orderId * 0x9E3779B97F4A7C15ull) >> 32) & m_mask;//Fibonacci hashing
+    }
+
+    // large tables are backed by transparent huge pages where the kernel allows
+    static std::vector<Slot> makeSlots(std::size_t count) {
+        std::vector<Slot> slots;
+        slots.reserve(count);
+        Common::adviseHugePages(slots.data(), count * sizeof(Slot));//before resize() touches the slots
+        slots.resize(count);
+        return slots;
+    }
+
+    void rehash(std::size_t newCapacity) {
+        std::vector<Slot> old = makeSlots(newCapacity);
+        old.swap(m_slots);
+        m_mask = m_slots.size() - 1;
+        m_size = 0;
+        for(const Slot& slot : old) {
+            if(slot.m_orderId != 0) {
+                insert(slot.m_orderId, slot.m_nodeIdx);
+            }
+        }
+    }
+
+    std::vector<Slot>   m_slots;
+    std::size_t         m_mask;
+    std::size_t         m_size = 0;
+};
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "BinaryOrderStream.h"
+#include "BookOrder.h"
+#include "LatencyHistogram.h"
+#include "Macros.h"
+#include "SPSCRing.h"
+#include "ThreadUtils.h"
+#include "TimeUtils.h"
+#include "TraderRegistry.h"
+
+enum class JournalSync : std::uint8_t {
+    NONE = 0,   // groups are handed to the kernel without syncing, a crash of the host may lose any of them
+    GROUP = 1,  // every group is fdatasync'ed, matching never waits, a crash loses at most the groups in flight
+    STRICT = 2  // as GROUP, and trades are only written out once the requests that caused them are durable
+};
+
+inline bool journalSyncByName(std::string_view name, JournalSync& sync) noexcept {
+    if(name == "none") {
+        sync = JournalSync::NONE;
+    } else if(name == "group") {
+        sync = JournalSync::GROUP;
+    } else if(name == "strict") {
+        sync = JournalSync::STRICT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+struct JournalConfig {
+    std::string     m_fileName;
+    JournalSync     m_sync = JournalSync::GROUP;
+    unsigned        m_commitDelayUs = 0;//a group may wait this long for more requests, fewer syncs for more latency
+};
+
+// Write-ahead journal of the inbound requests in the binary order stream format(BinaryOrderStream.h): every request is
+// appended, with its engine order id and arrival time, before it reaches the book, so replaying the journal as binary
+// input rebuilds the same book and the same trades. The matching thread only pushes records into an SPSC ring;
+// an I/O thread writes whatever has accumulated as one group with a single pwrite() and fdatasync(), so requests arriving
+// during a sync share the next one. File space is preallocated ahead of the writes and the file size always ends at the
+// last written record, so the journal of a crashed run is read back up to its last complete record.
+// Names of the interned trader ids go to <journal>.traders in id order: the matching thread only publishes how many of them
+// its requests refer to, the I/O thread writes and syncs the new ones out of the registry before the records of its group.
+class OrderJournal {
+public:
+    static constexpr std::size_t RING_SIZE = 64 * 1024;
+    static constexpr std::size_t MAX_GROUP_RECORDS = 16 * 1024;
+    static constexpr std::size_t PREALLOCATE_BYTES = 64 * 1024 * 1024;
+
+    // firstRequest is the number of input requests before the first journaled one, e.g. those of a restored snapshot,
+    // traderNames resolves the interned trader ids of the journaled requests
+    OrderJournal(const JournalConfig& config, std::uint64_t firstRequest, const TraderRegistry* traderNames = nullptr) :
+        m_config{config},
+        m_firstRequest{firstRequest},
+        mp_traderNames{traderNames},
+        m_ring{RING_SIZE}
+    {
+        m_fd = ::open(m_config.m_fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        ASSERT(m_fd >= 0, "OrderJournal: could not open " + m_config.m_fileName + " errno:" + std::string(strerror(errno)));
+        const std::string namesPath = m_config.m_fileName + TRADER_NAMES_SUFFIX;
+        if(mp_traderNames) {
+            m_namesFd = ::open(namesPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            ASSERT(m_namesFd >= 0, "OrderJournal: could not open " + namesPath + " errno:" + std::string(strerror(errno)));
+        } else {
+            ::unlink(namesPath.c_str());//names of an earlier journal of that name would be taken for this one's
+        }
+        const BinaryStreamHeader header = BinaryOrderWriter::makeHeader(0, m_firstRequest);//0: the reader trusts the file size
+        writeAt(m_fd, &header, sizeof(header), 0);
+        m_offset = sizeof(header);
+        preallocate();
+        mp_thread = Common::createAndStartThread(-1, "Journal/commit", [this]() { commitLoop(); });
+        ASSERT(mp_thread != nullptr, "Failed to start the journal commit thread.");
+    }
+
+    ~OrderJournal() { close(); }
+
+    // matching thread: journals a request before it is executed
+    void append(const BookOrder& order) {
+        const Common::Nanos now = Common::getCurrentNanos();
+        const BinaryOrderRecord record = BinaryOrderRecord::fromOrder(order, static_cast<std::uint64_t>(now));
+        if(UNLIKELY(TraderRegistry::isInterned(order.getId())) && mp_traderNames && mp_traderNames->isKnown(order.getId())) {
+            const std::size_t traderCount = (order.getId() & ~TraderRegistry::INTERNED_BIT) + 1;
+            if(traderCount > m_traderCount) {//published before the record, so its group finds the name
+                m_traderCount = traderCount;
+                m_journaledTraders.store(traderCount, std::memory_order_release);
+            }
+        }
+        unsigned spins = 0;
+        while(UNLIKELY(!m_ring.tryPush(record))) {//the journal can't keep up, matching slows down to its pace
+            Common::spinWait(spins);
+        }
+        ++m_appendedCount;
+        m_appendLatency.record(static_cast<std::uint64_t>(Common::getCurrentNanos() - now));
+    }
+
+    // matching thread: blocks until every request appended so far is committed(written, and synced unless NONE)
+    void waitCommitted() {
+        const Common::Nanos start = Common::getCurrentNanos();
+        unsigned spins = 0;
+        while(m_committedCount.load(std::memory_order_acquire) < m_appendedCount) {
+            Common::spinWait(spins);
+        }
+        m_waitLatency.record(static_cast<std::uint64_t>(Common::getCurrentNanos() - start));
+    }
+
+    [[nodiscard]] bool isStrict() const noexcept { return m_config.m_sync == JournalSync::STRICT; }
+
+    // matching thread: commits the rest, trims the preallocated tail, records the count in the header and prints the statistics
+    void close() {
+        if(!mp_thread) {
+            return;
+        }
+        m_isRunning.store(false, std::memory_order_release);
+        mp_thread->join();
+        delete mp_thread;
+        mp_thread = nullptr;
+        if(::ftruncate(m_fd, static_cast<off_t>(m_offset)) != 0) {
+            reportError("ftruncate");
+        }
+        const BinaryStreamHeader header = BinaryOrderWriter::makeHeader(m_committedCount.load(std::memory_order_relaxed), m_firstRequest);
+        writeAt(m_fd, &header, sizeof(header), 0);
+        if(m_config.m_sync != JournalSync::NONE && ::fdatasync(m_fd) != 0) {
+            reportError("fdatasync");
+        }
+        ::close(m_fd);
+        m_fd = -1;
+        if(m_namesFd >= 0) {//every name was synced with its group
+            ::close(m_namesFd);
+            m_namesFd = -1;
+        }
+        print(std::cout);
+    }
+
+    OrderJournal(const OrderJournal&) = delete;
+    OrderJournal& operator=(const OrderJournal&) = delete;
+
+private:
+    void commitLoop() {
+        std::vector<BinaryOrderRecord> group(MAX_GROUP_RECORDS);
+        m_startTime = Common::getCurrentNanos();
+        const Common::Nanos commitDelay = static_cast<Common::Nanos>(m_config.m_commitDelayUs) * Common::NANOS_TO_MICROS;
+        unsigned spins = 0;
+        while(true) {
+            std::size_t count = m_ring.tryPopN(group.data(), MAX_GROUP_RECORDS);
+            if(!count) {
+                if(!m_isRunning.load(std::memory_order_acquire) && m_ring.empty()) {
+                    break;
+                }
+                Common::spinWait(spins);
+                continue;
+            }
+            if(commitDelay) {//let the group grow until it is full or its oldest request has waited long enough
+                const Common::Nanos deadline = static_cast<Common::Nanos>(group[0].m_timestamp) + commitDelay;
+                while(count < MAX_GROUP_RECORDS && Common::getCurrentNanos() < deadline && m_isRunning.load(std::memory_order_relaxed)) {
+                    count += m_ring.tryPopN(group.data() + count, MAX_GROUP_RECORDS - count);
+                }
+            }
+            commit(group.data(), count);
+        }
+        m_stopTime = Common::getCurrentNanos();
+    }
+
+    void commit(const BinaryOrderRecord* records, std::size_t count) {
+        commitTraders();
+        const std::size_t bytes = count * sizeof(BinaryOrderRecord);
+        if(m_offset + bytes > m_allocated) {
+            preallocate();
+        }
+        writeAt(m_fd, records, bytes, m_offset);
+        m_offset += bytes;
+        if(m_config.m_sync != JournalSync::NONE) {
+            const Common::Nanos syncStart = Common::getCurrentNanos();
+            if(::fdatasync(m_fd) != 0) {
+                reportError("fdatasync");
+            }
+            m_syncTime.record(static_cast<std::uint64_t>(Common::getCurrentNanos() - syncStart));
+        }
+        m_committedCount.store(m_committedCount.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        m_commitLatency.record(static_cast<std::uint64_t>(Common::getCurrentNanos() - static_cast<Common::Nanos>(records[0].m_timestamp)));
+        m_groupSizes.record(count);
+    }
+
+    // writes the names the records popped so far refer to and were not written yet, synced unless NONE
+    void commitTraders() {
+        const std::size_t traderCount = m_journaledTraders.load(std::memory_order_acquire);
+        if(traderCount <= m_tradersWritten) {
+            return;
+        }
+        m_names.clear();
+        mp_traderNames->appendNames(m_tradersWritten, traderCount, m_names);
+        writeAt(m_namesFd, m_names.data(), m_names.size(), m_namesOffset);
+        m_namesOffset += m_names.size();
+        m_tradersWritten = traderCount;
+        if(m_config.m_sync != JournalSync::NONE && ::fdatasync(m_namesFd) != 0) {
+            reportError("fdatasync");
+        }
+    }
+
+    // reserves the next blocks without growing the file, so a reader never sees records that weren't written
+    void preallocate() {
+        if(::fallocate(m_fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(m_allocated), static_cast<off_t>(PREALLOCATE_BYTES)) != 0) {
+            reportError("fallocate");//not every file system supports it, the writes then allocate as they go
+        }
+        m_allocated += PREALLOCATE_BYTES;
+    }
+
+    static void writeAt(int fd, const void* data, std::size_t size, std::size_t offset) {
+        const char* pos = static_cast<const char*>(data);
+        while(size) {
+            const ssize_t rc = ::pwrite(fd, pos, size, static_cast<off_t>(offset));
+            if(rc < 0) {
+                ASSERT(errno == EINTR, "OrderJournal: pwrite() failed. errno:" + std::string(strerror(errno)));
+                continue;
+            }
+            pos += rc;
+            offset += static_cast<std::size_t>(rc);
+            size -= static_cast<std::size_t>(rc);
+        }
+    }
+
+    void reportError(const char* call) {
+        if(!m_isErrorReported) {
+            std::cerr << "OrderJournal " << call << " failed on " << m_config.m_fileName << ": " << std::strerror(errno) << std::endl;
+        }
+        m_isErrorReported = true;
+    }
+
+    void print(std::ostream& os) const {
+        const std::uint64_t committed = m_committedCount.load(std::memory_order_relaxed);
+        const double seconds = static_cast<double>(m_stopTime - m_startTime) / static_cast<double>(Common::NANOS_TO_SECS);
+        const double bytes = static_cast<double>(committed * sizeof(BinaryOrderRecord));
+        os << "Journal: " << committed << " requests in " << m_groupSizes.count() << " groups to " << m_config.m_fileName << ", "
+           << (seconds > 0 ? static_cast<double>(committed) / seconds : 0.0) << " requests/s, "
+           << (seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0) << " MB/s" << std::endl;
+        m_groupSizes.print(os, "Journal group size(requests)");
+        m_appendLatency.print(os, "Journal append(ns), added to every request");
+        m_commitLatency.print(os, "Journal commit(ns), oldest request of a group appended to committed");
+        if(m_config.m_sync != JournalSync::NONE) {
+            m_syncTime.print(os, "Journal fdatasync(ns)");
+        }
+        if(m_config.m_sync == JournalSync::STRICT) {
+            m_waitLatency.print(os, "Journal output wait(ns), trades held back until committed");
+        }
+    }
+
+    const JournalConfig                     m_config;
+    const std::uint64_t                     m_firstRequest;
+    const TraderRegistry*                   mp_traderNames;
+    int                                     m_fd = -1;
+    int                                     m_namesFd = -1;
+    Common::SPSCRing<BinaryOrderRecord>     m_ring;
+    std::thread*                            mp_thread = nullptr;
+    std::atomic<bool>                       m_isRunning = {true};
+    std::atomic<std::uint64_t>              m_committedCount = {0};
+    std::uint64_t                           m_appendedCount = 0;//matching thread
+    std::size_t                             m_traderCount = 0;//interned ids [0, m_traderCount) are referred to so far
+    std::atomic<std::size_t>                m_journaledTraders = {0};//m_traderCount for the commit thread
+    Common::LatencyHistogram                m_appendLatency;
+    Common::LatencyHistogram                m_waitLatency;
+    std::size_t                             m_offset = 0;//commit thread, from here on
+    std::size_t                             m_allocated = 0;
+    std::size_t                             m_tradersWritten = 0;
+    std::size_t                             m_namesOffset = 0;
+    std::string                             m_names;
+    Common::LatencyHistogram                m_commitLatency;
+    Common::LatencyHistogram                m_syncTime;
+    Common::LatencyHistogram                m_groupSizes;
+    Common::Nanos                           m_startTime = 0;
+    Common::Nanos                           m_stopTime = 0;
+    bool                                    m_isErrorReported = false;
+};
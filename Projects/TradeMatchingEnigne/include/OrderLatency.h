@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "ExecOutcome.h"
+#include "LatencyHistogram.h"
+
+// Matching latency per request: overall, by outcome of the request and by the number of price levels an aggressor swept.
+// Every thread records into its own instance, instances are merged for the final report.
+class OrderLatencyStats {
+public:
+    static constexpr unsigned MAX_SWEPT_LEVELS = 8;//aggressors sweeping more levels share the last histogram
+
+    void record(std::uint64_t nanoseconds, ExecOutcome outcome, unsigned levelsSwept) noexcept {
+        m_all.record(nanoseconds);
+        m_byOutcome[static_cast<std::size_t>(outcome)].record(nanoseconds);
+        if(levelsSwept) {
+            m_bySweptLevels[std::min(levelsSwept, MAX_SWEPT_LEVELS) - 1].record(nanoseconds);
+        }
+    }
+
+    void merge(const OrderLatencyStats& other) noexcept {
+        m_all.merge(other.m_all);
+        for(std::size_t i = 0; i < m_byOutcome.size(); ++i) {
+            m_byOutcome[i].merge(other.m_byOutcome[i]);
+        }
+        for(std::size_t i = 0; i < m_bySweptLevels.size(); ++i) {
+            m_bySweptLevels[i].merge(other.m_bySweptLevels[i]);
+        }
+    }
+
+    [[nodiscard]] const Common::LatencyHistogram& all() const noexcept { return m_all; }
+
+    // one line per non-empty histogram
+    void print(std::ostream& os) const {
+        m_all.print(os, "Latency(ns) all requests");
+        for(std::size_t i = 0; i < m_byOutcome.size(); ++i) {
+            if(m_byOutcome[i].count()) {
+                m_byOutcome[i].print(os, std::string("Latency(ns) ") + outcomeName(static_cast<ExecOutcome>(i)));
+            }
+        }
+        for(std::size_t i = 0; i < m_bySweptLevels.size(); ++i) {
+            if(m_bySweptLevels[i].count()) {
+                const std::string levels = std::to_string(i + 1) + (i + 1 == MAX_SWEPT_LEVELS ? "+" : "");
+                m_bySweptLevels[i].print(os, "Latency(ns) sweeping " + levels + " level(s)");
+            }
+        }
+    }
+
+private:
+    Common::LatencyHistogram                                                                m_all;
+    std::array<Common::LatencyHistogram, static_cast<std::size_t>(ExecOutcome::COUNT)>     m_byOutcome;
+    std::array<Common::LatencyHistogram, MAX_SWEPT_LEVELS>                                  m_bySweptLevels;
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "BookOrder.h"
+#include "Macros.h"
+#include "MemoryUtils.h"
+
+struct OrderNode {
+    BookOrder       m_order;
+    std::uint32_t   m_prev;
+    std::uint32_t   m_next;
+};
+
+// Pre-sized storage of resting orders. Nodes are addressed by 32-bit indices, which keeps links compact and stays valid
+// when the pool has to grow. Free nodes are chained through m_next, so acquire/release never touch the global allocator
+// unless the pre-sized capacity is exhausted. Large pools are backed by transparent huge pages where the kernel allows.
+class OrderNodePool {
+public:
+    static constexpr std::uint32_t NIL = std::numeric_limits<std::uint32_t>::max();
+
+    explicit OrderNodePool(std::size_t capacity) {
+        grow(std::max<std::size_t>(capacity, 1));
+        m_growCount = 0;
+    }
+
+    [[nodiscard]] std::uint32_t acquire(const BookOrder& order) {
+        if(UNLIKELY(m_freeHead == NIL)) {
+            grow(m_nodes.size());
+        }
+        const std::uint32_t idx = m_freeHead;
+        OrderNode& node = m_nodes[idx];
+        m_freeHead = node.m_next;
+        std::construct_at(&node.m_order, order);
+        node.m_prev = NIL;
+        node.m_next = NIL;
+        m_highWater = std::max(++m_inUse, m_highWater);
+        return idx;
+    }
+
+    void release(std::uint32_t idx) noexcept {
+        m_nodes[idx].m_next = m_freeHead;
+        m_freeHead = idx;
+        --m_inUse;
+    }
+
+    OrderNode& operator[](std::uint32_t idx) noexcept { return m_nodes[idx]; }
+    const OrderNode& operator[](std::uint32_t idx) const noexcept { return m_nodes[idx]; }
+
+    [[gnu::always_inline]] void prefetch(std::uint32_t idx) const noexcept { __builtin_prefetch(&m_nodes[idx], 1); }
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_nodes.size(); }
+    [[nodiscard]] std::size_t inUse() const noexcept { return m_inUse; }
+    [[nodiscard]] std::size_t highWater() const noexcept { return m_highWater; }
+    [[nodiscard]] std::size_t growCount() const noexcept { return m_growCount; }
+    // e.g. after a warm-up, so the mark reflects real orders only
+    void resetHighWater() noexcept { m_highWater = m_inUse; }
+
+private:
+    void grow(std::size_t extra) {
+        const std::size_t oldSize = m_nodes.size();
+        ASSERT(oldSize + extra < NIL, "OrderNodePool: capacity exceeds 32-bit node index range");
+        m_nodes.reserve(oldSize + extra);
+        Common::adviseHugePages(m_nodes.data() + oldSize, extra * sizeof(OrderNode));//before resize() touches the new nodes
+        m_nodes.resize(oldSize + extra);
+        for(std::size_t idx = oldSize + extra; idx-- > oldSize;) {//lowest indices are handed out first
+            m_nodes[idx].m_next = m_freeHead;
+            m_freeHead = static_cast<std::uint32_t>(idx);
+        }
+        ++m_growCount;
+    }
+
+    std::vector<OrderNode>  m_nodes;
+    std::uint32_t           m_freeHead = NIL;
+    std::size_t             m_inUse = 0;
+    std::size_t             m_highWater = 0;
+    std::size_t             m_growCount = 0;
+};
+
+// FIFO of resting orders at one price level, intrusively linked through OrderNode::m_prev/m_next.
+// It's a pair of indices plus the level's total quantity and order count, kept up to date by every change of the FIFO,
+// so map backends can store and erase levels without touching order storage and depth queries never walk the orders.
+// Quantities of linked orders must be changed through setQuantity().
+class OrderLevel {
+public:
+    [[nodiscard]] bool empty() const noexcept { return m_head == OrderNodePool::NIL; }
+    [[nodiscard]] std::uint32_t front() const noexcept { return m_head; }
+    [[nodiscard]] std::uint32_t back() const noexcept { return m_tail; }
+    [[nodiscard]] std::uint64_t quantity() const noexcept { return m_quantity; }
+    [[nodiscard]] std::uint32_t orderCount() const noexcept { return m_orderCount; }
+
+    void pushBack(OrderNodePool& pool, std::uint32_t idx) noexcept {
+        m_quantity += pool[idx].m_order.getQuantity();
+        ++m_orderCount;
+        pool[idx].m_prev = m_tail;
+        pool[idx].m_next = OrderNodePool::NIL;
+        if(m_tail != OrderNodePool::NIL) {
+            pool[m_tail].m_next = idx;
+        } else {
+            m_head = idx;
+        }
+        m_tail = idx;
+    }
+
+    // unlinks the oldest order and gives its node back to the pool
+    void popFront(OrderNodePool& pool) noexcept {
+        const std::uint32_t idx = m_head;
+        m_quantity -= pool[idx].m_order.getQuantity();
+        --m_orderCount;
+        m_head = pool[idx].m_next;
+        if(m_head != OrderNodePool::NIL) {
+            pool[m_head].m_prev = OrderNodePool::NIL;
+        } else {
+            m_tail = OrderNodePool::NIL;
+        }
+        pool.release(idx);
+    }
+
+    // unlinks an order from any position of the FIFO and gives its node back to the pool
+    void unlink(OrderNodePool& pool, std::uint32_t idx) noexcept {
+        m_quantity -= pool[idx].m_order.getQuantity();
+        --m_orderCount;
+        const std::uint32_t prev = pool[idx].m_prev;
+        const std::uint32_t next = pool[idx].m_next;
+        if(prev != OrderNodePool::NIL) {
+            pool[prev].m_next = next;
+        } else {
+            m_head = next;
+        }
+        if(next != OrderNodePool::NIL) {
+            pool[next].m_prev = prev;
+        } else {
+            m_tail = prev;
+        }
+        pool.release(idx);
+    }
+
+    // changes the quantity of a linked order in place, it keeps its queue position
+    void setQuantity(OrderNodePool& pool, std::uint32_t idx, unsigned quantity) noexcept {
+        BookOrder& order = pool[idx].m_order;
+        m_quantity = m_quantity - order.getQuantity() + quantity;
+        order.setQuantity(quantity);
+    }
+
+private:
+    std::uint64_t m_quantity = 0;
+    std::uint32_t m_head = OrderNodePool::NIL;
+    std::uint32_t m_tail = OrderNodePool::NIL;
+    std::uint32_t m_orderCount = 0;
+};
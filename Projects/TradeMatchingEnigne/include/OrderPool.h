@@ -0,0 +1,597 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <type_traits>
+
+#include "ArenaResource.h"
+#include "BookOrder.h"
+#include "CallAuction.h"
+#include "ExecOutcome.h"
+#include "Fill.h"
+#include "OrderIndex.h"
+#include "OrderNodePool.h"
+#include "SidePolicy.h"
+#include "Macros.h"
+
+// A price level whose resting orders changed during the last tryExecute() call.
+struct LevelChange {
+    unsigned    m_price;
+    char        m_side;
+};
+
+// Aggregate of the resting orders at one price level.
+struct LevelDepth {
+    std::uint64_t   m_quantity = 0;
+    unsigned        m_orderCount = 0;
+};
+
+// A price level and the aggregate of its resting orders.
+struct BookLevel {
+    unsigned    m_price = 0;
+    LevelDepth  m_depth;
+};
+
+// Size of the synthetic flow OrderPool::warmUp() runs through an empty book.
+struct WarmUpConfig {
+    std::size_t m_levels = 1024;//expected book depth, price levels per side
+    std::size_t m_orders = 0;//expected resting orders, 0 or more than the node capacity take the node capacity
+};
+
+template <class MapContBuy, class MapContSell>
+class OrderPool {
+    using buyContIterator =     typename MapContBuy::iterator;
+    using sellContIterator =    typename MapContSell::iterator;
+    static_assert(std::is_same_v<typename MapContBuy::mapped_type, OrderLevel> && std::is_same_v<typename MapContSell::mapped_type, OrderLevel>,
+                  "OrderPool price levels must be OrderLevel FIFOs");
+    Common::ArenaResource              m_arena;//of allocator-aware level containers, declared first to outlive them
+    MapContBuy                         m_buyOrders;
+    MapContSell                        m_sellOrders;
+    OrderNodePool                      m_nodes;
+    OrderIndex                         m_index;
+    std::vector<Fill>                  m_fills;//fills of the last tryExecute() call
+    ExecOutcome                        m_outcome = ExecOutcome::Ignored;//of the last tryExecute() call
+    unsigned                           m_levelsSwept = 0;//price levels the last aggressor traded against
+    std::vector<LevelChange>           m_levelChanges;//of the last tryExecute() call, only while tracking
+    bool                               m_isTrackingLevels = false;
+    bool                               m_isCallPhase = false;//orders rest without matching until uncross()
+    AuctionCurves                      m_auctionCurves;
+    std::vector<BookLevel>             m_crossedBids;//scratch of indicativeUncross()
+public:
+    static constexpr std::size_t DEFAULT_NODE_CAPACITY = 1 << 16;
+    static constexpr std::size_t FILLS_RESERVE = 256;
+    static constexpr std::size_t PREFETCH_DISTANCE = 8;//orders ahead of the one being matched whose memory is requested
+    static constexpr unsigned WARM_UP_MID_PRICE = 2048;//warm-up prices stay inside the default PriceLadder band
+    static constexpr unsigned WARM_UP_TRADER = 1;
+
+    // Level containers using std::pmr::polymorphic_allocator(LevelMaps.h) allocate from the pool's arena, others are
+    // default constructed.
+    explicit OrderPool(std::size_t nodeCapacity = DEFAULT_NODE_CAPACITY, const Common::ArenaConfig& arenaConfig = {}) :
+        m_arena{arenaConfig},
+        m_buyOrders{std::make_obj_using_allocator<MapContBuy>(std::pmr::polymorphic_allocator<>(&m_arena))},
+        m_sellOrders{std::make_obj_using_allocator<MapContSell>(std::pmr::polymorphic_allocator<>(&m_arena))},
+        m_nodes{nodeCapacity},
+        m_index{nodeCapacity}
+    {
+        m_fills.reserve(FILLS_RESERVE);
+    }
+    OrderPool(const OrderPool&) = delete;
+    OrderPool& operator=(const OrderPool&) = delete;
+    [[nodiscard]] const OrderNodePool& nodePool() const noexcept { return m_nodes; }
+    [[nodiscard]] const Common::ArenaResource& arena() const noexcept { return m_arena; }
+    [[nodiscard]] std::span<const Fill> fills() const noexcept { return m_fills; }
+    [[nodiscard]] ExecOutcome outcome() const noexcept { return m_outcome; }
+    [[nodiscard]] unsigned levelsSwept() const noexcept { return m_levelsSwept; }
+    [[nodiscard]] bool isResting(unsigned orderId) const noexcept { return m_index.find(orderId) != OrderNodePool::NIL; }
+    // levels changed by the last tryExecute() call, in no particular order and possibly repeated
+    [[nodiscard]] std::span<const LevelChange> levelChanges() const noexcept { return m_levelChanges; }
+    void trackLevelChanges(bool isTracking) {
+        m_isTrackingLevels = isTracking;
+        m_levelChanges.reserve(FILLS_RESERVE);
+    }
+    // Depth queries read the totals every OrderLevel maintains, so none of them touches individual orders.
+    // an empty depth if there is no level at the price
+    [[nodiscard]] LevelDepth levelDepth(char side, unsigned price) const {
+        return (side == 'S') ? levelDepthOf(m_sellOrders, price) : levelDepthOf(m_buyOrders, price);
+    }
+    // best level of a side, an empty depth if the side is empty
+    [[nodiscard]] BookLevel bestLevel(char side) const {
+        return (side == 'S') ? bestLevelOf(m_sellOrders) : bestLevelOf(m_buyOrders);
+    }
+    [[nodiscard]] BookLevel bestBid() const { return bestLevelOf(m_buyOrders); }
+    [[nodiscard]] BookLevel bestAsk() const { return bestLevelOf(m_sellOrders); }
+    // fills levels with the best levels of a side, best first, and returns how many there were
+    std::size_t topLevels(char side, std::span<BookLevel> levels) const {
+        return (side == 'S') ? topLevelsOf(m_sellOrders, levels) : topLevelsOf(m_buyOrders, levels);
+    }
+    // total of the levels priced at limitPrice or better(bids at or above it, asks at or below it), i.e. what an opposite
+    // aggressor limited at that price could trade against, costs one step per level within the limit
+    [[nodiscard]] LevelDepth depthUpTo(char side, unsigned limitPrice) const {
+        return (side == 'S') ? depthUpToOf(m_sellOrders, limitPrice) : depthUpToOf(m_buyOrders, limitPrice);
+    }
+    // visitor(price, LevelDepth) for every level of a side, best price first
+    template<class Visitor>
+    void forEachLevel(char side, Visitor&& visitor) const {
+        auto visitAll = [&](const auto& cont) {
+            for(const auto& level : cont) {
+                visitor(level.first, depthOf(level.second));
+            }
+        };
+        if(side == 'S') {
+            visitAll(m_sellOrders);
+        } else {
+            visitAll(m_buyOrders);
+        }
+    }
+    // visitor(const BookOrder&) for every resting order of a side, best level first and in queue order within a level
+    template<class Visitor>
+    void forEachOrder(char side, Visitor&& visitor) const {
+        auto visitAll = [&](const auto& cont) {
+            for(const auto& level : cont) {
+                for(std::uint32_t idx = level.second.front(); idx != OrderNodePool::NIL; idx = m_nodes[idx].m_next) {
+                    visitor(m_nodes[idx].m_order);
+                }
+            }
+        };
+        if(side == 'S') {
+            visitAll(m_sellOrders);
+        } else {
+            visitAll(m_buyOrders);
+        }
+    }
+    // false for prices a bounded backend(PriceLadder) can't hold, new orders and amendments to them are rejected
+    [[nodiscard]] static constexpr bool isInBand(unsigned price) noexcept {
+        return fitsBook<MapContBuy>(price) && fitsBook<MapContSell>(price);
+    }
+    // appends a resting order to the back of its level without matching it, e.g. when a book is loaded from a snapshot
+    bool restoreOrder(const BookOrder& order) {
+        if(UNLIKELY(!order.isValid() || (order.getSide() != 'B' && order.getSide() != 'S') || !isInBand(order.getPrice()))) {
+            return false;
+        }
+        return addOrder(order);
+    }
+    // Call auction: while the call phase is on, new and re-entered orders rest without matching, so the book may cross.
+    // uncross() then executes everything at one clearing price. Cancels and amendments work as in continuous trading.
+    void setCallPhase(bool isCallPhase) noexcept { m_isCallPhase = isCallPhase; }
+    [[nodiscard]] bool isCallPhase() const noexcept { return m_isCallPhase; }
+    // the clearing price and volume an uncross would have now, without executing anything(see AuctionCurves)
+    AuctionResult indicativeUncross(unsigned referencePrice = 0) {
+        m_auctionCurves.clear();
+        if(m_buyOrders.empty() || m_sellOrders.empty() || m_buyOrders.begin()->first < m_sellOrders.begin()->first) {
+            return AuctionResult{};
+        }
+        const unsigned bestBid = m_buyOrders.begin()->first;
+        const unsigned bestAsk = m_sellOrders.begin()->first;
+        m_crossedBids.clear();
+        for(auto it = m_buyOrders.begin(); it != m_buyOrders.end() && it->first >= bestAsk; ++it) {
+            m_crossedBids.push_back(BookLevel{it->first, depthOf(it->second)});
+        }
+        auto bid = m_crossedBids.rbegin();//ascending like the asks
+        for(auto ask = m_sellOrders.begin(); ask != m_sellOrders.end() && ask->first <= bestBid; ++ask) {
+            for(; bid != m_crossedBids.rend() && bid->m_price < ask->first; ++bid) {
+                m_auctionCurves.addLevel(bid->m_price, bid->m_depth.m_quantity, 0);
+            }
+            const bool isShared = (bid != m_crossedBids.rend() && bid->m_price == ask->first);
+            m_auctionCurves.addLevel(ask->first, isShared ? (bid++)->m_depth.m_quantity : 0, ask->second.quantity());
+        }
+        for(; bid != m_crossedBids.rend(); ++bid) {
+            m_auctionCurves.addLevel(bid->m_price, bid->m_depth.m_quantity, 0);
+        }
+        return m_auctionCurves.clearingPrice(referencePrice);
+    }
+    // Executes the crossed book at its clearing price: bids from the highest price and asks from the lowest, each level in
+    // queue order, are paired in one pass until the volume is done. Fills and level changes are reported as for tryExecute()
+    // and the book no longer crosses afterwards.
+    AuctionResult uncross(unsigned referencePrice = 0) {
+        m_fills.clear();
+        m_outcome = ExecOutcome::Ignored;
+        m_levelsSwept = 0;
+        m_levelChanges.clear();
+        const AuctionResult result = indicativeUncross(referencePrice);
+        auto bid = m_buyOrders.begin();
+        auto ask = m_sellOrders.begin();
+        unsigned lastBidPrice = 0;
+        unsigned lastAskPrice = 0;
+        for(std::uint64_t remaining = result.m_volume; remaining;) {
+            if(bid->first != lastBidPrice) {
+                lastBidPrice = bid->first;
+                recordLevelChange('B', lastBidPrice);
+                ++m_levelsSwept;
+            }
+            if(ask->first != lastAskPrice) {
+                lastAskPrice = ask->first;
+                recordLevelChange('S', lastAskPrice);
+                ++m_levelsSwept;
+            }
+            const BookOrder& buyer = m_nodes[bid->second.front()].m_order;
+            const BookOrder& seller = m_nodes[ask->second.front()].m_order;
+            const unsigned quantity = static_cast<unsigned>(std::min<std::uint64_t>({buyer.getQuantity(), seller.getQuantity(), remaining}));
+            m_fills.push_back(Fill{buyer.getId(), quantity, result.m_price, 'B', buyer.getOrderId()});
+            m_fills.push_back(Fill{seller.getId(), quantity, result.m_price, 'S', seller.getOrderId()});
+            remaining -= quantity;
+            fillFront(m_buyOrders, bid, quantity);
+            fillFront(m_sellOrders, ask, quantity);
+        }
+        if(result.m_volume) {
+            m_outcome = ExecOutcome::Filled;
+        }
+        return result;
+    }
+    // Runs synthetic flow through the empty book before the first real request, so level containers, the order index, fill
+    // buffers and the level arena grow to their working size and their memory is touched: orders rest on config.m_levels levels
+    // per side around WARM_UP_MID_PRICE, every 4th of them is cancelled, every 8th reduced and aggressors sweep the rest level
+    // by level. The book is empty again afterwards and the order ids used are free, only the arena statistics remember it.
+    // Returns the number of orders that rested.
+    std::size_t warmUp(const WarmUpConfig& config) {
+        ASSERT(m_index.size() == 0 && !m_isCallPhase, "OrderPool: warm-up needs an empty book in continuous trading");
+        const std::size_t orders = (config.m_orders && config.m_orders < m_nodes.capacity()) ? config.m_orders : m_nodes.capacity();
+        const unsigned levels = static_cast<unsigned>(std::clamp<std::size_t>(config.m_levels, 1, WARM_UP_MID_PRICE - 1));
+        const auto priceOf = [levels](std::size_t i) {
+            const unsigned offset = 1 + static_cast<unsigned>(i / 2 % levels);
+            return (i & 1) ? WARM_UP_MID_PRICE - offset : WARM_UP_MID_PRICE + offset;//buys below the mid, sells above it
+        };
+        for(std::size_t i = 0; i < orders; ++i) {
+            BookOrder order{WARM_UP_TRADER, 2, priceOf(i), (i & 1) ? 'B' : 'S', static_cast<unsigned>(i + 1)};
+            tryExecute(order);
+        }
+        for(std::size_t i = 0; i < orders; ++i) {
+            if(i / 2 % 4 == 1) {//pairs of orders, a buy and a sell
+                BookOrder cancel{WARM_UP_TRADER, 0, 0, 'C', static_cast<unsigned>(i + 1)};
+                tryExecute(cancel);
+            } else if(i / 2 % 8 == 2) {
+                BookOrder amendment{WARM_UP_TRADER, 1, priceOf(i), 'M', static_cast<unsigned>(i + 1)};
+                tryExecute(amendment);
+            }
+        }
+        unsigned aggressorId = static_cast<unsigned>(orders);
+        for(const char side : {'B', 'S'}) {
+            for(BookLevel level = bestLevel(side); level.m_depth.m_orderCount; level = bestLevel(side)) {
+                BookOrder aggressor{WARM_UP_TRADER, static_cast<unsigned>(level.m_depth.m_quantity), level.m_price, (side == 'B') ? 'S' : 'B', ++aggressorId};
+                tryExecute(aggressor);
+            }
+        }
+        ASSERT(m_index.size() == 0, "OrderPool: warm-up left orders in the book");
+        m_fills.clear();
+        m_outcome = ExecOutcome::Ignored;
+        m_levelsSwept = 0;
+        m_levelChanges.clear();
+        m_nodes.resetHighWater();
+        return orders;
+    }
+private:
+    // executes quantity of the oldest order of a level, the iterator moves on if that empties the level
+    template<class OrderTypeMap>
+    void fillFront(OrderTypeMap& cont, typename OrderTypeMap::iterator& it, unsigned quantity) {
+        OrderLevel& level = it->second;
+        const BookOrder& resting = m_nodes[level.front()].m_order;
+        if(resting.getQuantity() > quantity) {
+            level.setQuantity(m_nodes, level.front(), resting.getQuantity() - quantity);
+            return;
+        }
+        m_index.erase(resting.getOrderId());
+        level.popFront(m_nodes);
+        if(level.empty()) {
+            it = cont.erase(it);
+        }
+    }
+    static LevelDepth depthOf(const OrderLevel& level) noexcept {
+        return LevelDepth{level.quantity(), level.orderCount()};
+    }
+    template<class OrderTypeMap>
+    static LevelDepth levelDepthOf(const OrderTypeMap& cont, unsigned price) {
+        const auto it = cont.find(price);
+        return (it != cont.end()) ? depthOf(it->second) : LevelDepth{};
+    }
+    template<class OrderTypeMap>
+    static BookLevel bestLevelOf(const OrderTypeMap& cont) {
+        const auto it = cont.begin();
+        return (it != cont.end()) ? BookLevel{it->first, depthOf(it->second)} : BookLevel{};
+    }
+    template<class OrderTypeMap>
+    static std::size_t topLevelsOf(const OrderTypeMap& cont, std::span<BookLevel> levels) {
+        std::size_t count = 0;
+        for(auto it = cont.begin(); it != cont.end() && count < levels.size(); ++it) {
+            levels[count++] = BookLevel{it->first, depthOf(it->second)};
+        }
+        return count;
+    }
+    template<class OrderTypeMap>
+    static LevelDepth depthUpToOf(const OrderTypeMap& cont, unsigned limitPrice) {
+        LevelDepth depth;
+        for(auto it = cont.begin(); it != cont.end() && !cont.key_comp()(limitPrice, it->first); ++it) {//levels are best first
+            depth.m_quantity += it->second.quantity();
+            depth.m_orderCount += it->second.orderCount();
+        }
+        return depth;
+    }
+    // quantity changes of resting orders go through their level, which keeps its total
+    template<class OrderTypeMap>
+    void setRestingQuantity(OrderTypeMap& cont, std::uint32_t idx, unsigned quantity) {
+        cont.find(m_nodes[idx].m_order.getPrice())->second.setQuantity(m_nodes, idx, quantity);
+    }
+    void recordLevelChange(char side, unsigned price) {
+        if(m_isTrackingLevels) {
+            m_levelChanges.push_back(LevelChange{price, side});
+        }
+    }
+    template<class MapCont>
+    static constexpr bool fitsBook(unsigned price) noexcept {
+        if constexpr (requires { MapCont::isInBand(price); }) {//bounded backends(PriceLadder) can't store out of band levels
+            return MapCont::isInBand(price);
+        } else {
+            return true;
+        }
+    }
+    void dumpOrders() const {
+        std::cout << "Dumping Buy orders..."<<std::endl;
+        for(const auto& elems : m_buyOrders) {
+            for(std::uint32_t idx = elems.second.front(); idx != OrderNodePool::NIL; idx = m_nodes[idx].m_next) {
+                m_nodes[idx].m_order.print();
+            }
+        }
+        std::cout << std::endl<<"Dumping Sell orders..."<<std::endl;
+        for(const auto& elems : m_sellOrders) {
+            for(std::uint32_t idx = elems.second.front(); idx != OrderNodePool::NIL; idx = m_nodes[idx].m_next) {
+                m_nodes[idx].m_order.print();
+            }
+        }
+        std::cout <<std::endl;    
+    }
+    // book of the orders resting on a side
+    template<char Side>
+    auto& bookOf() noexcept {
+        if constexpr (Side == 'S') {
+            return m_sellOrders;
+        } else {
+            return m_buyOrders;
+        }
+    }
+    template<class Side>
+    bool addOrder(const BookOrder& order) {
+        const std::uint32_t idx = m_nodes.acquire(order);
+        if(UNLIKELY(!m_index.insert(order.getOrderId(), idx))) {//order id of a live resting order can't be reused
+            m_nodes.release(idx);
+            return false;
+        }
+        bookOf<Side::SIDE>()[order.getPrice()].pushBack(m_nodes, idx);
+        recordLevelChange(Side::SIDE, order.getPrice());
+        return true;
+    }
+    bool addOrder(const BookOrder& order) {
+        return (order.getSide() == 'S') ? addOrder<SellSide>(order) : addOrder<BuySide>(order);
+    }
+    template<class OrderTypeMap>
+    void unlinkFromLevel(OrderTypeMap& cont, std::uint32_t idx) {
+        auto it = cont.find(m_nodes[idx].m_order.getPrice());
+        it->second.unlink(m_nodes, idx);
+        if(it->second.empty()) {
+            cont.erase(it);
+        }
+    }
+    void removeResting(std::uint32_t idx) {
+        const BookOrder& resting = m_nodes[idx].m_order;
+        recordLevelChange(resting.getSide(), resting.getPrice());
+        m_index.erase(resting.getOrderId());
+        if (resting.getSide() == 'S') {
+            unlinkFromLevel(m_sellOrders, idx);
+        }
+        else {
+            unlinkFromLevel(m_buyOrders, idx);
+        }
+    }
+    void cancelOrder(const BookOrder& request) {
+        const std::uint32_t idx = m_index.find(request.getOrderId());
+        if(idx == OrderNodePool::NIL || m_nodes[idx].m_order.getId() != request.getId()) {
+            return;//unknown or already executed order, or it belongs to another trader
+        }
+        removeResting(idx);
+        m_outcome = ExecOutcome::Cancelled;
+    }
+    void modifyOrder(const BookOrder& request) {
+        const std::uint32_t idx = m_index.find(request.getOrderId());
+        if(idx == OrderNodePool::NIL || m_nodes[idx].m_order.getId() != request.getId()) {
+            return;
+        }
+        BookOrder& resting = m_nodes[idx].m_order;
+        if(request.getPrice() == resting.getPrice() && request.getQuantity() <= resting.getQuantity()) {
+            //quantity down at the same price keeps queue priority
+            if(resting.getSide() == 'S') {
+                setRestingQuantity(m_sellOrders, idx, request.getQuantity());
+            } else {
+                setRestingQuantity(m_buyOrders, idx, request.getQuantity());
+            }
+            recordLevelChange(resting.getSide(), resting.getPrice());
+            m_outcome = ExecOutcome::Amended;
+            return;
+        }
+        if(UNLIKELY(!isInBand(request.getPrice()))) {
+            m_outcome = ExecOutcome::Rejected;//the re-entered order couldn't rest, so the order keeps its place unchanged
+            return;
+        }
+        //any other amendment loses priority: the order is pulled and re-entered as a new aggressor with the same id
+        BookOrder replacement{resting.getId(), request.getQuantity(), request.getPrice(), resting.getSide(), resting.getOrderId()};
+        const LevelChange pulledFrom{resting.getPrice(), resting.getSide()};
+        removeResting(idx);
+        tryExecute(replacement);
+        recordLevelChange(pulledFrom.m_side, pulledFrom.m_price);//tryExecute() starts a new list
+    }
+    void recordExecution(const BookOrder& resting, const BookOrder& aggressor) {
+        const unsigned dealQuantity = std::min(resting.getQuantity(), aggressor.getQuantity());
+        //trades happen at the resting order's price
+        m_fills.push_back(Fill{resting.getId(), dealQuantity, resting.getPrice(), resting.getSide(), resting.getOrderId()});
+        m_fills.push_back(Fill{aggressor.getId(), dealQuantity, resting.getPrice(), aggressor.getSide(), aggressor.getOrderId()});
+    }
+    template<class OrderTypeMap>
+    bool updateAll(OrderTypeMap& cont, OrderTypeMap::iterator& it, BookOrder& order) {
+        OrderLevel& level = it->second;
+        BookOrder& resting = m_nodes[level.front()].m_order;
+        const bool mutuallyComplete = resting.getQuantity() == order.getQuantity();
+        bool isFinalUpdate = false;
+        if(UNLIKELY(mutuallyComplete)) {
+            m_index.erase(resting.getOrderId());
+            level.popFront(m_nodes);
+            if(level.empty()) {
+                it = cont.erase(it);
+            }
+            isFinalUpdate = true;
+        }
+        else {
+            const bool isOrderComplete = (order.getQuantity() <= resting.getQuantity());
+            if(isOrderComplete) {
+                const int orderQuantity = static_cast<int>(order.getQuantity());
+                const int remainedQuantity = static_cast<int>(resting.getQuantity()) - orderQuantity;
+                level.setQuantity(m_nodes, level.front(), static_cast<unsigned>(remainedQuantity));
+                isFinalUpdate = true;
+            }
+            else {
+                const int orderInPoolQuantity = static_cast<int>(resting.getQuantity());
+                const int remainedQuantity = static_cast<int>(order.getQuantity()) - orderInPoolQuantity;
+                m_index.erase(resting.getOrderId());
+                level.popFront(m_nodes);
+                if(level.empty()) {
+                    it = cont.erase(it);
+                }
+                order.setQuantity(remainedQuantity);
+                isFinalUpdate = false;//still need to be processed
+            }
+        }
+        return isFinalUpdate;
+    }
+public:
+    void tryExecute(BookOrder& order) {
+        m_fills.clear();
+        m_outcome = ExecOutcome::Ignored;
+        m_levelsSwept = 0;
+        m_levelChanges.clear();
+        if(LIKELY(order.isValid())) {
+            if(UNLIKELY(order.getSide() == 'C')) {
+                cancelOrder(order);
+                return;
+            }
+            if(UNLIKELY(order.getSide() == 'M')) {
+                modifyOrder(order);
+                return;
+            }
+            if(UNLIKELY(!isInBand(order.getPrice()))) {
+                m_outcome = ExecOutcome::Rejected;
+                return;
+            }
+            if(UNLIKELY(m_isCallPhase)) {
+                if(addOrder(order)) {
+                    m_outcome = ExecOutcome::Rested;
+                }
+                return;
+            }
+            if(order.getSide() == 'S') {//the only runtime side dispatch, everything below is instantiated per side
+                matchOrder<SellSide>(order);
+            } else {
+                matchOrder<BuySide>(order);
+            }
+        }
+    }
+    // Executes the orders one after another exactly like tryExecute() and calls onExecuted(i) after order i, while fills(),
+    // outcome() and levelChanges() describe it. Meanwhile the memory of the orders ahead is requested in two stages:
+    // 2 * PREFETCH_DISTANCE ahead the index slot of a cancel or amendment and the level slot of a new order(backends with
+    // direct level addressing), PREFETCH_DISTANCE ahead the resting node the index points to, the front order of the opposite
+    // best level and the tail order of the level a new order would join. Prefetches are hints only, an order executes
+    // against the book as left by every order before it.
+    template<class OnExecuted>
+    void tryExecuteBatch(std::span<BookOrder> orders, OnExecuted&& onExecuted) {
+        const std::size_t count = orders.size();
+        for(std::size_t i = 0; i < std::min(count, 2 * PREFETCH_DISTANCE); ++i) {
+            prefetchFar(orders[i]);
+        }
+        for(std::size_t i = 0; i < std::min(count, PREFETCH_DISTANCE); ++i) {
+            prefetchNear(orders[i]);
+        }
+        for(std::size_t i = 0; i < count; ++i) {
+            if(i + 2 * PREFETCH_DISTANCE < count) {
+                prefetchFar(orders[i + 2 * PREFETCH_DISTANCE]);
+            }
+            if(i + PREFETCH_DISTANCE < count) {
+                prefetchNear(orders[i + PREFETCH_DISTANCE]);
+            }
+            tryExecute(orders[i]);
+            onExecuted(i);
+        }
+    }
+private:
+    template<class MapCont>
+    static constexpr bool hasDirectLevels() noexcept {//a level is found without searching(PriceLadder)
+        return requires(const MapCont& cont, unsigned price) { cont.prefetch(price); };
+    }
+    // The prefetch helpers are always inlined: GCC considers a function doing nothing but prefetching pure and drops calls
+    // to it, prefetches only survive inside tryExecuteBatch() itself.
+    [[gnu::always_inline]] void prefetchFar(const BookOrder& order) const noexcept {
+        if(order.getSide() == 'C' || order.getSide() == 'M') {
+            m_index.prefetch(order.getOrderId());
+        } else if(order.getSide() == 'S') {
+            if constexpr (hasDirectLevels<MapContSell>()) {
+                m_sellOrders.prefetch(order.getPrice());
+            }
+        } else if constexpr (hasDirectLevels<MapContBuy>()) {
+            m_buyOrders.prefetch(order.getPrice());
+        }
+    }
+    [[gnu::always_inline]] void prefetchNear(const BookOrder& order) const {
+        if(order.getSide() == 'C' || order.getSide() == 'M') {
+            const std::uint32_t idx = m_index.find(order.getOrderId());
+            if(idx != OrderNodePool::NIL) {
+                m_nodes.prefetch(idx);
+            }
+        } else if(order.getSide() == 'S') {
+            prefetchLevels<MapContSell>(m_buyOrders, m_sellOrders, order.getPrice());
+        } else {
+            prefetchLevels<MapContBuy>(m_sellOrders, m_buyOrders, order.getPrice());
+        }
+    }
+    template<class SameSideMap, class OppositeMap>
+    [[gnu::always_inline]] void prefetchLevels(const OppositeMap& opposite, const SameSideMap& same, unsigned price) const {
+        if(!opposite.empty()) {
+            m_nodes.prefetch(opposite.begin()->second.front());
+        }
+        if constexpr (hasDirectLevels<SameSideMap>()) {
+            const auto it = same.find(price);
+            if(it != same.end()) {
+                m_nodes.prefetch(it->second.back());
+            }
+        }
+    }
+    // an order that doesn't cross the best opposite price rests at once, otherwise it sweeps the opposite book
+    template<class Side>
+    void matchOrder(BookOrder& order) {
+        auto& cont = bookOf<Side::OPPOSITE>();
+        if(cont.empty() || !Side::crosses(cont.begin()->first, order.getPrice())) {
+            if(addOrder<Side>(order)) {
+                m_outcome = ExecOutcome::Rested;
+            }
+            return;
+        }
+        executeOrder<Side>(cont, order);
+    }
+    template<class Side, class OrderTypeMap>
+    void executeOrder(OrderTypeMap& cont, BookOrder& order) {
+        auto it = cont.begin();
+        bool isFinalUpdate = false;
+        unsigned lastLevelPrice = 0;
+        while(it != cont.end() && !isFinalUpdate && Side::crosses(it->first, order.getPrice())) {
+            const unsigned currContPrice = it->first;
+            if(currContPrice != lastLevelPrice) {
+                ++m_levelsSwept;
+                lastLevelPrice = currContPrice;
+                recordLevelChange(Side::OPPOSITE, currContPrice);
+            }
+            recordExecution(m_nodes[it->second.front()].m_order, order);
+            isFinalUpdate = updateAll(cont, it, order);
+        }
+        //the remainder rests once the opposite side is exhausted or no longer crosses
+        const bool hasRemainder = !isFinalUpdate && addOrder<Side>(order);
+        m_outcome = hasRemainder ? ExecOutcome::PartiallyFilled : ExecOutcome::Filled;
+    }
+};
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "BinaryOrderStream.h"
+#include "BookOrder.h"
+#include "Fill.h"
+#include "InputReader.h"
+#include "LineParser.h"
+#include "LineSplitter.h"
+#include "Macros.h"
+#include "OrderLatency.h"
+#include "OrderPool.h"
+#include "SPSCRing.h"
+#include "ThreadUtils.h"
+#include "TimeUtils.h"
+#include "TradeReporter.h"
+#include "TraderRegistry.h"
+
+// Busy/idle accounting of one pipeline stage. Only waits on a ring are timed, so the fast path costs no clock reads.
+struct StageStats {
+    using clock = std::chrono::steady_clock;
+
+    void start() noexcept { m_start = clock::now(); }
+    void stop() noexcept { m_lifetime = clock::now() - m_start; }
+
+    template<class F>
+    void waitUntil(F&& isReady) noexcept {
+        if(LIKELY(isReady())) {
+            return;
+        }
+        const auto waitStart = clock::now();
+        unsigned spins = 0;
+        do {
+            Common::spinWait(spins);
+        } while(!isReady());
+        m_idle += clock::now() - waitStart;
+    }
+
+    void sampleDepth(std::size_t depth) noexcept {
+        m_depthSum += depth;
+        ++m_depthSamples;
+        m_depthMax = std::max(m_depthMax, depth);
+    }
+
+    void dump(std::ostream& os, std::string_view name, bool hasInputRing) const {
+        const auto lifetime = std::chrono::duration_cast<std::chrono::nanoseconds>(m_lifetime).count();
+        const auto busy = lifetime - std::chrono::duration_cast<std::chrono::nanoseconds>(m_idle).count();
+        os << "Stage " << name << " busy(ns): " << busy << " of " << lifetime << " ("
+           << (lifetime ? 100.0 * static_cast<double>(busy) / static_cast<double>(lifetime) : 0.0) << "%)";
+        if(hasInputRing) {
+            os << " input ring depth avg: " << (m_depthSamples ? static_cast<double>(m_depthSum) / static_cast<double>(m_depthSamples) : 0.0)
+               << " max: " << m_depthMax;
+        }
+        os << '\n';
+    }
+
+    clock::time_point       m_start{};
+    clock::duration         m_lifetime{};
+    clock::duration         m_idle{};
+    std::uint64_t           m_depthSum = 0;
+    std::uint64_t           m_depthSamples = 0;
+    std::size_t             m_depthMax = 0;
+};
+
+// Runs parsing, matching and reporting on three threads connected by SPSC rings, orders and fills moving in batches.
+// The matching thread owns the OrderPool and forwards the fills of every aggressor followed by an end marker,
+// so the report thread renders exactly the lines of the single-threaded Extractor in the same order.
+template<class MapContBuy, class MapContSell>
+class PipelinedExtractor {
+public:
+    static constexpr std::size_t ORDER_RING_SIZE = 64 * 1024;
+    static constexpr std::size_t FILL_RING_SIZE = 256 * 1024;
+    static constexpr std::size_t PIPELINE_BATCH_SIZE = 256;
+    static constexpr char END_OF_AGGRESSOR = '\0';//m_side of the marker closing the fills of one aggressor
+
+    // parse, match and report stages are pinned to firstCore, firstCore + 1 and firstCore + 2, negative firstCore disables pinning
+    PipelinedExtractor(bool dbgMode, int firstCore, std::size_t nodeCapacity = OrderPool<MapContBuy, MapContSell>::DEFAULT_NODE_CAPACITY,
+                       const Common::ArenaConfig& arenaConfig = {}) :
+        m_firstCore{firstCore},
+        m_orderPool{nodeCapacity, arenaConfig},
+        m_orders{ORDER_RING_SIZE},
+        m_fills{FILL_RING_SIZE}
+    {
+        m_lineParser.setDbgMode(dbgMode);
+        m_lineParser.setPriceBand(&OrderPool<MapContBuy, MapContSell>::isInBand);
+    }
+
+    // before process(): grows the book to its working size and touches its memory through synthetic matching(OrderPool::warmUp())
+    void warmUp(const WarmUpConfig& config) {
+        const Common::Nanos start = Common::getCurrentNanos();
+        const std::size_t orders = m_orderPool.warmUp(config);
+        std::cout << "Warm-up: " << orders << " orders on " << config.m_levels << " levels per side in " << Common::getCurrentNanos() - start
+                  << " ns" << std::endl;
+    }
+
+    void process(Common::InputReader& input) {
+        run([&](auto&& emit) {
+            auto newlines = std::make_unique<std::uint32_t[]>(Common::LINE_SCAN_CHUNK_SIZE);
+            std::string_view block;
+            while(input.nextBlock(block)) {
+                Common::forEachLine(block, newlines.get(),
+                    [&](const char* lineBegin, const char* lineEnd) { emit(m_lineParser.process(lineBegin, lineEnd)); },
+                    []() {});
+            }
+        });
+    }
+
+    // before process(): loads the trader names of binary input(<input>.traders)
+    bool loadTraders(const std::string& inputPath) {
+        std::string error;
+        if(!loadTraderNames(inputPath, m_traders, error)) {
+            std::cerr << "Could not load the trader names: " << error << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    void process(const BinaryOrderReader& input) {
+        run([&](auto&& emit) {
+            for(const BinaryOrderRecord& record : input.records()) {
+                emit(m_lineParser.makeOrder(record.m_traderId, record.m_side, record.m_quantity, record.m_price, record.engineOrderId()));
+            }
+        });
+    }
+
+    PipelinedExtractor(const PipelinedExtractor&) = delete;
+    PipelinedExtractor& operator=(const PipelinedExtractor&) = delete;
+
+private:
+    template<class Source>
+    void run(Source&& source) {
+        const int coreCount = static_cast<int>(std::thread::hardware_concurrency());
+        auto coreOf = [&](int stage) { return (m_firstCore >= 0 && m_firstCore + stage < coreCount) ? m_firstCore + stage : -1; };
+        //stages wait for each other behind m_isStarted, so thread start-up stays out of the measured window
+        std::thread* reportThread = Common::createAndStartThread(coreOf(2), "Pipeline/report", [this]() { reportStage(); });
+        std::thread* matchThread = Common::createAndStartThread(coreOf(1), "Pipeline/match", [this]() { matchStage(); });
+        std::thread* parseThread = Common::createAndStartThread(coreOf(0), "Pipeline/parse", [this, &source]() { parseStage(source); });
+        ASSERT(reportThread && matchThread && parseThread, "Failed to start pipeline threads.");
+        const auto start = std::chrono::steady_clock::now();
+        m_isStarted.store(true, std::memory_order_release);
+        for(std::thread* thread : {parseThread, matchThread, reportThread}) {
+            thread->join();
+            delete thread;
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << "Orders' total processed time(ns): " << m_latency.all().sum() << std::endl;
+        std::cout << "Pipeline: " << m_orderCount << " orders in " << elapsed.count() << " ns("
+                  << (elapsed.count() ? static_cast<double>(m_orderCount) * 1e9 / static_cast<double>(elapsed.count()) : 0.0) << " orders/s)" << '\n';
+        m_parseStats.dump(std::cout, "parse", false);
+        m_matchStats.dump(std::cout, "match", true);
+        m_reportStats.dump(std::cout, "report", true);
+        m_latency.print(std::cout);
+        const OrderNodePool& nodes = m_orderPool.nodePool();
+        std::cout << "Order node pool capacity: " << nodes.capacity() << " high-water mark: " << nodes.highWater()
+                  << " grow events: " << nodes.growCount() << std::endl;
+        m_orderPool.arena().print(std::cout, "Level arena");
+    }
+
+    void waitForStart() const noexcept {
+        unsigned spins = 0;
+        while(!m_isStarted.load(std::memory_order_acquire)) {
+            Common::spinWait(spins);
+        }
+    }
+
+    template<class Ring, class T>
+    static void pushAll(Ring& ring, const T* items, std::size_t count, StageStats& stats) {
+        std::size_t pushed = 0;
+        stats.waitUntil([&]() {
+            pushed += ring.tryPushN(items + pushed, count - pushed);
+            return pushed == count;
+        });
+    }
+
+    template<class Source>
+    void parseStage(Source& source) {
+        waitForStart();
+        m_parseStats.start();
+        std::unique_ptr<BookOrder[]> batch = std::make_unique<BookOrder[]>(PIPELINE_BATCH_SIZE);
+        std::size_t size = 0;
+        source([&](const BookOrder& order) {
+            if(!order.isValid()) {//tryExecute() ignores them, no need to pass them on
+                return;
+            }
+            std::construct_at(&batch[size++], order);
+            if(size == PIPELINE_BATCH_SIZE) {
+                pushAll(m_orders, batch.get(), size, m_parseStats);
+                size = 0;
+            }
+        });
+        pushAll(m_orders, batch.get(), size, m_parseStats);
+        m_isParseDone.store(true, std::memory_order_release);
+        m_parseStats.stop();
+    }
+
+    void matchStage() {
+        using clock = std::chrono::high_resolution_clock;
+        waitForStart();
+        m_matchStats.start();
+        std::unique_ptr<BookOrder[]> batch = std::make_unique<BookOrder[]>(PIPELINE_BATCH_SIZE);
+        std::vector<Fill> out;
+        out.reserve(PIPELINE_BATCH_SIZE * 4);
+        while(true) {
+            const std::size_t depth = m_orders.size();
+            const std::size_t count = m_orders.tryPopN(batch.get(), PIPELINE_BATCH_SIZE);
+            if(!count) {
+                if(m_isParseDone.load(std::memory_order_acquire) && m_orders.empty()) {
+                    break;
+                }
+                m_matchStats.waitUntil([&]() { return !m_orders.empty() || m_isParseDone.load(std::memory_order_acquire); });
+                continue;
+            }
+            m_matchStats.sampleDepth(depth);
+            for(std::size_t i = 0; i < count; ++i) {
+                auto start = clock::now();
+                m_orderPool.tryExecute(batch[i]);
+                const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+                m_latency.record(static_cast<std::uint64_t>(elapsed), m_orderPool.outcome(), m_orderPool.levelsSwept());
+                const auto fills = m_orderPool.fills();
+                if(!fills.empty()) {
+                    out.insert(out.end(), fills.begin(), fills.end());
+                    out.push_back(Fill{0, 0, 0, END_OF_AGGRESSOR, 0});
+                }
+            }
+            m_orderCount += count;
+            pushAll(m_fills, out.data(), out.size(), m_matchStats);
+            out.clear();
+        }
+        m_isMatchDone.store(true, std::memory_order_release);
+        m_matchStats.stop();
+    }
+
+    void reportStage() {
+        waitForStart();
+        m_reportStats.start();
+        Fill batch[PIPELINE_BATCH_SIZE];
+        std::vector<Fill> aggressorFills;
+        aggressorFills.reserve(OrderPool<MapContBuy, MapContSell>::FILLS_RESERVE);
+        while(true) {
+            const std::size_t depth = m_fills.size();
+            const std::size_t count = m_fills.tryPopN(batch, PIPELINE_BATCH_SIZE);
+            if(!count) {
+                if(m_isMatchDone.load(std::memory_order_acquire) && m_fills.empty()) {
+                    break;
+                }
+                m_reportStats.waitUntil([&]() { return !m_fills.empty() || m_isMatchDone.load(std::memory_order_acquire); });
+                continue;
+            }
+            m_reportStats.sampleDepth(depth);
+            for(std::size_t i = 0; i < count; ++i) {
+                if(batch[i].m_side == END_OF_AGGRESSOR) {
+                    m_reporter.report(aggressorFills);
+                    aggressorFills.clear();
+                } else {
+                    aggressorFills.push_back(batch[i]);
+                }
+            }
+        }
+        m_reporter.flush();
+        m_reportStats.stop();
+    }
+
+    int                                     m_firstCore;
+    TraderRegistry                          m_traders;//interned by the parse stage, names read by the report stage
+    LineParser                              m_lineParser{&m_traders};//parse stage only
+    OrderPool<MapContBuy, MapContSell>      m_orderPool;//match stage only
+    TradeReporter                           m_reporter{STDOUT_FILENO, nullptr, &m_traders};//report stage only
+    Common::SPSCRing<BookOrder>             m_orders;
+    Common::SPSCRing<Fill>                  m_fills;
+    std::atomic<bool>                       m_isStarted = {false};
+    std::atomic<bool>                       m_isParseDone = {false};
+    std::atomic<bool>                       m_isMatchDone = {false};
+    std::uint64_t                           m_orderCount = 0;
+    OrderLatencyStats                       m_latency;//match stage only
+    StageStats                              m_parseStats;
+    StageStats                              m_matchStats;
+    StageStats                              m_reportStats;
+};
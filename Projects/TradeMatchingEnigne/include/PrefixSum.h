@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace Common {
+  namespace detail {
+    inline auto prefixSumScalar(const uint64_t *in, uint64_t *out, size_t len, uint64_t carry) noexcept -> uint64_t {
+      for (size_t i = 0; i < len; ++i) {
+        carry += in[i];
+        out[i] = carry;
+      }
+      return carry;
+    }
+
+#if defined(__x86_64__)
+    /// Scans 4 values per step: two shifted adds give the in-register prefix, the last lane carries into the next step.
+    /// Compiled for AVX2 regardless of the global -march.
+    __attribute__((target("avx2"))) inline auto prefixSumAVX2(const uint64_t *in, uint64_t *out, size_t len, uint64_t carry) noexcept -> uint64_t {
+      __m256i running = _mm256_set1_epi64x(static_cast<long long>(carry));
+      size_t i = 0;
+      for (; i + 4 <= len; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        // (a, b, c, d) + (0, a, b, c)
+        x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x90), _mm256_setzero_si256(), 0x03));
+        // + (0, 0, a, a + b)
+        x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x40), _mm256_setzero_si256(), 0x0F));
+        x = _mm256_add_epi64(x, running);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), x);
+        running = _mm256_permute4x64_epi64(x, 0xFF);
+      }
+      return prefixSumScalar(in + i, out + i, len - i, static_cast<uint64_t>(_mm256_extract_epi64(running, 0)));
+    }
+#endif
+
+    using PrefixSumFn = uint64_t (*)(const uint64_t *, uint64_t *, size_t, uint64_t) noexcept;
+
+    inline auto pickPrefixSum() noexcept -> PrefixSumFn {
+#if defined(__x86_64__)
+      if (__builtin_cpu_supports("avx2"))
+        return prefixSumAVX2;
+#endif
+      return prefixSumScalar;
+    }
+  }
+
+  /// Writes the inclusive prefix sums of in[0, len) into out(in == out is fine) and returns the total.
+  /// The widest scan supported by the CPU is picked once at first use.
+  inline auto inclusivePrefixSum(const uint64_t *in, uint64_t *out, size_t len) noexcept -> uint64_t {
+    static const detail::PrefixSumFn scan = detail::pickPrefixSum();
+    return scan(in, out, len, 0);
+  }
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Macros.h"
+
+// Map-like container for a bounded price band [MinPrice, MaxPrice].
+// The level of price p lives at m_levels[p - MinPrice], so level access is a single index.
+// Occupied levels are tracked by a two-level bitmap(one bit per tick and one summary bit per 64-tick word),
+// so best level and next level lookups are a couple of countr_zero/countl_zero instructions.
+// Compare selects iteration order the same way it does for std::map: std::less -> lowest price first (sell side),
+// std::greater -> highest price first (buy side).
+// Note: erase() only unlinks the level, the slot value is kept for reuse, therefore levels must be drained before erasing.
+template<class T, class Compare = std::less<unsigned>, unsigned MinPrice = 1, unsigned MaxPrice = 4096>
+class PriceLadder {
+    static_assert(MinPrice <= MaxPrice, "PriceLadder: empty price band");
+    static_assert(std::is_same_v<Compare, std::less<unsigned>> || std::is_same_v<Compare, std::greater<unsigned>>,
+                  "PriceLadder supports std::less<unsigned> and std::greater<unsigned> orderings only");
+
+    static constexpr bool        IS_DESCENDING = std::is_same_v<Compare, std::greater<unsigned>>;
+    static constexpr std::size_t LEVELS        = static_cast<std::size_t>(MaxPrice - MinPrice) + 1;
+    static constexpr std::size_t WORDS         = (LEVELS + 63) / 64;
+    static constexpr std::size_t SUMMARY_WORDS = (WORDS + 63) / 64;
+    static constexpr std::size_t NPOS          = LEVELS;
+
+    template<bool IsConst>
+    class Iterator {
+        using LadderPtr = std::conditional_t<IsConst, const PriceLadder*, PriceLadder*>;
+        using ValueRef  = std::conditional_t<IsConst, const T&, T&>;
+    public:
+        struct Reference {
+            const unsigned first;
+            ValueRef       second;
+        };
+        struct ArrowProxy {
+            Reference ref;
+            Reference* operator->() noexcept { return &ref; }
+        };
+
+        Iterator() noexcept = default;
+        Iterator(LadderPtr ladder, std::size_t idx) noexcept : mp_ladder{ladder}, m_idx{idx} {}
+        operator Iterator<true>() const noexcept requires (!IsConst) { return Iterator<true>(mp_ladder, m_idx); }
+
+        Reference operator*() const noexcept { return {static_cast<unsigned>(MinPrice + m_idx), mp_ladder->m_levels[m_idx]}; }
+        ArrowProxy operator->() const noexcept { return ArrowProxy{**this}; }
+        Iterator& operator++() noexcept {
+            m_idx = mp_ladder->nextIdx(m_idx);
+            return *this;
+        }
+        Iterator operator++(int) noexcept {
+            Iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+        bool operator==(const Iterator& other) const noexcept { return m_idx == other.m_idx; }
+        [[nodiscard]] std::size_t index() const noexcept { return m_idx; }
+    private:
+        LadderPtr   mp_ladder = nullptr;
+        std::size_t m_idx     = NPOS;
+    };
+public:
+    using key_type       = unsigned;
+    using mapped_type    = T;
+    using iterator       = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    PriceLadder() :
+        m_levels(LEVELS)
+    {}
+
+    [[nodiscard]] static constexpr bool isInBand(unsigned price) noexcept { return price >= MinPrice && price <= MaxPrice; }
+
+    T& operator[](unsigned price) noexcept {
+        if(UNLIKELY(!isInBand(price))) {
+            FATAL("PriceLadder: price " + std::to_string(price) + " is out of band");
+        }
+        const std::size_t idx = price - MinPrice;
+        const std::size_t word = idx >> 6;
+        const std::uint64_t bit = std::uint64_t{1} << (idx & 63);
+        if(!(m_bits[word] & bit)) {
+            m_bits[word] |= bit;
+            m_summary[word >> 6] |= std::uint64_t{1} << (word & 63);
+            ++m_size;
+        }
+        return m_levels[idx];
+    }
+
+    // requests the level slot and the bitmap word of a price, so a later access to them doesn't wait for memory
+    [[gnu::always_inline]] void prefetch(unsigned price) const noexcept {
+        if(LIKELY(isInBand(price))) {
+            const std::size_t idx = price - MinPrice;
+            __builtin_prefetch(&m_levels[idx], 1);
+            __builtin_prefetch(&m_bits[idx >> 6], 1);
+        }
+    }
+
+    iterator find(unsigned price) noexcept { return iterator(this, isOccupied(price) ? price - MinPrice : NPOS); }
+    const_iterator find(unsigned price) const noexcept { return const_iterator(this, isOccupied(price) ? price - MinPrice : NPOS); }
+
+    iterator erase(iterator it) noexcept {
+        const std::size_t idx = it.index();
+        const std::size_t word = idx >> 6;
+        m_bits[word] &= ~(std::uint64_t{1} << (idx & 63));
+        if(!m_bits[word]) {
+            m_summary[word >> 6] &= ~(std::uint64_t{1} << (word & 63));
+        }
+        --m_size;
+        return iterator(this, nextIdx(idx));
+    }
+
+    iterator begin() noexcept { return iterator(this, firstIdx()); }
+    iterator end() noexcept { return iterator(this, NPOS); }
+    const_iterator begin() const noexcept { return const_iterator(this, firstIdx()); }
+    const_iterator end() const noexcept { return const_iterator(this, NPOS); }
+
+    [[nodiscard]] Compare key_comp() const noexcept { return Compare{}; }
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+    [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+private:
+    [[nodiscard]] bool isOccupied(unsigned price) const noexcept {
+        if(UNLIKELY(!isInBand(price))) {
+            return false;
+        }
+        const std::size_t idx = price - MinPrice;
+        return m_bits[idx >> 6] & (std::uint64_t{1} << (idx & 63));
+    }
+
+    [[nodiscard]] std::size_t firstIdx() const noexcept {
+        if constexpr (IS_DESCENDING) {
+            return findDownFrom(LEVELS - 1);
+        } else {
+            return findUpFrom(0);
+        }
+    }
+
+    [[nodiscard]] std::size_t nextIdx(std::size_t idx) const noexcept {
+        if constexpr (IS_DESCENDING) {
+            return (idx == 0) ? NPOS : findDownFrom(idx - 1);
+        } else {
+            return findUpFrom(idx + 1);
+        }
+    }
+
+    // first occupied level with index >= idx
+    [[nodiscard]] std::size_t findUpFrom(std::size_t idx) const noexcept {
+        if(idx >= LEVELS) {
+            return NPOS;
+        }
+        std::size_t word = idx >> 6;
+        const std::uint64_t bits = m_bits[word] & (~std::uint64_t{0} << (idx & 63));
+        if(bits) {
+            return (word << 6) + std::countr_zero(bits);
+        }
+        const std::size_t nextWord = word + 1;
+        if(nextWord >= WORDS) {
+            return NPOS;
+        }
+        std::size_t sumIdx = nextWord >> 6;
+        std::uint64_t sum = m_summary[sumIdx] & (~std::uint64_t{0} << (nextWord & 63));
+        while(!sum) {
+            if(++sumIdx >= SUMMARY_WORDS) {
+                return NPOS;
+            }
+            sum = m_summary[sumIdx];
+        }
+        word = (sumIdx << 6) + std::countr_zero(sum);
+        return (word << 6) + std::countr_zero(m_bits[word]);
+    }
+
+    // last occupied level with index <= idx
+    [[nodiscard]] std::size_t findDownFrom(std::size_t idx) const noexcept {
+        std::size_t word = idx >> 6;
+        const std::uint64_t bits = m_bits[word] & (~std::uint64_t{0} >> (63 - (idx & 63)));
+        if(bits) {
+            return (word << 6) + 63 - std::countl_zero(bits);
+        }
+        if(word == 0) {
+            return NPOS;
+        }
+        const std::size_t prevWord = word - 1;
+        std::size_t sumIdx = prevWord >> 6;
+        std::uint64_t sum = m_summary[sumIdx] & (~std::uint64_t{0} >> (63 - (prevWord & 63)));
+        while(!sum) {
+            if(sumIdx == 0) {
+                return NPOS;
+            }
+            sum = m_summary[--sumIdx];
+        }
+        word = (sumIdx << 6) + 63 - std::countl_zero(sum);
+        return (word << 6) + 63 - std::countl_zero(m_bits[word]);
+    }
+
+    std::vector<T>                             m_levels;
+    std::array<std::uint64_t, WORDS>           m_bits{};
+    std::array<std::uint64_t, SUMMARY_WORDS>   m_summary{};
+    std::size_t                                m_size = 0;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "Macros.h"
+#include "SPSCRing.h"
+
+namespace Common {
+  /// Single-producer/single-consumer ring of variable-length frames.
+  /// A frame is an 8 byte header(payload size and flags) followed by the payload, padded to 8 bytes. Frames never wrap:
+  /// when the space left before the end of the buffer is too short, the producer fills it with a padding frame that the
+  /// consumer skips. Counters and their cached copies are laid out as in SPSCRing.
+  class SPSCByteRing final {
+  public:
+    static constexpr size_t FRAME_HEADER_SIZE = 8;
+
+    /// Capacity is rounded up to a power of two.
+    explicit SPSCByteRing(std::size_t bytes) :
+        m_capacity(std::bit_ceil(std::max<std::size_t>(bytes, 64))),
+        m_mask(m_capacity - 1),
+        mp_buffer(std::make_unique<char[]>(m_capacity)) {
+    }
+
+    /// Room for a payload of size bytes or nullptr when the ring is full; publish it with commitWrite().
+    auto tryReserve(std::size_t size) noexcept -> char * {
+      const size_t frame = frameSize(size);
+      if (UNLIKELY(frame > m_capacity / 2))
+        return nullptr;
+      size_t tail = m_tail.load(std::memory_order_relaxed);
+      const size_t contiguous = m_capacity - (tail & m_mask);
+      const size_t needed = (frame > contiguous) ? contiguous + frame : frame;
+      if (m_capacity - (tail - m_cachedHead) < needed) {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        if (m_capacity - (tail - m_cachedHead) < needed)
+          return nullptr;
+      }
+      if (frame > contiguous) {
+        writeHeader(tail, static_cast<uint32_t>(contiguous - FRAME_HEADER_SIZE), PADDING);
+        tail += contiguous;
+      }
+      writeHeader(tail, static_cast<uint32_t>(size), 0);
+      m_pendingTail = tail + frame;
+      return mp_buffer.get() + (tail & m_mask) + FRAME_HEADER_SIZE;
+    }
+
+    auto commitWrite() noexcept {
+      m_tail.store(m_pendingTail, std::memory_order_release);
+    }
+
+    /// Payload of the oldest frame or nullptr when the ring is empty; release it with commitRead().
+    auto nextToRead(std::size_t &size) noexcept -> const char * {
+      while (true) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+          m_cachedTail = m_tail.load(std::memory_order_acquire);
+          if (head == m_cachedTail)
+            return nullptr;
+        }
+        uint32_t header[2];
+        std::memcpy(header, mp_buffer.get() + (head & m_mask), sizeof(header));
+        if (header[1] & PADDING) {
+          m_head.store(head + frameSize(header[0]), std::memory_order_release);
+          continue;
+        }
+        size = header[0];
+        return mp_buffer.get() + (head & m_mask) + FRAME_HEADER_SIZE;
+      }
+    }
+
+    auto commitRead() noexcept {
+      const size_t head = m_head.load(std::memory_order_relaxed);
+      uint32_t size;
+      std::memcpy(&size, mp_buffer.get() + (head & m_mask), sizeof(size));
+      m_head.store(head + frameSize(size), std::memory_order_release);
+    }
+
+    auto empty() const noexcept {
+      return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    auto capacity() const noexcept {
+      return m_capacity;
+    }
+
+    /// Largest payload tryReserve() can ever satisfy.
+    auto maxPayload() const noexcept {
+      return m_capacity / 2 - FRAME_HEADER_SIZE;
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    SPSCByteRing() = delete;
+
+    SPSCByteRing(const SPSCByteRing&) = delete;
+
+    SPSCByteRing(const SPSCByteRing&&) = delete;
+
+    SPSCByteRing &operator=(const SPSCByteRing&) = delete;
+
+    SPSCByteRing &operator=(const SPSCByteRing&&) = delete;
+
+  private:
+    static constexpr uint32_t PADDING = 1;
+
+    static constexpr auto frameSize(size_t payload) noexcept -> size_t {
+      return (FRAME_HEADER_SIZE + payload + 7) & ~size_t{7};
+    }
+
+    auto writeHeader(size_t position, uint32_t size, uint32_t flags) noexcept -> void {
+      const uint32_t header[2] = {size, flags};
+      std::memcpy(mp_buffer.get() + (position & m_mask), header, sizeof(header));
+    }
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<char[]> mp_buffer;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail = {0}; // written by the producer.
+    size_t m_cachedHead = 0;
+    size_t m_pendingTail = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head = {0}; // written by the consumer.
+    size_t m_cachedTail = 0;
+  };
+}
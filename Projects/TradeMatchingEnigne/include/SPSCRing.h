@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "Macros.h"
+
+namespace Common {
+  constexpr size_t CACHE_LINE_SIZE = 64;
+
+  namespace detail {
+    /// Stores into an existing slot, also for types whose copy assignment is deleted.
+    template<typename T>
+    inline auto storeSlot(T &slot, const T &value) noexcept {
+      if constexpr (std::is_copy_assignable_v<T>) {
+        slot = value;
+      } else {
+        std::destroy_at(&slot);
+        std::construct_at(&slot, value);
+      }
+    }
+  }
+
+  /// Bounded single-producer/single-consumer ring.
+  /// Head and tail are free-running counters on their own cache lines, masked by the power-of-two capacity.
+  /// Each side keeps a cached copy of the other side's counter and reloads it only when the ring looks full/empty,
+  /// so in steady state a push or pop touches no line written by the other thread except the slot itself.
+  template<typename T>
+  class SPSCRing final {
+  public:
+    /// Capacity is rounded up to a power of two.
+    explicit SPSCRing(std::size_t num_elems) :
+        m_storage(std::bit_ceil(std::max<std::size_t>(num_elems, 2)), T()),
+        m_mask(m_storage.size() - 1) {
+    }
+
+    /// Slot for the next element or nullptr when the ring is full; publish it with commitWrite().
+    auto nextToWrite() noexcept -> T * {
+      const size_t tail = m_tail.load(std::memory_order_relaxed);
+      if (UNLIKELY(tail - m_cachedHead == m_storage.size())) {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        if (tail - m_cachedHead == m_storage.size())
+          return nullptr;
+      }
+      return &m_storage[tail & m_mask];
+    }
+
+    auto commitWrite() noexcept {
+      m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    auto tryPush(const T &value) noexcept {
+      T *slot = nextToWrite();
+      if (UNLIKELY(!slot))
+        return false;
+      detail::storeSlot(*slot, value);
+      commitWrite();
+      return true;
+    }
+
+    /// Pushes up to count elements with a single publication and returns how many were pushed.
+    auto tryPushN(const T *values, std::size_t count) noexcept -> std::size_t {
+      const size_t tail = m_tail.load(std::memory_order_relaxed);
+      size_t free = m_storage.size() - (tail - m_cachedHead);
+      if (free < count) {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        free = m_storage.size() - (tail - m_cachedHead);
+      }
+      const size_t n = std::min(free, count);
+      for (size_t i = 0; i < n; ++i)
+        detail::storeSlot(m_storage[(tail + i) & m_mask], values[i]);
+      if (n)
+        m_tail.store(tail + n, std::memory_order_release);
+      return n;
+    }
+
+    /// Oldest element or nullptr when the ring is empty; release it with commitRead().
+    auto nextToRead() noexcept -> const T * {
+      const size_t head = m_head.load(std::memory_order_relaxed);
+      if (UNLIKELY(head == m_cachedTail)) {
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+        if (head == m_cachedTail)
+          return nullptr;
+      }
+      return &m_storage[head & m_mask];
+    }
+
+    auto commitRead() noexcept {
+      m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    auto tryPop(T &value) noexcept {
+      const T *slot = nextToRead();
+      if (UNLIKELY(!slot))
+        return false;
+      detail::storeSlot(value, *slot);
+      commitRead();
+      return true;
+    }
+
+    /// Pops up to count elements with a single release of their slots and returns how many were popped.
+    auto tryPopN(T *values, std::size_t count) noexcept -> std::size_t {
+      const size_t head = m_head.load(std::memory_order_relaxed);
+      size_t available = m_cachedTail - head;
+      if (available < count) {
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+        available = m_cachedTail - head;
+      }
+      const size_t n = std::min(available, count);
+      for (size_t i = 0; i < n; ++i)
+        detail::storeSlot(values[i], m_storage[(head + i) & m_mask]);
+      if (n)
+        m_head.store(head + n, std::memory_order_release);
+      return n;
+    }
+
+    /// Exact only when called by one of the two sides with the other one idle.
+    auto size() const noexcept {
+      const size_t head = m_head.load(std::memory_order_acquire); // head first, so it can never pass the tail read after it.
+      return m_tail.load(std::memory_order_acquire) - head;
+    }
+
+    auto empty() const noexcept {
+      return size() == 0;
+    }
+
+    auto capacity() const noexcept {
+      return m_storage.size();
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    SPSCRing() = delete;
+
+    SPSCRing(const SPSCRing&) = delete;
+
+    SPSCRing(const SPSCRing&&) = delete;
+
+    SPSCRing &operator=(const SPSCRing&) = delete;
+
+    SPSCRing &operator=(const SPSCRing&&) = delete;
+
+  private:
+    std::vector<T> m_storage;
+    const size_t m_mask;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail = {0}; // written by the producer.
+    size_t m_cachedHead = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head = {0}; // written by the consumer.
+    size_t m_cachedTail = 0;
+  };
+}
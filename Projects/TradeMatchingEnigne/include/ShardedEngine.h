@@ -0,0 +1,213 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "BookOrder.h"
+#include "InputReader.h"
+#include "InstrumentRouter.h"
+#include "LineParser.h"
+#include "LineSplitter.h"
+#include "Macros.h"
+#include "OrderLatency.h"
+#include "OrderPool.h"
+#include "SPSCRing.h"
+#include "ThreadUtils.h"
+#include "TradeReporter.h"
+#include "TraderRegistry.h"
+
+struct ShardMessage {
+    BookOrder       m_order;
+    std::uint16_t   m_instrument;
+};
+
+// Runs one matching thread per shard. Every instrument is owned by exactly one shard(InstrumentRouter::shardOf),
+// which keeps an OrderPool per instrument and is fed through its own single-producer/single-consumer queue,
+// so orders of an instrument are matched and reported in input order without any locking on the matching path.
+template<class MapContBuy, class MapContSell>
+class ShardedEngine {
+public:
+    using Pool = OrderPool<MapContBuy, MapContSell>;
+    static constexpr std::size_t SHARD_QUEUE_SIZE = 64 * 1024;
+
+    // shard i is pinned to core firstCore + i when such a core exists, negative firstCore disables pinning,
+    // traderNames resolves trader ids interned by the producer when trades are reported
+    ShardedEngine(std::size_t shardCount, int firstCore, const InstrumentRouter& router, int outputFd = STDOUT_FILENO,
+                  std::size_t nodeCapacity = Pool::DEFAULT_NODE_CAPACITY, const TraderRegistry* traderNames = nullptr) :
+        m_router{router},
+        m_nodeCapacity{nodeCapacity}
+    {
+        ASSERT(shardCount > 0, "ShardedEngine: at least one shard is needed");
+        const int coreCount = static_cast<int>(std::thread::hardware_concurrency());
+        for(std::size_t i = 0; i < shardCount; ++i) {
+            m_shards.push_back(std::make_unique<Shard>(outputFd, &m_writeMutex, traderNames));
+        }
+        for(std::size_t i = 0; i < shardCount; ++i) {
+            const int core = (firstCore >= 0 && firstCore + static_cast<int>(i) < coreCount) ? firstCore + static_cast<int>(i) : -1;
+            Shard* shard = m_shards[i].get();
+            shard->mp_thread = Common::createAndStartThread(core, "Shard " + std::to_string(i), [this, shard]() { runShard(*shard); });
+            ASSERT(shard->mp_thread != nullptr, "Failed to start shard thread.");
+        }
+    }
+
+    ~ShardedEngine() { finish(); }
+
+    void submit(std::uint16_t instrument, const BookOrder& order) noexcept {
+        auto& queue = m_shards[InstrumentRouter::shardOf(instrument, m_shards.size())]->m_queue;
+        unsigned spins = 0;
+        ShardMessage* slot;
+        while(UNLIKELY(!(slot = queue.nextToWrite()))) {//back-pressure from a slow shard
+            Common::spinWait(spins);
+        }
+        std::construct_at(slot, ShardMessage{order, instrument});
+        queue.commitWrite();
+    }
+
+    // drains all queues and stops the shard threads
+    void finish() {
+        for(auto& shard : m_shards) {
+            shard->m_running = false;
+        }
+        for(auto& shard : m_shards) {
+            if(shard->mp_thread) {
+                shard->mp_thread->join();
+                delete shard->mp_thread;
+                shard->mp_thread = nullptr;
+            }
+        }
+    }
+
+    // call after finish()
+    void dumpStats(std::ostream& os) const {
+        OrderLatencyStats latency;
+        for(std::size_t i = 0; i < m_shards.size(); ++i) {
+            os << "Shard " << i << " orders: " << m_shards[i]->m_orders << " match time(ns): " << m_shards[i]->m_latency.all().sum() << '\n';
+            latency.merge(m_shards[i]->m_latency);
+        }
+        latency.print(os);
+    }
+
+    [[nodiscard]] std::size_t shardCount() const noexcept { return m_shards.size(); }
+
+    ShardedEngine(const ShardedEngine&) = delete;
+    ShardedEngine& operator=(const ShardedEngine&) = delete;
+
+private:
+    struct Shard {
+        Shard(int outputFd, std::mutex* writeMutex, const TraderRegistry* traderNames) :
+            m_queue(SHARD_QUEUE_SIZE),
+            m_pools(InstrumentRouter::MAX_INSTRUMENTS),
+            m_reporter(outputFd, writeMutex, traderNames)
+        {}
+        Common::SPSCRing<ShardMessage>      m_queue;
+        std::atomic<bool>                   m_running = {true};
+        std::vector<std::unique_ptr<Pool>>  m_pools;//by instrument id, created on the first order of an instrument
+        TradeReporter                       m_reporter;
+        std::thread*                        mp_thread = nullptr;
+        std::uint64_t                       m_orders = 0;
+        OrderLatencyStats                   m_latency;
+    };
+
+    void runShard(Shard& shard) {
+        using clock = std::chrono::high_resolution_clock;
+        unsigned spins = 0;
+        while(true) {
+            const ShardMessage* msg = shard.m_queue.nextToRead();
+            if(!msg) {
+                if(!shard.m_running && shard.m_queue.empty()) {
+                    break;
+                }
+                Common::spinWait(spins);
+                continue;
+            }
+            BookOrder order = msg->m_order;
+            const std::uint16_t instrument = msg->m_instrument;
+            shard.m_queue.commitRead();
+
+            auto& pool = shard.m_pools[instrument];
+            if(UNLIKELY(!pool)) {
+                pool = std::make_unique<Pool>(m_nodeCapacity);
+            }
+            auto start = clock::now();
+            pool->tryExecute(order);
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+            shard.m_latency.record(static_cast<std::uint64_t>(elapsed), pool->outcome(), pool->levelsSwept());
+            ++shard.m_orders;
+            shard.m_reporter.report(pool->fills(), m_router.name(instrument));
+        }
+        shard.m_reporter.flush();
+    }
+
+    const InstrumentRouter&                 m_router;
+    std::size_t                             m_nodeCapacity;
+    std::mutex                              m_writeMutex;
+    std::vector<std::unique_ptr<Shard>>     m_shards;
+};
+
+// Text front end of ShardedEngine: every request line starts with an instrument symbol,
+// <Symbol> <Trader Identifier> <Side> ..., the rest of the line follows LineParser grammar.
+template<class MapContBuy, class MapContSell>
+class ShardedExtractor {
+public:
+    ShardedExtractor(bool dbgMode, std::size_t shardCount, int firstCore, std::size_t nodeCapacity) :
+        m_engine{shardCount, firstCore, m_router, STDOUT_FILENO, nodeCapacity, &m_traders}
+    {
+        m_lineParser.setDbgMode(dbgMode);
+        m_lineParser.setPriceBand(&OrderPool<MapContBuy, MapContSell>::isInBand);
+    }
+
+    void process(Common::InputReader& input) {
+        using clock = std::chrono::high_resolution_clock;
+        auto newlines = std::make_unique<std::uint32_t[]>(Common::LINE_SCAN_CHUNK_SIZE);
+        std::uint64_t submitted = 0;
+        std::string_view block;
+        auto start = clock::now();
+        while(input.nextBlock(block)) {
+            Common::forEachLine(block, newlines.get(),
+                [&](const char* lineBegin, const char* lineEnd) { submitted += routeLine(lineBegin, lineEnd); },
+                []() {});
+        }
+        m_engine.finish();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+        std::cout << "Sharded run: " << submitted << " orders of " << m_router.size() << " instruments on " << m_engine.shardCount()
+                  << " shards in " << elapsed.count() << " ns("
+                  << (elapsed.count() ? static_cast<double>(submitted) * 1e9 / static_cast<double>(elapsed.count()) : 0.0) << " orders/s)" << std::endl;
+        m_engine.dumpStats(std::cout);
+    }
+
+private:
+    bool routeLine(const char* begin, const char* end) {
+        while(begin != end && (*begin == ' ' || *begin == '\t')) {
+            ++begin;
+        }
+        const char* symbolBegin = begin;
+        while(begin != end && *begin != ' ' && *begin != '\t') {
+            ++begin;
+        }
+        const std::uint16_t instrument = m_router.intern(std::string_view(symbolBegin, static_cast<std::size_t>(begin - symbolBegin)));
+        const BookOrder order = m_lineParser.process(begin, end);
+        if(UNLIKELY(instrument == InstrumentRouter::INVALID_INSTRUMENT)) {
+            std::cerr << "Invalid instrument symbol: " << std::string_view(symbolBegin, static_cast<std::size_t>(begin - symbolBegin)) << '\n';
+            return false;
+        }
+        if(!order.isValid()) {
+            return false;
+        }
+        m_engine.submit(instrument, order);
+        return true;
+    }
+
+    TraderRegistry                              m_traders;
+    LineParser                                  m_lineParser{&m_traders};
+    InstrumentRouter                            m_router;
+    ShardedEngine<MapContBuy, MapContSell>      m_engine;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+// Compile-time description of the side of an incoming order. OrderPool instantiates its matching path once per policy,
+// so the opposite book and the price comparison are fixed at compile time and the match loop inlines completely.
+struct BuySide {
+    static constexpr char SIDE = 'B';
+    static constexpr char OPPOSITE = 'S';
+    // a buy trades against asks priced at or below its limit
+    static constexpr bool crosses(unsigned restingPrice, unsigned limitPrice) noexcept { return restingPrice <= limitPrice; }
+};
+
+struct SellSide {
+    static constexpr char SIDE = 'S';
+    static constexpr char OPPOSITE = 'B';
+    // a sell trades against bids priced at or above its limit
+    static constexpr bool crosses(unsigned restingPrice, unsigned limitPrice) noexcept { return restingPrice >= limitPrice; }
+};
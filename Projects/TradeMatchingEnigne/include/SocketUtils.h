@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <unordered_set>
@@ -16,9 +18,9 @@
 #include <sys/socket.h>
 #include <fcntl.h>
 
-#include "macros.h"
-
-#include "logging.h"
+#include "Logger.h"
+#include "Macros.h"
+#include "TimeUtils.h"
 
 namespace Common {
   struct SocketCfg {
@@ -86,7 +88,7 @@ namespace Common {
 
   /// Add / Join membership / subscription to the multicast stream specified and on the interface specified.
   inline auto join(int fd, const std::string &ip) -> bool {
-    const m_ipmreq mreq{{inet_addr(ip.c_str())}, {htonl(INADDR_ANY)}};
+    const ip_mreq mreq{{inet_addr(ip.c_str())}, {htonl(INADDR_ANY)}};
     return (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != -1);
   }
 
@@ -94,7 +96,7 @@ namespace Common {
   [[nodiscard]] inline auto createSocket(Logger &logger, const SocketCfg& socket_cfg) -> int {
     std::string time_str;
 
-    const auto ip = socket_cfg.m_ip.empty() ? getIfaceIP(socket_cfg.m_iface) : socket_cfg.ip_;
+    const auto ip = socket_cfg.m_ip.empty() ? getIfaceIP(socket_cfg.m_iface) : socket_cfg.m_ip;
     logger.log("%:% %() % cfg:%\n", __FILE__, __LINE__, __FUNCTION__,
                Common::getCurrentTimeStr(&time_str), socket_cfg.toString());
 
@@ -118,7 +120,8 @@ namespace Common {
       }
 
       if (!socket_cfg.m_isListening) { // establish connection to specified address.
-        ASSERT(connect(socket_fd, rp->ai_addr, rp->ai_addrlen) != 1, "connect() failed. errno:" + std::string(strerror(errno)));
+        // the socket is non-blocking already, so the connection completes later unless it fails right away.
+        ASSERT(connect(socket_fd, rp->ai_addr, rp->ai_addrlen) != -1 || errno == EINPROGRESS, "connect() failed. errno:" + std::string(strerror(errno)));
       }
 
       if (socket_cfg.m_isListening) { // allow re-using the address in the call to bind()
@@ -139,6 +142,7 @@ namespace Common {
         ASSERT(setSOTimestamp(socket_fd), "setSOTimestamp() failed. errno:" + std::string(strerror(errno)));
       }
     }
+    freeaddrinfo(result);
 
     return socket_fd;
   }
@@ -2,12 +2,27 @@
 
 #include <iostream>
 #include <atomic>
+#include <future>
+#include <string>
 #include <thread>
+#include <utility>
 #include <unistd.h>
 
 #include <sys/syscall.h>
 
 namespace Common {
+  /// One step of a busy-wait loop: relax the core for a while, then yield in case the peer thread shares the same CPU.
+  inline auto spinWait(unsigned &spins) noexcept {
+    if (++spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    } else {
+      spins = 0;
+      std::this_thread::yield();
+    }
+  }
+
   /// Set affinity for current thread to be pinned to the provided core_id.
   inline auto setThreadCore(int core_id) noexcept {
     cpu_set_t cpuset;
@@ -20,20 +35,23 @@ namespace Common {
 
   /// Creates a thread instance, sets affinity on it, assigns it a name and
   /// passes the function to be run on that thread as well as the arguments to the function.
+  /// The function and arguments are moved into the thread; returns as soon as the thread runs on its core.
   template<typename T, typename... A>
   inline auto createAndStartThread(int core_id, const std::string &name, T &&func, A &&... args) noexcept {
-    auto t = new std::thread([&]() {
+    std::promise<void> started;
+    std::future<void> isStarted = started.get_future();
+    auto t = new std::thread([started = std::move(started), core_id, name, func = std::forward<T>(func), ...args = std::forward<A>(args)]() mutable {
       if (core_id >= 0 && !setThreadCore(core_id)) {
         std::cerr << "Failed to set core affinity for " << name << " " << pthread_self() << " to " << core_id << std::endl;
         exit(EXIT_FAILURE);
       }
       std::cerr << "Set core affinity for " << name << " " << pthread_self() << " to " << core_id << std::endl;
+      started.set_value();
 
-      std::forward<T>(func)((std::forward<A>(args))...);
+      std::move(func)(std::move(args)...);
     });
 
-    using namespace std::literals::chrono_literals;
-    std::this_thread::sleep_for(1s);
+    isStarted.wait();
 
     return t;
   }
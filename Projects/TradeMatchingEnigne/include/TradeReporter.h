@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+#include "Fill.h"
+#include "Macros.h"
+#include "TraderRegistry.h"
+
+// Formats trades as described in README: one line per aggressor execution, fills of the same trader, side and price
+// merged into one trade and the line sorted by trader, sign and price. Numeric traders come first by number,
+// traders interned from alphanumeric identifiers follow by name.
+// Lines are rendered into a large reusable buffer which is written to the file descriptor in big chunks,
+// so the report costs no allocation and no syscall per fill.
+class TradeReporter {
+public:
+    static constexpr std::size_t OUTPUT_BUFFER_SIZE = 1 << 20;
+    static constexpr std::size_t SCRATCH_RESERVE = 256;
+
+    // Reporters sharing one fd pass a common mutex; they then flush whole lines only, so lines never interleave.
+    // traderNames resolves interned trader ids, it may be interning new names on another thread meanwhile.
+    explicit TradeReporter(int fd = STDOUT_FILENO, std::mutex* writeMutex = nullptr, const TraderRegistry* traderNames = nullptr) :
+        m_fd{fd},
+        mp_writeMutex{writeMutex},
+        mp_traderNames{traderNames},
+        mp_buffer{std::make_unique<char[]>(OUTPUT_BUFFER_SIZE)}
+    {
+        m_scratch.reserve(SCRATCH_RESERVE);
+    }
+
+    ~TradeReporter() { flush(); }
+
+    // prefix(e.g. instrument symbol) starts the line when it isn't empty
+    void report(std::span<const Fill> fills, std::string_view prefix = {}) {
+        if(fills.empty()) {
+            return;
+        }
+        if(UNLIKELY(OUTPUT_BUFFER_SIZE - m_size < LINE_FLUSH_THRESHOLD)) {
+            flush();
+        }
+        if(!prefix.empty()) {
+            std::memcpy(mp_buffer.get() + m_size, prefix.data(), prefix.size());
+            m_size += prefix.size();
+            mp_buffer[m_size++] = ' ';
+        }
+        m_scratch.assign(fills.begin(), fills.end());
+        std::sort(m_scratch.begin(), m_scratch.end(), [this](const Fill& lhs, const Fill& rhs) {
+            if(lhs.m_traderId != rhs.m_traderId) {
+                if(UNLIKELY(mp_traderNames && TraderRegistry::isInterned(lhs.m_traderId & rhs.m_traderId))) {
+                    return mp_traderNames->name(lhs.m_traderId) < mp_traderNames->name(rhs.m_traderId);
+                }
+                return lhs.m_traderId < rhs.m_traderId;
+            }
+            if(lhs.m_side != rhs.m_side) {
+                return lhs.m_side == 'B';//'+' sorts before '-'
+            }
+            return lhs.m_price < rhs.m_price;
+        });
+        bool isFirst = true;
+        for(auto it = m_scratch.begin(); it != m_scratch.end();) {
+            unsigned quantity = 0;
+            auto next = it;
+            for(; next != m_scratch.end() && next->m_traderId == it->m_traderId && next->m_side == it->m_side && next->m_price == it->m_price; ++next) {
+                quantity += next->m_quantity;
+            }
+            if(UNLIKELY(OUTPUT_BUFFER_SIZE - m_size < MAX_TRADE_LENGTH)) {
+                flush();
+            }
+            if(!isFirst) {
+                mp_buffer[m_size++] = ' ';
+            }
+            isFirst = false;
+            appendTrader(it->m_traderId);
+            mp_buffer[m_size++] = (it->m_side == 'B') ? '+' : '-';
+            appendNumber(quantity);
+            mp_buffer[m_size++] = '@';
+            appendNumber(it->m_price);
+            it = next;
+        }
+        mp_buffer[m_size++] = '\n';
+    }
+
+    // called before buffered lines are written out, e.g. to hold trades back until their requests are durable
+    void setOutputBarrier(std::function<void()> barrier) { m_outputBarrier = std::move(barrier); }
+
+    void flush() {
+        if(m_outputBarrier && m_size) {
+            m_outputBarrier();
+        }
+        std::unique_lock<std::mutex> lock;
+        if(mp_writeMutex) {
+            lock = std::unique_lock<std::mutex>(*mp_writeMutex);
+        }
+        std::size_t written = 0;
+        while(written < m_size) {
+            const ssize_t rc = ::write(m_fd, mp_buffer.get() + written, m_size - written);
+            if(rc < 0) {
+                ASSERT(errno == EINTR, "TradeReporter: write() failed. errno:" + std::string(strerror(errno)));
+                continue;
+            }
+            written += static_cast<std::size_t>(rc);
+        }
+        m_size = 0;
+    }
+
+    TradeReporter(const TradeReporter&) = delete;
+    TradeReporter& operator=(const TradeReporter&) = delete;
+
+private:
+    // "<name><sign><quantity>@<price> " with the longest trader name and two 10-digit numbers, plus the line terminator
+    static constexpr std::size_t MAX_TRADE_LENGTH = TraderRegistry::MAX_NAME_LENGTH + 24;
+    // lines start with at least this much free space, so only a line longer than it can be split by a flush
+    static constexpr std::size_t LINE_FLUSH_THRESHOLD = 64 * 1024;
+
+    void appendTrader(unsigned traderId) noexcept {
+        if(UNLIKELY(mp_traderNames && TraderRegistry::isInterned(traderId))) {
+            const std::string_view name = mp_traderNames->name(traderId);
+            if(!name.empty()) {//an id of a binary stream whose name was never loaded is reported by number
+                std::memcpy(mp_buffer.get() + m_size, name.data(), name.size());
+                m_size += name.size();
+                return;
+            }
+        }
+        mp_buffer[m_size++] = 'T';
+        appendNumber(traderId);
+    }
+
+    void appendNumber(unsigned value) noexcept {
+        static constexpr char DIGIT_PAIRS[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        char tmp[10];
+        char* pos = tmp + sizeof(tmp);
+        while(value >= 100) {
+            const unsigned pair = (value % 100) * 2;
+            value /= 100;
+            *--pos = DIGIT_PAIRS[pair + 1];
+            *--pos = DIGIT_PAIRS[pair];
+        }
+        if(value >= 10) {
+            *--pos = DIGIT_PAIRS[value * 2 + 1];
+            *--pos = DIGIT_PAIRS[value * 2];
+        } else {
+            *--pos = static_cast<char>('0' + value);
+        }
+        const std::size_t length = static_cast<std::size_t>(tmp + sizeof(tmp) - pos);
+        std::memcpy(mp_buffer.get() + m_size, pos, length);
+        m_size += length;
+    }
+
+    int                         m_fd;
+    std::mutex*                 mp_writeMutex;
+    const TraderRegistry*       mp_traderNames;
+    std::unique_ptr<char[]>     mp_buffer;
+    std::size_t                 m_size = 0;
+    std::vector<Fill>           m_scratch;
+    std::function<void()>       m_outputBarrier;
+};
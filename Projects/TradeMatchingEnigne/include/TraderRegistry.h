@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Macros.h"
+
+// Interns alphanumeric trader identifiers into dense 32-bit ids with INTERNED_BIT set, the ids BookOrder and Fill carry.
+// Identifiers are hashed straight from the input bytes into an open-addressing(linear probing) table, names are copied
+// once into a flat arena. Arena and name entries are fixed at construction and never move, so reporters on other threads
+// can read the name of any id they received while the parser keeps interning. Only the table, which the parser alone
+// touches, doubles once half full: after warm-up interning a known identifier allocates nothing.
+// The name table(names in id order) is saved into snapshots and journals by appendNames() and loaded back by restoreNames(),
+// so a restored or replayed run reports and interns every trader under the id it had.
+class TraderRegistry {
+public:
+    static constexpr unsigned    INTERNED_BIT = 1u << 31;//numeric ids stay below it
+    static constexpr std::size_t MAX_NAME_LENGTH = 32;
+    static constexpr std::size_t DEFAULT_MAX_TRADERS = 1 << 21;
+    static constexpr std::size_t AVERAGE_NAME_LENGTH = 16;//of the arena sizing, longer names just fill it sooner
+    static constexpr std::size_t INITIAL_SLOTS = 1 << 12;
+
+    explicit TraderRegistry(std::size_t maxTraders = DEFAULT_MAX_TRADERS) :
+        m_maxTraders{maxTraders},
+        m_arenaSize{maxTraders * AVERAGE_NAME_LENGTH},
+        mp_entries{std::make_unique_for_overwrite<Entry[]>(maxTraders)},//pages are only touched by the traders that show up
+        mp_arena{std::make_unique_for_overwrite<char[]>(m_arenaSize)},
+        m_slots(INITIAL_SLOTS),
+        m_mask{INITIAL_SLOTS - 1}
+    {}
+
+    // the id of a name, a new one for a name seen first, 0 for empty or too long names and when the registry is full
+    [[nodiscard]] unsigned intern(std::string_view name) {
+        if(name.empty() || name.size() > MAX_NAME_LENGTH) {
+            return 0;
+        }
+        const std::uint64_t h = hash(name);
+        const std::uint32_t tag = static_cast<std::uint32_t>(h >> 32);
+        std::size_t pos = static_cast<std::size_t>(h) & m_mask;
+        for(;; pos = (pos + 1) & m_mask) {
+            const Slot& slot = m_slots[pos];
+            if(slot.m_id == 0) {
+                break;
+            }
+            if(slot.m_tag == tag && slot.m_length == name.size() && std::memcmp(mp_arena.get() + slot.m_offset, name.data(), name.size()) == 0) {
+                return slot.m_id;
+            }
+        }
+        const std::size_t count = m_count.load(std::memory_order_relaxed);
+        if(count == m_maxTraders || m_arenaUsed + name.size() > m_arenaSize) {
+            return 0;
+        }
+        std::memcpy(mp_arena.get() + m_arenaUsed, name.data(), name.size());
+        const Entry entry{static_cast<std::uint32_t>(m_arenaUsed), static_cast<std::uint32_t>(name.size())};
+        mp_entries[count] = entry;
+        m_arenaUsed += name.size();
+        const unsigned id = INTERNED_BIT | static_cast<unsigned>(count);
+        m_count.store(count + 1, std::memory_order_release);//publishes the entry to name() on other threads
+        m_slots[pos] = Slot{tag, id, entry.m_offset, entry.m_length};
+        if(UNLIKELY((count + 1) * 2 > m_slots.size())) {
+            rehash(m_slots.size() * 2);
+        }
+        return id;
+    }
+
+    [[nodiscard]] static bool isInterned(unsigned id) noexcept { return id & INTERNED_BIT; }
+
+    // name of an interned id, empty for an id this registry never handed out(e.g. one read from a binary stream)
+    [[nodiscard]] std::string_view name(unsigned id) const noexcept {
+        const std::size_t index = id & ~INTERNED_BIT;
+        if(UNLIKELY(index >= m_count.load(std::memory_order_acquire))) {
+            return {};
+        }
+        const Entry& entry = mp_entries[index];
+        return std::string_view(mp_arena.get() + entry.m_offset, entry.m_length);
+    }
+
+    // whether an id may be reported: numeric ids always, interned ones once their name is known
+    [[nodiscard]] bool isKnown(unsigned id) const noexcept {
+        return !isInterned(id) || (id & ~INTERNED_BIT) < m_count.load(std::memory_order_acquire);
+    }
+
+    // appends the names of ids [first, last) to out, each as a length byte followed by the name
+    void appendNames(std::size_t first, std::size_t last, std::string& out) const {
+        for(std::size_t index = first; index < last; ++index) {
+            const std::string_view traderName = name(INTERNED_BIT | static_cast<unsigned>(index));
+            out.push_back(static_cast<char>(traderName.size()));
+            out.append(traderName);
+        }
+    }
+
+    // Loads a name table written by appendNames() from id 0 on. Names this registry already holds must match, the others
+    // are interned under the ids they had, so restoring into an empty registry or one holding a prefix of the table both
+    // work. False if the table is malformed or conflicts with the registry.
+    [[nodiscard]] bool restoreNames(std::string_view table) {
+        std::size_t count = 0;
+        while(!table.empty()) {
+            const std::size_t length = static_cast<unsigned char>(table.front());
+            if(length == 0 || length > MAX_NAME_LENGTH || length >= table.size()) {
+                return false;
+            }
+            const std::string_view traderName = table.substr(1, length);
+            table.remove_prefix(length + 1);
+            const unsigned id = INTERNED_BIT | static_cast<unsigned>(count++);
+            if(intern(traderName) != id) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_count.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::size_t arenaBytes() const noexcept { return m_arenaUsed; }
+    [[nodiscard]] std::size_t slotCount() const noexcept { return m_slots.size(); }
+
+    TraderRegistry(const TraderRegistry&) = delete;
+    TraderRegistry& operator=(const TraderRegistry&) = delete;
+
+private:
+    struct Entry {
+        std::uint32_t   m_offset;
+        std::uint32_t   m_length;
+    };
+
+    // the name's place in the arena is repeated here, so a lookup touches the slot and the name only
+    struct Slot {
+        std::uint32_t   m_tag = 0;//high half of the name's hash, compared before the name
+        unsigned        m_id = 0;//0 marks an empty slot
+        std::uint32_t   m_offset = 0;
+        std::uint32_t   m_length = 0;
+    };
+
+    static std::uint64_t hash(std::string_view name) noexcept {//FNV-1a
+        std::uint64_t h = 0xcbf29ce484222325ull;
+        for(const char c : name) {
+            h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    void rehash(std::size_t slotCount) {
+        std::vector<Slot> slots(slotCount);
+        const std::size_t mask = slotCount - 1;
+        const std::size_t count = m_count.load(std::memory_order_relaxed);
+        for(std::size_t i = 0; i < count; ++i) {
+            const unsigned id = INTERNED_BIT | static_cast<unsigned>(i);
+            const std::uint64_t h = hash(name(id));
+            std::size_t pos = static_cast<std::size_t>(h) & mask;
+            while(slots[pos].m_id != 0) {
+                pos = (pos + 1) & mask;
+            }
+            slots[pos] = Slot{static_cast<std::uint32_t>(h >> 32), id, mp_entries[i].m_offset, mp_entries[i].m_length};
+        }
+        m_slots.swap(slots);
+        m_mask = mask;
+    }
+
+    std::size_t                 m_maxTraders;
+    std::size_t                 m_arenaSize;
+    std::unique_ptr<Entry[]>    mp_entries;//by id without INTERNED_BIT
+    std::unique_ptr<char[]>     mp_arena;
+    std::size_t                 m_arenaUsed = 0;
+    std::atomic<std::size_t>    m_count = {0};//written by the interning thread only
+    std::vector<Slot>           m_slots;
+    std::size_t                 m_mask;
+};
@@ -0,0 +1,334 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "BinaryOrderStream.h"
+#include "Macros.h"
+
+// Shape of a generated order flow. Every field is drawn from its own distribution, so fields are independent.
+struct WorkloadProfile {
+    unsigned        m_initialMid = 2048;
+    unsigned        m_minPrice = 1;
+    unsigned        m_maxPrice = 4096;//default PriceLadder band
+    double          m_midDriftProbability = 0.02;//per request, the mid moves one tick up or down
+    double          m_passiveDepthMean = 6.0;//passive prices sit a geometric number of ticks behind the mid
+    double          m_marketableRatio = 0.3;//new orders priced through the mid
+    unsigned        m_sweepTicks = 4;//marketable orders reach up to this many ticks through the mid
+    unsigned        m_minQuantity = 1;
+    unsigned        m_maxQuantity = 100;
+    unsigned        m_traderCount = 1000;
+    double          m_zipfExponent = 1.1;//a few traders send most of the flow
+    double          m_cancelRatio = 0.15;
+    double          m_modifyRatio = 0.05;
+    double          m_burstProbability = 0.002;//per request, starts a burst of aggressive flow
+    unsigned        m_burstLength = 200;
+    double          m_burstMarketableRatio = 0.8;
+    std::uint64_t   m_meanGapNs = 1000;//mean arrival gap, bursts arrive 100 times faster
+    unsigned        m_symbolCount = 0;//text lines get one of "SYM0".."SYM<n-1>" prefixed when non-zero
+
+    // "balanced", "passive", "aggressive" or "bursty", false for unknown names
+    static bool byName(std::string_view name, WorkloadProfile& profile) {
+        profile = WorkloadProfile{};
+        if(name == "balanced") {
+            return true;
+        } else if(name == "passive") {
+            profile.m_marketableRatio = 0.05;
+            profile.m_cancelRatio = 0.3;
+            profile.m_passiveDepthMean = 20.0;
+            return true;
+        } else if(name == "aggressive") {
+            profile.m_marketableRatio = 0.6;
+            profile.m_sweepTicks = 10;
+            profile.m_maxQuantity = 500;
+            return true;
+        } else if(name == "bursty") {
+            profile.m_burstProbability = 0.01;
+            profile.m_burstLength = 1000;
+            return true;
+        }
+        return false;
+    }
+};
+
+// Trader ids 1..n with P(k) proportional to 1/k^s, sampled by a binary search over the precomputed CDF.
+class ZipfSampler {
+public:
+    ZipfSampler(unsigned count, double exponent) : m_cdf(std::max(count, 1u)) {
+        double sum = 0;
+        for(std::size_t k = 0; k < m_cdf.size(); ++k) {
+            sum += 1.0 / std::pow(static_cast<double>(k + 1), exponent);
+            m_cdf[k] = sum;
+        }
+        for(double& value : m_cdf) {
+            value /= sum;
+        }
+    }
+
+    template<class Rng>
+    unsigned operator()(Rng& rng) const {
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return static_cast<unsigned>(std::lower_bound(m_cdf.begin(), m_cdf.end() - 1, u) - m_cdf.begin()) + 1;
+    }
+
+private:
+    std::vector<double> m_cdf;
+};
+
+// Deterministic stream of requests for one block of the output. Memory is constant: the only history kept
+// is a small ring of recent new orders which cancels and amendments pick their targets from.
+class WorkloadGenerator {
+public:
+    static constexpr std::size_t RECENT_ORDERS = 1024;
+
+    WorkloadGenerator(const WorkloadProfile& profile, const ZipfSampler& traders, std::uint64_t seed, std::uint64_t firstOrderId, std::uint64_t startTime) :
+        m_profile{profile},
+        m_traders{traders},
+        m_rng{seed},
+        m_nextOrderId{firstOrderId},
+        m_time{startTime},
+        m_mid{std::clamp(profile.m_initialMid, profile.m_minPrice + 1, profile.m_maxPrice - 1)}
+    {}
+
+    BinaryOrderRecord next() {
+        const std::uint64_t orderId = m_nextOrderId++;
+        const bool isBurst = m_burstLeft > 0;
+        if(isBurst) {
+            --m_burstLeft;
+        } else if(chance(m_profile.m_burstProbability)) {
+            m_burstLeft = m_profile.m_burstLength;
+        }
+        const double meanGap = static_cast<double>(m_profile.m_meanGapNs) / (isBurst ? 100.0 : 1.0);
+        m_time += static_cast<std::uint64_t>(std::exponential_distribution<double>(1.0 / std::max(meanGap, 1.0))(m_rng));
+        if(chance(m_profile.m_midDriftProbability)) {
+            m_mid = std::clamp(chance(0.5) ? m_mid + 1 : m_mid - 1, m_profile.m_minPrice + 1, m_profile.m_maxPrice - 1);
+        }
+
+        if(m_recentCount && chance(m_profile.m_cancelRatio + m_profile.m_modifyRatio)) {
+            const Recent& target = m_recent[uniform(0, static_cast<unsigned>(std::min(m_recentCount, RECENT_ORDERS)) - 1)];
+            if(chance(m_profile.m_cancelRatio / (m_profile.m_cancelRatio + m_profile.m_modifyRatio))) {
+                return BinaryOrderRecord{target.m_orderId, m_time, target.m_traderId, 0, 0, 'C', {}};
+            }
+            return BinaryOrderRecord{target.m_orderId, m_time, target.m_traderId, quantity(), passivePrice(target.m_side), 'M', {}};
+        }
+
+        const char side = chance(0.5) ? 'B' : 'S';
+        const bool isMarketable = chance(isBurst ? m_profile.m_burstMarketableRatio : m_profile.m_marketableRatio);
+        const unsigned price = isMarketable ? marketablePrice(side) : passivePrice(side);
+        const unsigned traderId = m_traders(m_rng);
+        m_recent[m_recentCount++ % RECENT_ORDERS] = Recent{orderId, traderId, side};
+        return BinaryOrderRecord{orderId, m_time, traderId, quantity(), price, side, {}};
+    }
+
+    // symbol prefix of the next text line, empty without symbols
+    std::string_view nextSymbol(char (&buffer)[16]) {
+        if(!m_profile.m_symbolCount) {
+            return {};
+        }
+        std::memcpy(buffer, "SYM", 3);
+        const auto result = std::to_chars(buffer + 3, buffer + sizeof(buffer), uniform(0, m_profile.m_symbolCount - 1));
+        return std::string_view(buffer, static_cast<std::size_t>(result.ptr - buffer));
+    }
+
+private:
+    struct Recent {
+        std::uint64_t   m_orderId = 0;
+        unsigned        m_traderId = 0;
+        char            m_side = 'B';
+    };
+
+    bool chance(double p) { return std::bernoulli_distribution(std::clamp(p, 0.0, 1.0))(m_rng); }
+    unsigned uniform(unsigned low, unsigned high) { return std::uniform_int_distribution<unsigned>(low, high)(m_rng); }
+    unsigned quantity() { return uniform(m_profile.m_minQuantity, m_profile.m_maxQuantity); }
+
+    unsigned passivePrice(char side) {
+        const unsigned depth = 1 + std::geometric_distribution<unsigned>(1.0 / std::max(m_profile.m_passiveDepthMean, 1.0))(m_rng);
+        return clampPrice(side == 'B' ? static_cast<std::int64_t>(m_mid) - depth : static_cast<std::int64_t>(m_mid) + depth);
+    }
+
+    unsigned marketablePrice(char side) {
+        const unsigned through = uniform(0, m_profile.m_sweepTicks);
+        return clampPrice(side == 'B' ? static_cast<std::int64_t>(m_mid) + through : static_cast<std::int64_t>(m_mid) - through);
+    }
+
+    unsigned clampPrice(std::int64_t price) const noexcept {
+        return static_cast<unsigned>(std::clamp<std::int64_t>(price, m_profile.m_minPrice, m_profile.m_maxPrice));
+    }
+
+    const WorkloadProfile&              m_profile;
+    const ZipfSampler&                  m_traders;
+    std::mt19937_64                     m_rng;
+    std::uint64_t                       m_nextOrderId;
+    std::uint64_t                       m_time;
+    unsigned                            m_mid;
+    unsigned                            m_burstLeft = 0;
+    std::array<Recent, RECENT_ORDERS>   m_recent{};
+    std::size_t                         m_recentCount = 0;
+};
+
+// Writes count requests as text lines or as a binary order stream.
+// Requests are produced in blocks of GENERATION_BLOCK_SIZE, each from its own generator seeded with a sub-seed derived
+// from the seed and the block index, so the output depends on seed and profile only, never on the number of threads.
+// The mid restarts from the profile's initial mid in every block. Each thread holds one block in memory at a time:
+// binary blocks are pwrite()-n at their fixed offsets, text blocks are appended in block order.
+class WorkloadWriter {
+public:
+    static constexpr std::uint64_t GENERATION_BLOCK_SIZE = 1 << 18;
+
+    WorkloadWriter(const WorkloadProfile& profile, std::uint64_t seed) :
+        m_profile{profile},
+        m_traders{profile.m_traderCount, profile.m_zipfExponent},
+        m_seed{seed}
+    {}
+
+    bool write(const std::string& path, std::uint64_t count, bool isBinary, unsigned threadCount = 1) {
+        if(count > MAX_ORDER_ID) {
+            std::cerr << "Can't generate " << count << " requests: order ids are 32-bit, a run takes at most " << MAX_ORDER_ID << "\n";
+            return false;
+        }
+        m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(m_fd < 0) {
+            std::cerr << "Could not create " << path << " errno:" << strerror(errno) << "\n";
+            return false;
+        }
+        m_count = count;
+        m_isBinary = isBinary;
+        m_nextBlockToWrite = 0;
+        m_nextBlockToGenerate = 0;
+        m_offset = 0;
+        if(isBinary) {
+            const BinaryStreamHeader header = BinaryOrderWriter::makeHeader(count);
+            writeAt(&header, sizeof(header), 0);
+        }
+        std::vector<std::thread> threads;
+        for(unsigned i = 1; i < std::max(threadCount, 1u); ++i) {
+            threads.emplace_back([this]() { run(); });
+        }
+        run();
+        for(std::thread& thread : threads) {
+            thread.join();
+        }
+        ::close(m_fd);
+        m_fd = -1;
+        return true;
+    }
+
+    // splitmix64 finaliser, decorrelates sub-seeds of neighbouring blocks
+    static std::uint64_t subSeed(std::uint64_t seed, std::uint64_t block) noexcept {
+        std::uint64_t z = seed + (block + 1) * 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+private:
+    // "[<symbol> ]<trader> <side> ..." in the text grammar, at most this long
+    static constexpr std::size_t MAX_LINE_LENGTH = 96;
+
+    void run() {
+        std::vector<BinaryOrderRecord> records;
+        std::string text;
+        while(true) {
+            const std::uint64_t block = m_nextBlockToGenerate.fetch_add(1);
+            const std::uint64_t first = block * GENERATION_BLOCK_SIZE;
+            if(first >= m_count) {
+                return;
+            }
+            const std::uint64_t size = std::min(GENERATION_BLOCK_SIZE, m_count - first);
+            WorkloadGenerator generator(m_profile, m_traders, subSeed(m_seed, block), first + 1, first * m_profile.m_meanGapNs);
+            if(m_isBinary) {
+                records.resize(size);
+                for(BinaryOrderRecord& record : records) {
+                    record = generator.next();
+                }
+                writeAt(records.data(), size * sizeof(BinaryOrderRecord), sizeof(BinaryStreamHeader) + first * sizeof(BinaryOrderRecord));
+            } else {
+                text.resize(size * MAX_LINE_LENGTH);
+                char* pos = text.data();
+                for(std::uint64_t i = 0; i < size; ++i) {
+                    pos = formatLine(pos, generator);
+                }
+                appendInOrder(block, text.data(), static_cast<std::size_t>(pos - text.data()));
+            }
+        }
+    }
+
+    static char* formatLine(char* pos, WorkloadGenerator& generator) {
+        char symbol[16];
+        const std::string_view prefix = generator.nextSymbol(symbol);
+        const BinaryOrderRecord record = generator.next();
+        if(!prefix.empty()) {
+            pos = std::copy(prefix.begin(), prefix.end(), pos);
+            *pos++ = ' ';
+        }
+        auto number = [&](std::uint64_t value) { pos = std::to_chars(pos, pos + 20, value).ptr; };
+        number(record.m_traderId);
+        *pos++ = ' ';
+        *pos++ = record.m_side;
+        *pos++ = ' ';
+        if(record.m_side == 'C' || record.m_side == 'M') {
+            number(record.m_orderId);
+            if(record.m_side == 'C') {
+                *pos++ = '\n';
+                return pos;
+            }
+            *pos++ = ' ';
+        }
+        number(record.m_quantity);
+        *pos++ = ' ';
+        number(record.m_price);
+        *pos++ = '\n';
+        return pos;
+    }
+
+    void appendInOrder(std::uint64_t block, const char* data, std::size_t size) {
+        std::unique_lock<std::mutex> lock(m_writeMutex);
+        m_blockWritten.wait(lock, [&]() { return m_nextBlockToWrite == block; });
+        writeAt(data, size, m_offset);
+        m_offset += size;
+        ++m_nextBlockToWrite;
+        m_blockWritten.notify_all();
+    }
+
+    void writeAt(const void* data, std::size_t size, std::uint64_t offset) {
+        const char* pos = static_cast<const char*>(data);
+        while(size) {
+            const ssize_t rc = ::pwrite(m_fd, pos, size, static_cast<off_t>(offset));
+            if(rc < 0) {
+                ASSERT(errno == EINTR, "WorkloadWriter: pwrite() failed. errno:" + std::string(strerror(errno)));
+                continue;
+            }
+            pos += rc;
+            offset += static_cast<std::uint64_t>(rc);
+            size -= static_cast<std::size_t>(rc);
+        }
+    }
+
+    const WorkloadProfile&          m_profile;
+    ZipfSampler                     m_traders;
+    std::uint64_t                   m_seed;
+    int                             m_fd = -1;
+    std::uint64_t                   m_count = 0;
+    bool                            m_isBinary = false;
+    std::atomic<std::uint64_t>      m_nextBlockToGenerate = {0};
+    std::mutex                      m_writeMutex;
+    std::condition_variable         m_blockWritten;
+    std::uint64_t                   m_nextBlockToWrite = 0;//guarded by m_writeMutex
+    std::uint64_t                   m_offset = 0;//end of the text written so far, guarded by m_writeMutex
+};
@@ -1,24 +1,31 @@
-#include <map>
-#include <queue>
-#include <flat_map>
-#include <absl/container/btree_map.h>
+#include <atomic>
+#include <csignal>
+#include <memory>
+#include <string_view>
 
 #include "ExtractUtils.h"
+#include "LevelMaps.h"
+#include "MemoryUtils.h"
+#include "OrderGateway.h"
+#include "PipelinedEngine.h"
+#include "PriceLadder.h"
+#include "ShardedEngine.h"
+#include "WorkloadGenerator.h"
 #include "Logger.h"
 
-//Random orders' generator
-void generateInputFile(const char* fileName, unsigned ordersCount) {
-    std::ofstream ofstr(fileName);
-    srand(time(NULL));
-    for(unsigned i = 0; i < ordersCount; ++i) {
-        unsigned randNumber = rand();
-        unsigned traderId = randNumber % 97 + 4;//up to 100
-        unsigned price = randNumber % 91 + 9;//up to 99
-        unsigned quantity = randNumber % 89 + 16;//up to 104
-        char side = (randNumber % 2) ? 'B' : 'S';
-        
-        ofstr << traderId<<" " << side<<" " << quantity<<" " << price <<'\n';
-    }
+constexpr std::size_t MAX_PRESIZED_ORDER_NODES = 1 << 22;
+constexpr unsigned GENERATED_SYMBOLS = 16;//instruments of generated sharded input
+
+std::atomic<bool> g_isGatewayRunning = {true};//cleared by SIGINT/SIGTERM
+
+extern "C" void stopGateway(int) {
+    g_isGatewayRunning.store(false);
+}
+
+std::atomic<bool> g_isSnapshotRequested = {false};//set by SIGUSR1
+
+extern "C" void requestSnapshot(int) {
+    g_isSnapshotRequested.store(true);
 }
 
 void addCurrentDateTimeIntoLog(Common::Logger* p_logger) {
@@ -28,51 +35,379 @@ void addCurrentDateTimeIntoLog(Common::Logger* p_logger) {
     p_logger->log("%\n", *dateTimeStr);
 }
 
+struct RunOptions {
+    std::string m_inputFile;//"-" reads stdin, defaults to tme_input.txt or tme_input.bin for binary input
+    std::string m_inputMode = "stream";//stream|mmap|binary
+    unsigned m_shards = 0;//0 runs the single-instrument engine, otherwise lines carry a symbol and instruments are sharded
+    int m_firstCore = -1;//shard or pipeline stage i is pinned to m_firstCore + i, negative disables pinning
+    bool m_isPipelined = false;//parse, match and report on three threads
+    std::uint64_t m_latencyInterval = 0;//requests per interim latency report, 0 reports at the end only
+    std::size_t m_batchSize = 1;//requests matched per OrderPool::tryExecuteBatch() call, 1 matches and times them one by one
+    std::uint64_t m_seed = 1;//of the generated input, the same seed and profile give the same input
+    std::string m_profile = "balanced";//WorkloadProfile::byName()
+    unsigned m_generatorThreads = 1;
+    int m_gatewayPort = 0;//non-zero serves TCP order entry on this port instead of reading an input file
+    std::string m_snapshotFile;//non-empty writes snapshots of the book to this file
+    std::uint64_t m_snapshotInterval = 0;//requests between snapshots, 0 writes one at the end of the input and on SIGUSR1 only
+    std::string m_restoreFile;//non-empty loads the book from this snapshot and skips the requests it reflects
+    JournalConfig m_journal;//non-empty m_fileName journals every request before it is executed
+    bool m_isReplay = false;//the input is a journal of an earlier run
+    std::uint64_t m_auctionInterval = 0;//non-zero runs call auctions uncrossed every this many requests instead of continuous matching
+    MarketDataConfig m_marketData;//non-zero m_port publishes the book over UDP multicast
+    Common::ArenaConfig m_arena;//chunks of the level containers' arena
+    bool m_isWarmUp = false;//synthetic matching and prefaulting before the first request
+    WarmUpConfig m_warmUp;//expected book depth and resting orders of the warm-up
+    bool m_isMemoryLocked = false;//mlockall() before the engine is built
+    Common::LogSinkConfig m_logSink;//mode, rotation size and fsync policy of tradeMatchingEngine.log
+};
+
+//optional "--key=value" arguments following the positional ones
+bool parseRunOptions(int argc, char* argv[], RunOptions& options) {
+    for(int i = 5; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const auto eqPos = arg.find('=');
+        if(!arg.starts_with("--") || eqPos == std::string_view::npos) {
+            std::cerr << "Malformed option: " << arg << "\n";
+            return false;
+        }
+        const std::string_view key = arg.substr(2, eqPos - 2);
+        const std::string_view value = arg.substr(eqPos + 1);
+        if(key == "input" && (value == "stream" || value == "mmap" || value == "binary")) {
+            options.m_inputMode = value;
+        } else if(key == "file" && !value.empty()) {
+            options.m_inputFile = value;
+        } else if(key == "shards" && !value.empty()) {
+            options.m_shards = std::atoi(std::string(value).c_str());
+        } else if(key == "seed" && !value.empty()) {
+            options.m_seed = std::strtoull(std::string(value).c_str(), nullptr, 10);
+        } else if(key == "profile" && !value.empty()) {
+            options.m_profile = value;
+        } else if(key == "gen-threads" && !value.empty()) {
+            options.m_generatorThreads = std::atoi(std::string(value).c_str());
+        } else if(key == "latency-interval" && !value.empty()) {
+            options.m_latencyInterval = std::strtoull(std::string(value).c_str(), nullptr, 10);
+        } else if(key == "batch" && std::strtoull(std::string(value).c_str(), nullptr, 10) > 0) {
+            options.m_batchSize = std::strtoull(std::string(value).c_str(), nullptr, 10);
+        } else if(key == "pipeline" && (value == "on" || value == "off")) {
+            options.m_isPipelined = (value == "on");
+        } else if(key == "gateway" && !value.empty()) {
+            options.m_gatewayPort = std::atoi(std::string(value).c_str());
+        } else if(key == "market-data") {
+            if(!parseMarketDataAddress(value, options.m_marketData)) {
+                std::cerr << "Malformed market data address: " << value << ", expected <group>:<port>\n";
+                return false;
+            }
+        } else if(key == "md-snapshot-ms" && std::atoi(std::string(value).c_str()) > 0) {
+            options.m_marketData.m_snapshotIntervalMs = std::atoi(std::string(value).c_str());
+        } else if(key == "snapshot" && !value.empty()) {
+            options.m_snapshotFile = value;
+        } else if(key == "snapshot-interval" && !value.empty()) {
+            options.m_snapshotInterval = std::strtoull(std::string(value).c_str(), nullptr, 10);
+        } else if(key == "restore" && !value.empty()) {
+            options.m_restoreFile = value;
+        } else if(key == "journal" && !value.empty()) {
+            options.m_journal.m_fileName = value;
+        } else if(key == "journal-sync" && (value == "none" || value == "group" || value == "strict")) {
+            journalSyncByName(value, options.m_journal.m_sync);
+        } else if(key == "journal-commit-us" && !value.empty()) {
+            options.m_journal.m_commitDelayUs = std::atoi(std::string(value).c_str());
+        } else if(key == "replay" && !value.empty()) {//a journal is a binary order stream
+            options.m_inputFile = value;
+            options.m_inputMode = "binary";
+            options.m_isReplay = true;
+        } else if(key == "auction-interval" && std::strtoull(std::string(value).c_str(), nullptr, 10) > 0) {
+            options.m_auctionInterval = std::strtoull(std::string(value).c_str(), nullptr, 10);
+        } else if(key == "huge-pages" && (value == "on" || value == "off")) {
+            options.m_arena.m_isHugePages = (value == "on");
+        } else if(key == "warmup" && (value == "on" || value == "off")) {
+            options.m_isWarmUp = (value == "on");
+        } else if(key == "warmup-levels" && std::strtoull(std::string(value).c_str(), nullptr, 10) > 0) {
+            options.m_warmUp.m_levels = std::strtoull(std::string(value).c_str(), nullptr, 10);
+        } else if(key == "warmup-orders" && !value.empty()) {
+            options.m_warmUp.m_orders = std::strtoull(std::string(value).c_str(), nullptr, 10);
+        } else if(key == "mlock" && (value == "on" || value == "off")) {
+            options.m_isMemoryLocked = (value == "on");
+        } else if(key == "first-core" && !value.empty()) {
+            options.m_firstCore = std::atoi(std::string(value).c_str());
+        } else if(key == "log-sink" && (value == "writev" || value == "mmap")) {
+            Common::logSinkModeByName(value, options.m_logSink.m_mode);
+        } else if(key == "log-fsync" && (value == "never" || value == "rotate" || value == "interval" || value == "flush")) {
+            Common::fsyncPolicyByName(value, options.m_logSink.m_fsync);
+        } else if(key == "log-rotate-mb" && !value.empty()) {
+            options.m_logSink.m_rotateBytes = std::strtoull(std::string(value).c_str(), nullptr, 10) * 1024 * 1024;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return false;
+        }
+    }
+    if(options.m_shards && options.m_inputMode == "binary") {
+        std::cerr << "Sharded mode needs text input with instrument symbols\n";
+        return false;
+    }
+    if(options.m_shards && options.m_isPipelined) {
+        std::cerr << "Sharded and pipelined modes can't be combined\n";
+        return false;
+    }
+    if(options.m_gatewayPort && (options.m_shards || options.m_isPipelined)) {
+        std::cerr << "Gateway mode can't be combined with sharded or pipelined modes\n";
+        return false;
+    }
+    if(options.m_marketData.m_port && (options.m_shards || options.m_isPipelined)) {
+        std::cerr << "Market data can't be published in sharded or pipelined modes\n";
+        return false;
+    }
+    if((!options.m_snapshotFile.empty() || !options.m_restoreFile.empty()) && (options.m_shards || options.m_isPipelined || options.m_gatewayPort)) {
+        std::cerr << "Snapshots are supported in the single-instrument file modes only\n";
+        return false;
+    }
+    if((!options.m_journal.m_fileName.empty() || options.m_isReplay) && (options.m_shards || options.m_isPipelined || options.m_gatewayPort)) {
+        std::cerr << "Journaling and replay are supported in the single-instrument file modes only\n";
+        return false;
+    }
+    if(options.m_auctionInterval && (options.m_shards || options.m_isPipelined || options.m_gatewayPort)) {
+        std::cerr << "Call auctions are supported in the single-instrument file modes only\n";
+        return false;
+    }
+    if(options.m_batchSize > 1 && (options.m_shards || options.m_isPipelined || options.m_gatewayPort || options.m_inputMode == "stream")) {
+        std::cerr << "Batched matching is supported in the single-instrument mmap and binary input modes only\n";
+        return false;
+    }
+    if(options.m_isWarmUp && options.m_shards) {
+        std::cerr << "Warm-up isn't supported in sharded mode, its books are created on their first order\n";
+        return false;
+    }
+    options.m_arena.m_isPrefaulted = options.m_isWarmUp;
+    if(options.m_isReplay && options.m_inputMode != "binary") {
+        std::cerr << "A journal is replayed as binary input\n";
+        return false;
+    }
+    if(!options.m_journal.m_fileName.empty() && options.m_journal.m_fileName == options.m_inputFile) {
+        std::cerr << "The journal can't overwrite its input\n";
+        return false;
+    }
+    if(options.m_inputFile.empty()) {
+        options.m_inputFile = (options.m_inputMode == "binary") ? "tme_input.bin" : "tme_input.txt";
+    }
+    return true;
+}
+
+template<class MapContBuy, class MapContSell>
+int runEngine(const RunOptions& options, bool isDbgMode, std::size_t nodePoolCapacity, Common::Nanos launchTime) {
+    if(options.m_gatewayPort) {
+        OrderGateway<MapContBuy, MapContSell> gateway(options.m_gatewayPort, options.m_firstCore, nodePoolCapacity, options.m_arena);
+        if(options.m_isWarmUp) {
+            gateway.warmUp(options.m_warmUp);
+        }
+        if(options.m_marketData.m_port) {
+            gateway.enableMarketData(options.m_marketData);
+        }
+        std::signal(SIGINT, stopGateway);
+        std::signal(SIGTERM, stopGateway);
+        std::cerr << "Gateway listening on port " << options.m_gatewayPort << ", stop it with SIGINT or SIGTERM" << std::endl;
+        gateway.run(g_isGatewayRunning);
+        return 0;
+    }
+    if(options.m_shards) {
+        Common::InputReader reader(options.m_inputFile);
+        if(!reader.good()) {
+            std::cerr << "Could not open input: " << options.m_inputFile << "\n";
+            return 1;
+        }
+        //every instrument gets its own growing pool, presizing each of them for the whole input would waste memory
+        const std::size_t instrumentCapacity = std::min(nodePoolCapacity, OrderPool<MapContBuy, MapContSell>::DEFAULT_NODE_CAPACITY);
+        ShardedExtractor<MapContBuy, MapContSell> extractor(isDbgMode, options.m_shards, options.m_firstCore, instrumentCapacity);
+        extractor.process(reader);
+        return 0;
+    }
+    if(options.m_isPipelined) {
+        PipelinedExtractor<MapContBuy, MapContSell> extractor(isDbgMode, options.m_firstCore, nodePoolCapacity, options.m_arena);
+        if(options.m_isWarmUp) {
+            extractor.warmUp(options.m_warmUp);
+        }
+        if(options.m_inputMode == "binary") {
+            BinaryOrderReader reader(options.m_inputFile, options.m_isWarmUp);
+            if(!reader.good()) {
+                std::cerr << "Could not load binary input: " << reader.error() << "\n";
+                return 1;
+            }
+            if(!extractor.loadTraders(options.m_inputFile)) {
+                return 1;
+            }
+            extractor.process(reader);
+        } else {//text is always split in place
+            Common::InputReader reader(options.m_inputFile, options.m_isWarmUp);
+            if(!reader.good()) {
+                std::cerr << "Could not open input: " << options.m_inputFile << "\n";
+                return 1;
+            }
+            extractor.process(reader);
+        }
+        return 0;
+    }
+    Extractor<MapContBuy, MapContSell> extractor(isDbgMode, nodePoolCapacity, options.m_arena);
+    extractor.setLaunchTime(launchTime);
+    extractor.setLatencyInterval(options.m_latencyInterval);
+    extractor.setBatchSize(options.m_batchSize);
+    if(options.m_isWarmUp) {
+        extractor.warmUp(options.m_warmUp);
+    }
+    if(!options.m_restoreFile.empty() && !extractor.restore(options.m_restoreFile)) {
+        return 1;
+    }
+    if(!options.m_snapshotFile.empty()) {
+        extractor.enableSnapshots(options.m_snapshotFile, options.m_snapshotInterval, &g_isSnapshotRequested);
+        std::signal(SIGUSR1, requestSnapshot);
+    }
+    if(options.m_auctionInterval) {
+        extractor.enableAuction(options.m_auctionInterval);
+    }
+    if(!options.m_journal.m_fileName.empty()) {
+        extractor.enableJournal(options.m_journal);
+    }
+    if(options.m_marketData.m_port) {
+        extractor.enableMarketData(options.m_marketData);
+    }
+    if(options.m_inputMode == "mmap") {
+        Common::InputReader reader(options.m_inputFile, options.m_isWarmUp);
+        if(!reader.good()) {
+            std::cerr << "Could not open input: " << options.m_inputFile << "\n";
+            return 1;
+        }
+        extractor.process(reader);
+    } else if(options.m_inputMode == "binary") {
+        BinaryOrderReader reader(options.m_inputFile, options.m_isWarmUp);
+        if(!reader.good()) {
+            std::cerr << "Could not load binary input: " << reader.error() << "\n";
+            return 1;
+        }
+        if(!extractor.loadTraders(options.m_inputFile, reader, options.m_isReplay)) {
+            return 1;
+        }
+        extractor.process(reader);
+    } else if(options.m_inputFile == "-") {
+        extractor.process(std::cin);
+    } else {
+        std::ifstream ifstr(options.m_inputFile);
+        extractor.process(ifstr);
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 5) {
-        std::cerr << "Usage: " << argv[0] << " <number_of_orders> <std_map|btree_map> <debug mode 0|1> <generate input file 0|1>\n";
+    const Common::Nanos launchTime = Common::getCurrentNanos();
+    RunOptions options;
+    if (argc < 5 || !parseRunOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " <number_of_orders> <std_map|btree_map|std::flat_map|ladder(prices 1..4096 only)> <debug mode 0|1> <generate input file 0|1>"
+                  << " [--input=stream|mmap|binary] [--file=<input file>|-] [--shards=<N>|--pipeline=on|--gateway=<port>] [--first-core=<K>] [--huge-pages=on|off] [--warmup=on|off] [--warmup-levels=<N>] [--warmup-orders=<N>] [--mlock=on|off] [--latency-interval=<requests>] [--batch=<requests>]"
+                  << " [--seed=<N>] [--profile=balanced|passive|aggressive|bursty] [--gen-threads=<N>]"
+                  << " [--market-data=<group>:<port>] [--md-snapshot-ms=<N>] [--snapshot=<file>] [--snapshot-interval=<requests>] [--restore=<file>]"
+                  << " [--journal=<file>] [--journal-sync=none|group|strict] [--journal-commit-us=<N>] [--replay=<journal>] [--auction-interval=<requests>]"
+                  << " [--log-sink=writev|mmap] [--log-rotate-mb=<N>] [--log-fsync=never|rotate|interval|flush]\n";
         return 1;
     }
-    Common::Logger& logger = Common::Logger::getInstance();
+    if(options.m_isMemoryLocked) {//before the logger and the engine allocate, so every later mapping is faulted in and locked too
+        std::string error;
+        if(!Common::lockMemory(error)) {
+            std::cerr << "mlockall() failed, running with unlocked memory: " << error << "\n";
+        }
+    }
+    Common::Logger& logger = Common::Logger::getInstance(options.m_logSink);
     logger.log("Trade Matching Engine program launched at ");
     addCurrentDateTimeIntoLog(&logger);
-    const unsigned numOrders = std::atoi(argv[1]);
+    const std::uint64_t numOrders = std::strtoull(argv[1], nullptr, 10);
+    if(numOrders > MAX_ORDER_ID) {
+        std::cerr << "Too many orders: " << argv[1] << ", order ids are 32-bit and a run takes at most " << MAX_ORDER_ID << " requests\n";
+        return 1;
+    }
     const bool isGenerationNeeded = std::atoi(argv[4]);
+    if(isGenerationNeeded && options.m_isReplay) {
+        std::cerr << "A replayed journal can't be generated\n";
+        return 1;
+    }
     if(isGenerationNeeded) {
         logger.log("Enabling auto generation of orders for % entries.\n", numOrders);
-        generateInputFile("tme_input.txt", numOrders);
+        WorkloadProfile profile;
+        if(!WorkloadProfile::byName(options.m_profile, profile)) {
+            std::cerr << "Unknown workload profile: " << options.m_profile << "\n";
+            return 1;
+        }
+        profile.m_symbolCount = options.m_shards ? GENERATED_SYMBOLS : 0;
+        logger.log("Workload profile: %, seed: %\n", options.m_profile, options.m_seed);
+        WorkloadWriter writer(profile, options.m_seed);
+        if(!writer.write(options.m_inputFile, numOrders, options.m_inputMode == "binary", options.m_generatorThreads)) {
+            return 1;
+        }
     }
-    else {
-        std::ifstream ifstr("tme_input.txt");
+    else if(options.m_inputFile != "-" && !options.m_gatewayPort) {
+        std::ifstream ifstr(options.m_inputFile);
         if (!ifstr.good()) {
-            logger.log("Error: 'tme_input.txt' not found. Nothing to load. Exiting.\n");
+            logger.log("Error: '%' not found. Nothing to load. Exiting.\n", options.m_inputFile);
             return 1;
         } else {
-            logger.log("Found 'tme_input.txt', proceeding...\n");
+            logger.log("Found '%', proceeding...\n", options.m_inputFile);
         }
     }
     std::string containerType = argv[2];
     const bool isDbgMode = std::atoi(argv[3]);
+    const std::size_t nodePoolCapacity = std::min<std::size_t>(numOrders, MAX_PRESIZED_ORDER_NODES);//resting orders never exceed the number of orders
+    logger.log("Input mode: %\n", options.m_inputMode);
+    if(options.m_shards) {
+        logger.log("Sharded mode: % shards, first core %\n", options.m_shards, options.m_firstCore);
+    } else if(options.m_isPipelined) {
+        logger.log("Pipelined mode, first core %\n", options.m_firstCore);
+    } else if(options.m_gatewayPort) {
+        logger.log("Gateway mode on port %, first core %\n", options.m_gatewayPort, options.m_firstCore);
+    }
+    if(!options.m_restoreFile.empty()) {
+        logger.log("Restoring the book from %\n", options.m_restoreFile);
+    }
+    if(options.m_arena.m_isHugePages) {
+        logger.log("Level arena chunks on huge pages\n");
+    }
+    if(options.m_isWarmUp) {
+        logger.log("Warm-up over % levels per side and % orders\n", options.m_warmUp.m_levels, options.m_warmUp.m_orders);
+    }
+    if(options.m_isMemoryLocked) {
+        logger.log("Locking process memory\n");
+    }
+    if(options.m_batchSize > 1) {
+        logger.log("Matching batches of % requests\n", options.m_batchSize);
+    }
+    if(options.m_auctionInterval) {
+        logger.log("Call auctions uncrossed every % requests\n", options.m_auctionInterval);
+    }
+    if(options.m_isReplay) {
+        logger.log("Replaying the journal %\n", options.m_inputFile);
+    }
+    if(!options.m_journal.m_fileName.empty()) {
+        logger.log("Journal to %, commit delay % us\n", options.m_journal.m_fileName, options.m_journal.m_commitDelayUs);
+    }
+    if(!options.m_snapshotFile.empty()) {
+        logger.log("Snapshots to % every % requests\n", options.m_snapshotFile, options.m_snapshotInterval);
+    }
+    if(options.m_marketData.m_port) {
+        logger.log("Market data on %:%, snapshots on port % every % ms\n", options.m_marketData.m_group, options.m_marketData.m_port,
+                   options.m_marketData.m_port + 1, options.m_marketData.m_snapshotIntervalMs);
+    }
 
     if (containerType == "std_map" || containerType.empty()) {
         logger.log("std::map is selected for internal representations of main order pool conatiners.\n");
         logger.log("Debug mode: %\n", isDbgMode);
-        std::ifstream ifstr("tme_input.txt");
-        Extractor< std::map<unsigned, std::queue<BookOrder>, std::greater<unsigned>>, std::map<unsigned, std::queue<BookOrder>> > extractor(isDbgMode);
-        extractor.process(ifstr);
+        return runEngine< PmrStdMap<std::greater<unsigned>>, PmrStdMap<> >(options, isDbgMode, nodePoolCapacity, launchTime);
     } else if (containerType == "btree_map") {
         logger.log("btree_map is selected for internal representations of main order pool containers.\n");
         logger.log("Debug mode: %\n", isDbgMode);
-        std::ifstream ifstr("tme_input.txt");
-        Extractor< absl::btree_map<unsigned, std::queue<BookOrder>, std::greater<unsigned>>, absl::btree_map<unsigned, std::queue<BookOrder>> > extractor(isDbgMode);
-        extractor.process(ifstr);
+        return runEngine< PmrBtreeMap<std::greater<unsigned>>, PmrBtreeMap<> >(options, isDbgMode, nodePoolCapacity, launchTime);
     }
       else if (containerType == "std::flat_map") {
         logger.log("std::flat_map is selected for internal representations of main order pool containers.\n");
         logger.log("Debug mode: %\n", isDbgMode);
-        std::ifstream ifstr("tme_input.txt");
-        Extractor< std::flat_map<unsigned, std::queue<BookOrder>, std::greater<unsigned>>, absl::btree_map<unsigned, std::queue<BookOrder>> > extractor(isDbgMode);
-        extractor.process(ifstr);
+        return runEngine< PmrFlatMap<std::greater<unsigned>>, PmrBtreeMap<> >(options, isDbgMode, nodePoolCapacity, launchTime);
+    }
+      else if (containerType == "ladder") {
+        logger.log("PriceLadder is selected for internal representations of main order pool containers.\n");
+        logger.log("Debug mode: %\n", isDbgMode);
+        return runEngine< PriceLadder<OrderLevel, std::greater<unsigned>>, PriceLadder<OrderLevel> >(options, isDbgMode, nodePoolCapacity, launchTime);
     }
       else {
         std::cerr << "Unknown map type: " << containerType << "\n";
@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <flat_map>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+#include <absl/container/btree_map.h>
+
+#include "BinaryOrderStream.h"
+#include "BookSnapshot.h"
+#include "LevelMaps.h"
+#include "OrderJournal.h"
+#include "OrderPool.h"
+#include "PrefixSum.h"
+#include "PriceLadder.h"
+#include "TradeReporter.h"
+#include "WorkloadGenerator.h"
+
+//Self-checks of the engine, one ctest case per argument:
+//  backends         every OrderPool backend reports the same trades and outcomes for the same seeded workloads
+//  snapshot-replay  a book restored from a snapshot and the journal written after it equals the book that never stopped
+//  prefix-sum       the AVX2 prefix sum of the call auction curves equals the scalar one
+//Usage: tme_tests <backends|snapshot-replay|prefix-sum> [scratch directory]
+
+namespace fs = std::filesystem;
+
+constexpr std::uint64_t SEED = 20240917;
+constexpr std::size_t WORKLOAD_REQUESTS = 200000;
+
+bool check(bool condition, const std::string& what) {
+    if(!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+    }
+    return condition;
+}
+
+std::vector<BinaryOrderRecord> generate(const char* profileName, std::size_t count) {
+    WorkloadProfile profile;
+    WorkloadProfile::byName(profileName, profile);
+    const ZipfSampler traders(profile.m_traderCount, profile.m_zipfExponent);
+    WorkloadGenerator generator(profile, traders, SEED, 1, 0);
+    std::vector<BinaryOrderRecord> records;
+    records.reserve(count);
+    for(std::size_t i = 0; i < count; ++i) {
+        records.push_back(generator.next());
+    }
+    return records;
+}
+
+// trade lines as TradeReporter writes them, rendered into an unlinked temporary file
+class ReportCapture {
+public:
+    ReportCapture() : mp_file{std::tmpfile()}, m_reporter{fileno(mp_file)} {}
+    ~ReportCapture() {
+        m_reporter.flush();//before the file goes, the reporter's own destructor then has nothing left to write
+        std::fclose(mp_file);
+    }
+
+    TradeReporter& reporter() noexcept { return m_reporter; }
+    std::string text() {
+        m_reporter.flush();
+        std::string text(static_cast<std::size_t>(::lseek(fileno(mp_file), 0, SEEK_END)), '\0');
+        const ssize_t rc = ::pread(fileno(mp_file), text.data(), text.size(), 0);
+        text.resize(rc > 0 ? static_cast<std::size_t>(rc) : 0);
+        return text;
+    }
+
+    ReportCapture(const ReportCapture&) = delete;
+    ReportCapture& operator=(const ReportCapture&) = delete;
+
+private:
+    std::FILE*      mp_file;
+    TradeReporter   m_reporter;
+};
+
+// requests [begin, end) through the pool: trades into the capture, outcomes appended one character each
+template<class Pool>
+void execute(Pool& pool, const std::vector<BinaryOrderRecord>& records, std::size_t begin, std::size_t end, ReportCapture& trades,
+             std::string& outcomes) {
+    for(std::size_t i = begin; i < end; ++i) {
+        BookOrder order = records[i].toOrder();
+        pool.tryExecute(order);
+        trades.reporter().report(pool.fills());
+        outcomes += static_cast<char>('0' + static_cast<int>(pool.outcome()));
+    }
+}
+
+// both sides, every order in queue order
+template<class Pool>
+std::vector<BinaryOrderRecord> flatten(const Pool& pool) {
+    std::vector<BinaryOrderRecord> orders;
+    for(const char side : {'B', 'S'}) {
+        pool.forEachOrder(side, [&](const BookOrder& order) { orders.push_back(BinaryOrderRecord::fromOrder(order)); });
+    }
+    return orders;
+}
+
+bool isSameBook(const std::vector<BinaryOrderRecord>& lhs, const std::vector<BinaryOrderRecord>& rhs) {
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](const BinaryOrderRecord& a, const BinaryOrderRecord& b) {
+        return a.m_orderId == b.m_orderId && a.m_traderId == b.m_traderId && a.m_quantity == b.m_quantity && a.m_price == b.m_price && a.m_side == b.m_side;
+    });
+}
+
+struct RunOutput {
+    std::string                     m_trades;
+    std::string                     m_outcomes;
+    std::vector<BinaryOrderRecord>  m_book;
+};
+
+template<class MapContBuy, class MapContSell>
+RunOutput runBackend(const std::vector<BinaryOrderRecord>& records) {
+    OrderPool<MapContBuy, MapContSell> pool(records.size());
+    ReportCapture trades;
+    RunOutput output;
+    execute(pool, records, 0, records.size(), trades, output.m_outcomes);
+    output.m_trades = trades.text();
+    output.m_book = flatten(pool);
+    return output;
+}
+
+struct Backend {
+    const char* m_name;
+    RunOutput (*m_run)(const std::vector<BinaryOrderRecord>&);
+};
+
+const Backend BACKENDS[] = {
+    {"std_map", runBackend<std::map<unsigned, OrderLevel, std::greater<unsigned>>, std::map<unsigned, OrderLevel>>},
+    {"btree_map", runBackend<absl::btree_map<unsigned, OrderLevel, std::greater<unsigned>>, absl::btree_map<unsigned, OrderLevel>>},
+    {"std::flat_map", runBackend<std::flat_map<unsigned, OrderLevel, std::greater<unsigned>>, std::flat_map<unsigned, OrderLevel>>},
+    {"pmr_std_map", runBackend<PmrStdMap<std::greater<unsigned>>, PmrStdMap<>>},
+    {"pmr_btree_map", runBackend<PmrBtreeMap<std::greater<unsigned>>, PmrBtreeMap<>>},
+    {"pmr_std::flat_map", runBackend<PmrFlatMap<std::greater<unsigned>>, PmrFlatMap<>>},
+    {"ladder", runBackend<PriceLadder<OrderLevel, std::greater<unsigned>>, PriceLadder<OrderLevel>>},
+};
+
+bool testBackends() {
+    bool isPassed = true;
+    for(const char* profileName : {"balanced", "passive", "aggressive", "bursty"}) {
+        const std::vector<BinaryOrderRecord> records = generate(profileName, WORKLOAD_REQUESTS);
+        const RunOutput reference = BACKENDS[0].m_run(records);
+        isPassed &= check(!reference.m_trades.empty(), std::string(profileName) + ": the workload traded nothing");
+        for(const Backend& backend : BACKENDS) {
+            const RunOutput output = backend.m_run(records);
+            const std::string what = std::string(profileName) + ", " + backend.m_name + " against " + BACKENDS[0].m_name + ": ";
+            isPassed &= check(output.m_trades == reference.m_trades, what + "trades differ");
+            isPassed &= check(output.m_outcomes == reference.m_outcomes, what + "outcomes differ");
+            isPassed &= check(isSameBook(output.m_book, reference.m_book), what + "books differ");
+        }
+        std::cout << profileName << ": " << std::size(BACKENDS) << " backends, " << records.size() << " requests, "
+                  << std::count(reference.m_trades.begin(), reference.m_trades.end(), '\n') << " trade lines" << std::endl;
+    }
+    return isPassed;
+}
+
+// The live book is captured in a snapshot after the first half of the requests and journals the second half as it
+// executes it. A book restored from the snapshot and replaying the journal must end equal to the live one and report
+// the same trades for the second half.
+template<class Pool>
+bool checkSnapshotReplay(const char* backend, const fs::path& directory) {
+    const std::vector<BinaryOrderRecord> records = generate("balanced", WORKLOAD_REQUESTS);
+    const std::size_t half = records.size() / 2;
+    const std::string snapshotPath = (directory / "tme_tests.snap").string();
+    const std::string journalPath = (directory / "tme_tests.journal").string();
+    std::string outcomes;
+
+    Pool live(records.size());
+    ReportCapture firstHalf;
+    execute(live, records, 0, half, firstHalf, outcomes);
+    {
+        BookSnapshotWriter writer(snapshotPath);
+        if(!check(writer.capture(live, half), std::string(backend) + ": snapshot capture refused")) {
+            return false;
+        }
+        writer.wait();
+    }
+    ReportCapture liveSecondHalf;
+    {
+        OrderJournal journal(JournalConfig{journalPath, JournalSync::NONE}, half);
+        for(std::size_t i = half; i < records.size(); ++i) {
+            BookOrder order = records[i].toOrder();
+            journal.append(order);
+            live.tryExecute(order);
+            liveSecondHalf.reporter().report(live.fills());
+        }
+    }
+
+    Pool restored(records.size());
+    ReportCapture replayedSecondHalf;
+    {
+        BookSnapshotReader snapshot(snapshotPath);
+        if(!check(snapshot.good() && snapshot.restore(restored), std::string(backend) + ": snapshot load failed: " + snapshot.error())) {
+            return false;
+        }
+        BinaryOrderReader journal(journalPath);
+        if(!check(journal.good(), std::string(backend) + ": journal read failed: " + journal.error())) {
+            return false;
+        }
+        bool isPassed = check(snapshot.header().m_requestCount == half, std::string(backend) + ": snapshot request count");
+        isPassed &= check(journal.firstRequest() == half && journal.records().size() == records.size() - half,
+                          std::string(backend) + ": journal doesn't continue the snapshot");
+        for(const BinaryOrderRecord& record : journal.records()) {
+            BookOrder order = record.toOrder();
+            restored.tryExecute(order);
+            replayedSecondHalf.reporter().report(restored.fills());
+        }
+        if(!isPassed) {
+            return false;
+        }
+    }
+    fs::remove(snapshotPath);
+    fs::remove(journalPath);
+
+    const std::vector<BinaryOrderRecord> liveBook = flatten(live);
+    const std::string liveTrades = liveSecondHalf.text();
+    bool isPassed = check(!liveBook.empty() && !liveTrades.empty(), std::string(backend) + ": the workload left no book or traded nothing");
+    isPassed &= check(isSameBook(flatten(restored), liveBook), std::string(backend) + ": restored and replayed book differs from the live one");
+    isPassed &= check(replayedSecondHalf.text() == liveTrades, std::string(backend) + ": replayed trades differ from the live ones");
+    std::cout << backend << ": snapshot after " << half << " requests, " << records.size() - half << " journaled, "
+              << liveBook.size() << " resting orders" << std::endl;
+    return isPassed;
+}
+
+bool testSnapshotReplay(const fs::path& directory) {
+    bool isPassed = checkSnapshotReplay<OrderPool<std::map<unsigned, OrderLevel, std::greater<unsigned>>, std::map<unsigned, OrderLevel>>>("std_map", directory);
+    isPassed &= checkSnapshotReplay<OrderPool<PriceLadder<OrderLevel, std::greater<unsigned>>, PriceLadder<OrderLevel>>>("ladder", directory);
+    return isPassed;
+}
+
+bool testPrefixSum() {
+#if defined(__x86_64__)
+    if(!__builtin_cpu_supports("avx2")) {
+        std::cout << "prefix-sum: no AVX2 on this CPU, skipped" << std::endl;
+        return true;
+    }
+    std::mt19937_64 rng(SEED);
+    bool isPassed = true;
+    std::vector<std::uint64_t> lengths(70);
+    for(std::size_t i = 0; i < lengths.size(); ++i) {
+        lengths[i] = i;//every remainder of the 4-wide steps, empty input included
+    }
+    lengths.push_back(4096);
+    lengths.push_back(100003);
+    for(const std::uint64_t length : lengths) {
+        std::vector<std::uint64_t> in(length);
+        for(std::uint64_t& value : in) {
+            value = rng() % 1000000;
+        }
+        const std::uint64_t carry = rng() % 1000;
+        std::vector<std::uint64_t> scalar(length);
+        std::vector<std::uint64_t> avx2(length);
+        const std::uint64_t scalarTotal = Common::detail::prefixSumScalar(in.data(), scalar.data(), length, carry);
+        const std::uint64_t avx2Total = Common::detail::prefixSumAVX2(in.data(), avx2.data(), length, carry);
+        isPassed &= check(scalarTotal == avx2Total && scalar == avx2, "prefixSumAVX2 differs from prefixSumScalar over " + std::to_string(length) + " values");
+        std::vector<std::uint64_t> inPlace = in;
+        Common::inclusivePrefixSum(inPlace.data(), inPlace.data(), length);
+        Common::detail::prefixSumScalar(in.data(), scalar.data(), length, 0);
+        isPassed &= check(inPlace == scalar, "in-place inclusivePrefixSum differs over " + std::to_string(length) + " values");
+    }
+    std::cout << "prefix-sum: " << lengths.size() << " lengths up to " << lengths.back() << std::endl;
+    return isPassed;
+#else
+    std::cout << "prefix-sum: not an x86-64 build, skipped" << std::endl;
+    return true;
+#endif
+}
+
+int main(int argc, char* argv[]) {
+    const std::string_view test = (argc > 1) ? argv[1] : "";
+    const fs::path directory = (argc > 2) ? argv[2] : ".";
+    if(test == "backends") {
+        return testBackends() ? 0 : 1;
+    } else if(test == "snapshot-replay" && fs::is_directory(directory)) {
+        return testSnapshotReplay(directory) ? 0 : 1;
+    } else if(test == "prefix-sum") {
+        return testPrefixSum() ? 0 : 1;
+    }
+    std::cerr << "Usage: " << argv[0] << " <backends|snapshot-replay|prefix-sum> [scratch directory]\n";
+    return 1;
+}
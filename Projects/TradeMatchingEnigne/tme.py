@@ -11,9 +11,15 @@ def main():
 
     # Define flags
     parser.add_argument("-n", "--num", type=int, required=True, help="Number of orders (integer)")
-    parser.add_argument("-m", "--map", choices=["std_map", "btree_map"], required=True, help="Map type")
+    parser.add_argument("-m", "--map", choices=["std_map", "btree_map", "ladder"], required=True, help="Map type")
     parser.add_argument("-d", "--dbg", action="store_true", help="Enable debug mode")
     parser.add_argument("-g", "--gen",action="store_true", help="Enable input generation")
+    parser.add_argument("-i", "--input", choices=["stream", "mmap"], default="stream", help="Input reading mode")
+    parser.add_argument("-s", "--shards", type=int, default=0, help="Number of matching shards, input lines start with an instrument symbol")
+    parser.add_argument("-p", "--pipeline", action="store_true", help="Parse, match and report on separate threads")
+    parser.add_argument("-c", "--first-core", type=int, default=-1, help="Core of the first shard thread, -1 disables pinning")
+    parser.add_argument("--seed", type=int, default=1, help="Seed of the generated input")
+    parser.add_argument("--profile", choices=["balanced", "passive", "aggressive", "bursty"], default="balanced", help="Workload profile of the generated input")
     parser.add_argument("-b", "--build", action="store_true", help="Force build (always run build.sh)")
 
     args = parser.parse_args()
@@ -54,8 +60,17 @@ def main():
         str(args.num),
         args.map,
         "1" if args.dbg else "0",
-        "1" if args.gen else "0"
+        "1" if args.gen else "0",
+        f"--input={args.input}"
     ]
+    if args.gen:
+        cmd += [f"--seed={args.seed}", f"--profile={args.profile}"]
+    if args.shards > 0:
+        cmd.append(f"--shards={args.shards}")
+    if args.pipeline:
+        cmd.append("--pipeline=on")
+    if args.shards > 0 or args.pipeline:
+        cmd.append(f"--first-core={args.first_core}")
 
     # Run the executable
     print(f"--- Running: {' '.join(cmd)} ---")
@@ -0,0 +1,95 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "BinaryOrderStream.h"
+#include "InputReader.h"
+#include "LineParser.h"
+#include "LineSplitter.h"
+#include "TraderRegistry.h"
+
+//Converts request files between the text grammar and the binary order stream.
+//Every text line becomes one record, so order ids derived from line numbers are kept as explicit ids.
+//Lines are split and parsed like the engine's mmap input does, named traders are interned and their names written to
+//<output>.traders, which the engine and to-text load back.
+int textToBinary(const std::string& inFile, const std::string& outFile) {
+    Common::InputReader reader(inFile);
+    if(!reader.good()) {
+        std::cerr << "Could not open input: " << inFile << "\n";
+        return 1;
+    }
+    BinaryOrderWriter writer(outFile);
+    TraderRegistry traders;
+    LineParser parser(&traders);
+    auto newlines = std::make_unique<std::uint32_t[]>(Common::LINE_SCAN_CHUNK_SIZE);
+    std::string_view block;
+    while(reader.nextBlock(block)) {
+        Common::forEachLine(block, newlines.get(),
+            [&](const char* lineBegin, const char* lineEnd) { writer.append(BinaryOrderRecord::fromOrder(parser.process(lineBegin, lineEnd))); },
+            []() {});
+    }
+    writer.close();
+    std::string error;
+    if(!saveTraderNames(outFile, traders, error)) {
+        std::cerr << "Could not save the trader names: " << error << "\n";
+        return 1;
+    }
+    std::cout << "Converted " << writer.count() << " records with " << traders.size() << " named traders into " << outFile << std::endl;
+    return 0;
+}
+
+int binaryToText(const std::string& inFile, const std::string& outFile) {
+    BinaryOrderReader reader(inFile);
+    if(!reader.good()) {
+        std::cerr << "Could not load binary input: " << reader.error() << "\n";
+        return 1;
+    }
+    TraderRegistry traders;
+    std::string error;
+    if(!loadTraderNames(inFile, traders, error)) {
+        std::cerr << "Could not load the trader names: " << error << "\n";
+        return 1;
+    }
+    std::ofstream ofstr(outFile);
+    for(const BinaryOrderRecord& record : reader.records()) {
+        if(record.m_side != 'B' && record.m_side != 'S' && record.m_side != 'C' && record.m_side != 'M') {
+            ofstr << '\n';//unparsable line, kept to preserve line numbering
+            continue;
+        }
+        const std::string_view name = TraderRegistry::isInterned(record.m_traderId) ? traders.name(record.m_traderId) : std::string_view{};
+        if(name.empty()) {
+            ofstr << record.m_traderId;
+        } else {
+            ofstr << name;
+        }
+        ofstr << " " << record.m_side;
+        if(record.m_side == 'C') {
+            ofstr << " " << record.m_orderId;
+        } else if(record.m_side == 'M') {
+            ofstr << " " << record.m_orderId << " " << record.m_quantity << " " << record.m_price;
+        } else {
+            ofstr << " " << record.m_quantity << " " << record.m_price;
+        }
+        ofstr << '\n';
+    }
+    std::cout << "Converted " << reader.records().size() << " records into " << outFile << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if(argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <to-binary|to-text> <input file> <output file>\n";
+        return 1;
+    }
+    const std::string_view direction = argv[1];
+    if(direction == "to-binary") {
+        return textToBinary(argv[2], argv[3]);
+    } else if(direction == "to-text") {
+        return binaryToText(argv[2], argv[3]);
+    }
+    std::cerr << "Unknown conversion: " << direction << "\n";
+    return 2;
+}
@@ -0,0 +1,58 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "WorkloadGenerator.h"
+
+//Streams a seeded workload into a text or binary request file, in constant memory and on several threads.
+int main(int argc, char* argv[]) {
+    if(argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <number of requests, at most 2^32 - 1> <output file> [--format=text|binary] [--seed=<N>]"
+                  << " [--profile=balanced|passive|aggressive|bursty] [--threads=<N>] [--symbols=<N>]\n";
+        return 1;
+    }
+    const std::uint64_t count = std::strtoull(argv[1], nullptr, 10);
+    const std::string outFile = argv[2];
+    bool isBinary = false;
+    std::uint64_t seed = 1;
+    std::string profileName = "balanced";
+    unsigned threads = 1;
+    unsigned symbols = 0;
+    for(int i = 3; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const auto eqPos = arg.find('=');
+        const std::string_view key = arg.substr(0, eqPos);
+        const std::string value(eqPos == std::string_view::npos ? std::string_view{} : arg.substr(eqPos + 1));
+        if(key == "--format" && (value == "text" || value == "binary")) {
+            isBinary = (value == "binary");
+        } else if(key == "--seed" && !value.empty()) {
+            seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if(key == "--profile" && !value.empty()) {
+            profileName = value;
+        } else if(key == "--threads" && !value.empty()) {
+            threads = std::atoi(value.c_str());
+        } else if(key == "--symbols" && !value.empty()) {
+            symbols = std::atoi(value.c_str());
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+    WorkloadProfile profile;
+    if(!WorkloadProfile::byName(profileName, profile)) {
+        std::cerr << "Unknown workload profile: " << profileName << "\n";
+        return 1;
+    }
+    profile.m_symbolCount = symbols;
+    const auto start = std::chrono::steady_clock::now();
+    WorkloadWriter writer(profile, seed);
+    if(!writer.write(outFile, count, isBinary, threads)) {
+        return 1;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Generated " << count << " requests into " << outFile << " in " << elapsed.count() << " s("
+              << static_cast<double>(count) / elapsed.count() << " requests/s)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ExecOutcome.h"
+#include "GatewayProtocol.h"
+#include "LatencyHistogram.h"
+#include "Logger.h"
+#include "SocketUtils.h"
+#include "WorkloadGenerator.h"
+
+//Load-generating client of the TCP order gateway(TradeMatchingEngine --gateway=<port>).
+//Every connection streams its own seeded workload with at most --window requests in flight, optionally paced to a total
+//--rate of requests per second, and measures the round trip from sending a request to receiving its acknowledgement.
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t CLIENT_BUFFER_SIZE = 256 * 1024;
+constexpr int MAX_EVENTS = 64;
+
+struct Connection {
+    int                                             m_fd = -1;
+    std::unique_ptr<WorkloadGenerator>              mp_generator;
+    unsigned                                        m_traderOffset = 0;//connections trade for disjoint trader ranges
+    std::unordered_map<std::uint64_t, std::uint64_t> m_engineIds;//generator order id -> engine order id, for 'C'/'M'
+    std::unique_ptr<char[]>                         mp_send = std::make_unique<char[]>(CLIENT_BUFFER_SIZE);
+    std::size_t                                     m_sendSize = 0;
+    std::unique_ptr<char[]>                         mp_receive = std::make_unique<char[]>(CLIENT_BUFFER_SIZE);
+    std::size_t                                     m_receiveSize = 0;
+    std::uint64_t                                   m_sent = 0;
+    std::uint64_t                                   m_acked = 0;
+    bool                                            m_isConnected = false;
+};
+
+struct Totals {
+    Common::LatencyHistogram    m_roundTrip;
+    std::uint64_t               m_fills = 0;
+    std::uint64_t               m_outcomes[static_cast<std::size_t>(ExecOutcome::COUNT)] = {};
+};
+
+std::uint64_t nowNs() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+
+//false once the connection is unusable
+bool flushSend(Connection& connection) {
+    std::size_t sent = 0;
+    while(sent < connection.m_sendSize) {
+        const ssize_t rc = ::send(connection.m_fd, connection.mp_send.get() + sent, connection.m_sendSize - sent, MSG_NOSIGNAL);
+        if(rc < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            std::cerr << "send() failed. errno:" << strerror(errno) << "\n";
+            return false;
+        }
+        sent += static_cast<std::size_t>(rc);
+    }
+    connection.m_sendSize -= sent;
+    if(connection.m_sendSize && sent) {
+        std::memmove(connection.mp_send.get(), connection.mp_send.get() + sent, connection.m_sendSize);
+    }
+    return true;
+}
+
+void queueRequests(Connection& connection, std::uint64_t count) {
+    const std::uint64_t timestamp = nowNs();
+    for(std::uint64_t i = 0; i < count; ++i) {
+        BinaryOrderRecord record = connection.mp_generator->next();
+        record.m_traderId += connection.m_traderOffset;
+        if(record.m_side == 'C' || record.m_side == 'M') {//unknown targets(not acknowledged or not resting) go out as 0 and are ignored
+            const auto it = connection.m_engineIds.find(record.m_orderId);
+            record.m_orderId = (it != connection.m_engineIds.end()) ? it->second : 0;
+        }
+        record.m_timestamp = timestamp;
+        std::memcpy(connection.mp_send.get() + connection.m_sendSize, &record, sizeof(record));
+        connection.m_sendSize += sizeof(record);
+    }
+    connection.m_sent += count;
+}
+
+//false once the connection is closed
+bool receiveReports(Connection& connection, Totals& totals) {
+    while(true) {
+        const ssize_t rc = ::recv(connection.m_fd, connection.mp_receive.get() + connection.m_receiveSize, CLIENT_BUFFER_SIZE - connection.m_receiveSize, 0);
+        if(rc <= 0) {
+            if(rc < 0 && errno == EINTR) {
+                continue;
+            }
+            if(rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            }
+            std::cerr << "Gateway closed the connection\n";
+            return false;
+        }
+        connection.m_receiveSize += static_cast<std::size_t>(rc);
+        const std::uint64_t now = nowNs();
+        const std::size_t count = connection.m_receiveSize / sizeof(ExecutionReport);
+        for(std::size_t i = 0; i < count; ++i) {
+            ExecutionReport report;
+            std::memcpy(&report, connection.mp_receive.get() + i * sizeof(ExecutionReport), sizeof(report));
+            if(report.m_type == EXEC_REPORT_FILL) {
+                ++totals.m_fills;
+                continue;
+            }
+            totals.m_roundTrip.record(now - report.m_timestamp);
+            ++totals.m_outcomes[std::min<std::size_t>(report.m_outcome, static_cast<std::size_t>(ExecOutcome::COUNT) - 1)];
+            const auto outcome = static_cast<ExecOutcome>(report.m_outcome);
+            if(outcome == ExecOutcome::Rested || outcome == ExecOutcome::PartiallyFilled) {
+                connection.m_engineIds[report.m_clientOrderId] = report.m_orderId;
+            }
+            ++connection.m_acked;
+        }
+        const std::size_t consumed = count * sizeof(ExecutionReport);
+        connection.m_receiveSize -= consumed;
+        if(connection.m_receiveSize) {
+            std::memmove(connection.mp_receive.get(), connection.mp_receive.get() + consumed, connection.m_receiveSize);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if(argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <gateway ip> <port> [--connections=<N>] [--orders=<per connection>] [--window=<in flight per connection>]"
+                  << " [--rate=<requests/s in total, 0 unpaced>] [--seed=<N>] [--profile=balanced|passive|aggressive|bursty]\n";
+        return 1;
+    }
+    const std::string host = argv[1];
+    const int port = std::atoi(argv[2]);
+    unsigned connectionCount = 1;
+    std::uint64_t ordersPerConnection = 100000;
+    std::uint64_t window = 1;
+    std::uint64_t rate = 0;
+    std::uint64_t seed = 1;
+    std::string profileName = "balanced";
+    for(int i = 3; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const auto eqPos = arg.find('=');
+        const std::string_view key = arg.substr(0, eqPos);
+        const std::string value(eqPos == std::string_view::npos ? std::string_view{} : arg.substr(eqPos + 1));
+        if(key == "--connections" && !value.empty()) {
+            connectionCount = std::atoi(value.c_str());
+        } else if(key == "--orders" && !value.empty()) {
+            ordersPerConnection = std::strtoull(value.c_str(), nullptr, 10);
+        } else if(key == "--window" && !value.empty()) {
+            window = std::strtoull(value.c_str(), nullptr, 10);
+        } else if(key == "--rate" && !value.empty()) {
+            rate = std::strtoull(value.c_str(), nullptr, 10);
+        } else if(key == "--seed" && !value.empty()) {
+            seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if(key == "--profile" && !value.empty()) {
+            profileName = value;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+    WorkloadProfile profile;
+    if(!WorkloadProfile::byName(profileName, profile)) {
+        std::cerr << "Unknown workload profile: " << profileName << "\n";
+        return 1;
+    }
+    if(!connectionCount || !ordersPerConnection || !window || port <= 0) {
+        std::cerr << "Connections, orders, window and port must be positive\n";
+        return 1;
+    }
+    window = std::min<std::uint64_t>(window, CLIENT_BUFFER_SIZE / sizeof(BinaryOrderRecord));//a whole window fits the send buffer
+
+    Common::Logger logger("tme_loadgen.log");
+    const ZipfSampler traders(profile.m_traderCount, profile.m_zipfExponent);
+    const int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<Connection> connections(connectionCount);
+    for(unsigned c = 0; c < connectionCount; ++c) {
+        Connection& connection = connections[c];
+        connection.m_fd = Common::createSocket(logger, Common::SocketCfg{host, "", port, false, false, false});
+        connection.mp_generator = std::make_unique<WorkloadGenerator>(profile, traders, WorkloadWriter::subSeed(seed, c), 1, 0);
+        connection.m_traderOffset = c * profile.m_traderCount;
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        event.data.u32 = c;
+        if(connection.m_fd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, connection.m_fd, &event) != 0) {
+            std::cerr << "Could not connect to " << host << ":" << port << "\n";
+            return 1;
+        }
+    }
+
+    //connections are non-blocking, the first EPOLLOUT tells the connection is established
+    for(unsigned connected = 0; connected < connectionCount;) {
+        epoll_event events[MAX_EVENTS];
+        const int count = epoll_wait(epollFd, events, MAX_EVENTS, 1000);
+        if(count <= 0) {
+            std::cerr << "Timed out connecting to " << host << ":" << port << "\n";
+            return 1;
+        }
+        for(int i = 0; i < count; ++i) {
+            Connection& connection = connections[events[i].data.u32];
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(connection.m_fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            if(error || (events[i].events & (EPOLLERR | EPOLLHUP))) {
+                std::cerr << "Could not connect to " << host << ":" << port << ": " << strerror(error) << "\n";
+                return 1;
+            }
+            if(!connection.m_isConnected && (events[i].events & EPOLLOUT)) {
+                connection.m_isConnected = true;
+                ++connected;
+            }
+        }
+    }
+
+    Totals totals;
+    const double perConnectionRate = static_cast<double>(rate) / connectionCount;
+    const auto start = Clock::now();
+    std::uint64_t totalAcked = 0;
+    const std::uint64_t totalOrders = ordersPerConnection * connectionCount;
+    while(totalAcked < totalOrders) {
+        const double elapsedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        bool isPaced = false;
+        for(Connection& connection : connections) {
+            std::uint64_t sendable = std::min(window - (connection.m_sent - connection.m_acked), ordersPerConnection - connection.m_sent);
+            if(rate) {
+                const auto due = std::min(static_cast<std::uint64_t>(elapsedSeconds * perConnectionRate) + 1, ordersPerConnection);
+                sendable = std::min(sendable, due > connection.m_sent ? due - connection.m_sent : 0);
+                isPaced |= connection.m_sent < ordersPerConnection;
+            }
+            sendable = std::min<std::uint64_t>(sendable, (CLIENT_BUFFER_SIZE - connection.m_sendSize) / sizeof(BinaryOrderRecord));
+            if(sendable) {
+                queueRequests(connection, sendable);
+            }
+            if(connection.m_sendSize && !flushSend(connection)) {
+                return 1;
+            }
+        }
+        epoll_event events[MAX_EVENTS];
+        const int count = epoll_wait(epollFd, events, MAX_EVENTS, isPaced ? 0 : 10);
+        for(int i = 0; i < count; ++i) {
+            Connection& connection = connections[events[i].data.u32];
+            const std::uint64_t ackedBefore = connection.m_acked;
+            if((events[i].events & EPOLLIN) && !receiveReports(connection, totals)) {
+                return 1;
+            }
+            totalAcked += connection.m_acked - ackedBefore;
+        }
+    }
+    const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    std::cout << "Connections: " << connectionCount << " window: " << window << " rate: " << (rate ? std::to_string(rate) : std::string("unpaced"))
+              << " requests: " << totalAcked << " fills received: " << totals.m_fills << "\n";
+    std::cout << "Sustained: " << static_cast<double>(totalAcked) / elapsed.count() << " requests/s over " << elapsed.count() << " s\n";
+    for(std::size_t i = 0; i < static_cast<std::size_t>(ExecOutcome::COUNT); ++i) {
+        if(totals.m_outcomes[i]) {
+            std::cout << outcomeName(static_cast<ExecOutcome>(i)) << ": " << totals.m_outcomes[i] << "\n";
+        }
+    }
+    totals.m_roundTrip.print(std::cout, "Round trip(ns)");
+    for(Connection& connection : connections) {
+        ::close(connection.m_fd);
+    }
+    ::close(epollFd);
+    return 0;
+}
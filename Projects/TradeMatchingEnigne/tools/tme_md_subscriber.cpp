@@ -0,0 +1,305 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "LatencyHistogram.h"
+#include "Logger.h"
+#include "MarketDataProtocol.h"
+#include "MarketDataPublisher.h"
+#include "SocketUtils.h"
+#include "TimeUtils.h"
+
+//Market data subscriber of the engine(TradeMatchingEngine --market-data=<group>:<port>), for loopback checks.
+//It may join at any time: incremental packets are buffered until a snapshot arrives, the book is loaded from the snapshot
+//and the buffered packets after its book sequence are applied. A sequence gap drops back to waiting for the next snapshot.
+//Once in sync, every later snapshot is compared with the rebuilt book when the book reaches the snapshot's sequence,
+//the last one being the final snapshot the engine takes from its own book when it stops.
+
+constexpr std::size_t MAX_BUFFERED_PACKETS = 1 << 16;
+constexpr int RECEIVE_BUFFER_BYTES = 8 * 1024 * 1024;
+constexpr int POLL_TIMEOUT_MS = 100;
+constexpr Common::Nanos FINAL_CATCH_UP_TIMEOUT = Common::NANOS_TO_SECS;
+
+struct Level {
+    std::uint64_t   m_quantity;
+    std::uint32_t   m_orderCount;
+
+    bool operator==(const Level&) const = default;
+};
+
+struct Book {
+    std::map<unsigned, Level, std::greater<unsigned>>   m_bids;
+    std::map<unsigned, Level>                           m_asks;
+
+    void apply(const LevelUpdate& update) {
+        if(update.m_side == 'S') {
+            applyToSide(m_asks, update);
+        } else {
+            applyToSide(m_bids, update);
+        }
+    }
+
+    template<class Side>
+    static void applyToSide(Side& side, const LevelUpdate& update) {
+        if(update.m_orderCount) {
+            side.insert_or_assign(update.m_price, Level{update.m_quantity, update.m_orderCount});
+        } else {
+            side.erase(update.m_price);
+        }
+    }
+
+    bool operator==(const Book&) const = default;
+};
+
+struct Snapshot {
+    Book            m_book;
+    std::uint64_t   m_bookSequence = 0;
+    std::uint64_t   m_nextPacket = 0;//snapshot channel sequence of the next packet of this snapshot
+    bool            m_isFinal = false;
+};
+
+class Subscriber {
+public:
+    void onIncremental(const MarketDataHeader& header, const LevelUpdate* updates) {
+        ++m_incrementalCount;
+        m_updateCount += header.m_count;
+        if(!m_isSynced) {
+            buffer(header, updates);
+            return;
+        }
+        if(header.m_sequence <= m_applied) {
+            return;//already covered by the snapshot the book was loaded from
+        }
+        if(header.m_sequence != m_applied + 1) {
+            ++m_gapCount;
+            m_isSynced = false;
+            m_hasPending = false;
+            buffer(header, updates);
+            return;
+        }
+        for(std::uint16_t i = 0; i < header.m_count; ++i) {
+            m_book.apply(updates[i]);
+        }
+        m_applied = header.m_sequence;
+        checkPending();
+    }
+
+    void onSnapshot(const MarketDataHeader& header, const LevelUpdate* updates) {
+        ++m_snapshotPacketCount;
+        if(header.m_flags & MD_FLAG_FIRST) {
+            m_collecting = Snapshot{Book{}, header.m_bookSequence, header.m_sequence, (header.m_flags & MD_FLAG_FINAL) != 0};
+            m_isCollecting = true;
+        }
+        if(!m_isCollecting || header.m_sequence != m_collecting.m_nextPacket) {
+            m_isCollecting = false;//a lost packet spoils the snapshot, wait for the next one
+            return;
+        }
+        ++m_collecting.m_nextPacket;
+        for(std::uint16_t i = 0; i < header.m_count; ++i) {
+            m_collecting.m_book.apply(updates[i]);
+        }
+        if(header.m_flags & MD_FLAG_LAST) {
+            m_isCollecting = false;
+            onCompleteSnapshot();
+        }
+    }
+
+    [[nodiscard]] bool isDone() const noexcept { return m_isDone; }
+    [[nodiscard]] bool isFinalMatched() const noexcept { return m_isFinalMatched; }
+    [[nodiscard]] bool hasFinal() const noexcept { return m_finalTime != 0; }
+    [[nodiscard]] Common::Nanos finalTime() const noexcept { return m_finalTime; }
+
+    void print(std::ostream& os) const {
+        os << "Subscriber: " << m_incrementalCount << " incremental packets(" << m_updateCount << " level updates), "
+           << m_snapshotPacketCount << " snapshot packets, " << m_gapCount << " sequence gaps, " << m_recoveryCount
+           << " snapshot recoveries, snapshot checks: " << m_matchCount << " matched, " << m_mismatchCount << " mismatched, "
+           << m_skippedCount << " skipped" << std::endl;
+        if(m_isFinalRecovered) {
+            os << "Out of sync when the engine stopped, the final book was loaded from its snapshot and not checked" << std::endl;
+        } else if(m_isDone) {
+            os << "Final book(" << m_book.m_bids.size() << " bid levels, " << m_book.m_asks.size() << " ask levels) "
+               << (m_isFinalMatched ? "matches the engine" : "DOES NOT match the engine") << std::endl;
+        } else if(hasFinal()) {
+            os << "Final snapshot received, but the book never reached its sequence " << m_pending.m_bookSequence
+               << "(last applied " << m_applied << ")" << std::endl;
+        } else {
+            os << "No final snapshot received" << std::endl;
+        }
+    }
+
+private:
+    void buffer(const MarketDataHeader& header, const LevelUpdate* updates) {
+        if(m_buffered.size() == MAX_BUFFERED_PACKETS) {
+            m_buffered.erase(m_buffered.begin());
+        }
+        m_buffered.insert_or_assign(header.m_sequence, std::vector<LevelUpdate>(updates, updates + header.m_count));
+    }
+
+    void onCompleteSnapshot() {
+        if(m_collecting.m_isFinal) {
+            m_finalTime = Common::getCurrentNanos();
+        }
+        if(m_isSynced) {
+            m_pending = std::move(m_collecting);
+            m_hasPending = true;
+            checkPending();
+            return;
+        }
+        //recovery: load the snapshot, then the buffered incremental packets after it
+        m_book = std::move(m_collecting.m_book);
+        m_applied = m_collecting.m_bookSequence;
+        m_isSynced = true;
+        ++m_recoveryCount;
+        if(m_collecting.m_isFinal) {//nothing left to check it against
+            m_isFinalRecovered = true;
+            m_isDone = true;
+            return;
+        }
+        std::map<std::uint64_t, std::vector<LevelUpdate>> buffered;
+        buffered.swap(m_buffered);
+        for(const auto& [sequence, updates] : buffered) {
+            const MarketDataHeader header{sequence, sequence, 0, static_cast<std::uint16_t>(updates.size()), MD_INCREMENTAL, 0, 0};
+            onIncremental(header, updates.data());
+        }
+        m_incrementalCount -= buffered.size();//counted when they arrived
+        for(const auto& entry : buffered) {
+            m_updateCount -= entry.second.size();
+        }
+    }
+
+    void checkPending() {
+        if(!m_hasPending || m_applied < m_pending.m_bookSequence) {
+            return;
+        }
+        m_hasPending = false;
+        if(m_applied > m_pending.m_bookSequence) {
+            ++m_skippedCount;//read after newer incremental packets, the book has moved on
+            return;
+        }
+        const bool isMatched = (m_book == m_pending.m_book);
+        ++(isMatched ? m_matchCount : m_mismatchCount);
+        if(m_pending.m_isFinal) {
+            m_isFinalMatched = isMatched;
+            m_isDone = true;
+        }
+    }
+
+    Book                                                m_book;
+    bool                                                m_isSynced = false;
+    std::uint64_t                                       m_applied = 0;//last incremental packet in m_book
+    std::map<std::uint64_t, std::vector<LevelUpdate>>   m_buffered;//incremental packets waiting for a snapshot
+    Snapshot                                            m_collecting;
+    bool                                                m_isCollecting = false;
+    Snapshot                                            m_pending;//complete, waits for m_book to reach its sequence
+    bool                                                m_hasPending = false;
+    bool                                                m_isDone = false;
+    bool                                                m_isFinalMatched = false;
+    bool                                                m_isFinalRecovered = false;
+    Common::Nanos                                       m_finalTime = 0;
+    std::uint64_t                                       m_incrementalCount = 0;
+    std::uint64_t                                       m_updateCount = 0;
+    std::uint64_t                                       m_snapshotPacketCount = 0;
+    std::uint64_t                                       m_gapCount = 0;
+    std::uint64_t                                       m_recoveryCount = 0;
+    std::uint64_t                                       m_matchCount = 0;
+    std::uint64_t                                       m_mismatchCount = 0;
+    std::uint64_t                                       m_skippedCount = 0;
+};
+
+int openChannel(Common::Logger& logger, const std::string& group, int port) {
+    const int fd = Common::createSocket(logger, Common::SocketCfg{group, "", port, true, true, false});
+    if(fd < 0 || !Common::join(fd, group)) {
+        std::cerr << "Could not join " << group << ":" << port << ". errno:" << strerror(errno) << "\n";
+        return -1;
+    }
+    const int bytes = RECEIVE_BUFFER_BYTES;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));//best effort, capped by net.core.rmem_max
+    return fd;
+}
+
+int main(int argc, char* argv[]) {
+    MarketDataConfig config;
+    if(argc < 2 || !parseMarketDataAddress(argv[1], config)) {
+        std::cerr << "Usage: " << argv[0] << " <group>:<port> [--idle-timeout=<seconds without packets, 0 waits forever>]\n";
+        return 1;
+    }
+    unsigned idleTimeout = 30;
+    for(int i = 2; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const auto eqPos = arg.find('=');
+        const std::string_view key = arg.substr(0, eqPos);
+        const std::string value(eqPos == std::string_view::npos ? std::string_view{} : arg.substr(eqPos + 1));
+        if(key == "--idle-timeout" && !value.empty()) {
+            idleTimeout = std::atoi(value.c_str());
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    Common::Logger logger("tme_md_subscriber.log");
+    pollfd fds[2] = {{openChannel(logger, config.m_group, config.m_port), POLLIN, 0},
+                     {openChannel(logger, config.m_group, config.m_port + 1), POLLIN, 0}};
+    if(fds[0].fd < 0 || fds[1].fd < 0) {
+        return 1;
+    }
+    std::cerr << "Subscribed to " << config.m_group << ":" << config.m_port << " and snapshots on port " << config.m_port + 1 << std::endl;
+
+    Subscriber subscriber;
+    Common::LatencyHistogram oneWay;
+    alignas(8) char packet[MD_MAX_PACKET_SIZE];
+    std::uint64_t packetCount = 0;
+    Common::Nanos firstPacket = 0;
+    Common::Nanos lastPacket = Common::getCurrentNanos();
+    while(!subscriber.isDone()) {
+        const Common::Nanos now = Common::getCurrentNanos();
+        if(idleTimeout && now - lastPacket > static_cast<Common::Nanos>(idleTimeout) * Common::NANOS_TO_SECS) {
+            std::cerr << "No packets for " << idleTimeout << " s, giving up\n";
+            break;
+        }
+        if(subscriber.hasFinal() && now - subscriber.finalTime() > FINAL_CATCH_UP_TIMEOUT) {
+            break;//the incremental packets the final snapshot covers were lost
+        }
+        if(poll(fds, 2, POLL_TIMEOUT_MS) <= 0) {
+            continue;
+        }
+        for(const pollfd& channel : fds) {
+            ssize_t size;
+            while(!subscriber.isDone() && (size = ::recv(channel.fd, packet, sizeof(packet), 0)) >= static_cast<ssize_t>(sizeof(MarketDataHeader))) {
+                lastPacket = Common::getCurrentNanos();
+                firstPacket = firstPacket ? firstPacket : lastPacket;
+                ++packetCount;
+                MarketDataHeader header;
+                std::memcpy(&header, packet, sizeof(header));
+                if(static_cast<std::size_t>(size) != sizeof(header) + header.m_count * sizeof(LevelUpdate)) {
+                    continue;//not ours
+                }
+                oneWay.record(static_cast<std::uint64_t>(lastPacket - static_cast<Common::Nanos>(header.m_sendTime)));
+                const LevelUpdate* updates = reinterpret_cast<const LevelUpdate*>(packet + sizeof(header));
+                if(header.m_type == MD_INCREMENTAL) {
+                    subscriber.onIncremental(header, updates);
+                } else if(header.m_type == MD_SNAPSHOT) {
+                    subscriber.onSnapshot(header, updates);
+                }
+            }
+        }
+    }
+    ::close(fds[0].fd);
+    ::close(fds[1].fd);
+
+    const double seconds = static_cast<double>(lastPacket - firstPacket) / static_cast<double>(Common::NANOS_TO_SECS);
+    std::cout << "Received " << packetCount << " packets, " << (seconds > 0 ? static_cast<double>(packetCount) / seconds : 0.0) << " packets/s" << std::endl;
+    subscriber.print(std::cout);
+    oneWay.print(std::cout, "One-way latency(ns), packet sent to received");
+    return subscriber.isDone() && subscriber.isFinalMatched() ? 0 : 1;
+}